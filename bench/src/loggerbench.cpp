@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "nulloutputter.h"
+#include <benchmark/benchmark.h>
+#include <sharklog/logger.h>
+#include <sharklog/loggerstream.h>
+#include <sharklog/functrace.h>
+#include <sharklog/scopetimer.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	// logger with two null outputters that every thread shares
+	LoggerPtr nullLogger(const string &name)
+	{
+		auto log = Logger::logger(name);
+		if (log->outputters().empty())
+		{
+			log->addOutputter(make_shared<NullOutputter>());
+			log->addOutputter(make_shared<NullOutputter>());
+		}
+		return log;
+	}
+
+#if defined(_MSC_VER)
+	__declspec(noinline)
+#else
+	__attribute__((noinline))
+#endif
+	void tracedFunction(LoggerPtr log)
+	{
+		SHARKLOG_FUNCTRACE(log);
+	}
+
+	void timedFunction(const LoggerPtr &log)
+	{
+		SHARKLOG_SCOPE_TIMER(log, "bench.scope");
+		benchmark::ClobberMemory();
+	}
+}
+
+// a debug message on a warn logger, the message must never be built
+static void BM_DisabledMacro(benchmark::State &state)
+{
+	auto log = nullLogger("bench.disabled");
+	log->setLevel(Level::warn());
+
+	int i = 0;
+	for (auto _ : state)
+	{
+		SHARKLOG_DEBUG(log, "value " + to_string(++i));
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(BM_DisabledMacro);
+
+// Logger::logger() on a registry holding range(0) loggers, random keys in different case
+static void BM_LoggerLookup(benchmark::State &state)
+{
+	const unsigned int size = (unsigned int)state.range(0);
+	for (unsigned int i=0;i<size;++i)
+		Logger::logger("bench.lookup.Module" + to_string(i));
+
+	vector<string> keys;
+	mt19937 rng(42);
+	uniform_int_distribution<unsigned int> dist(0, size - 1);
+	for (unsigned int i=0;i<4096;++i)
+		keys.push_back("BENCH.LOOKUP.module" + to_string(dist(rng)));
+
+	unsigned int i = 0;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(Logger::logger(keys[i++ & 4095]));
+}
+BENCHMARK(BM_LoggerLookup)->RangeMultiplier(10)->Range(10, 10000);
+
+// build a message with LoggerStream and hand it to the logger
+static void BM_LoggerStream(benchmark::State &state)
+{
+	auto log = nullLogger("bench.stream");
+
+	int i = 0;
+	for (auto _ : state)
+	{
+		LoggerStream(log, Level::info()) << "order " << ++i << " buy at " << 100.25 << SHARKLOG_END;
+	}
+}
+BENCHMARK(BM_LoggerStream);
+
+// FuncTrace enter and exit, range(0) is 0 when functrace is disabled on the logger
+static void BM_FuncTrace(benchmark::State &state)
+{
+	auto log = nullLogger(state.range(0) ? "bench.functrace.on" : "bench.functrace.off");
+	log->setLevel(state.range(0) ? Level::all() : Level::info());
+
+	for (auto _ : state)
+		tracedFunction(log);
+}
+BENCHMARK(BM_FuncTrace)->ArgName("enabled")->Arg(0)->Arg(1);
+
+// SHARKLOG_SCOPE_TIMER, range(0) is 0 when debug is disabled on the logger
+static void BM_ScopeTimer(benchmark::State &state)
+{
+	auto log = nullLogger(state.range(0) ? "bench.scope.on" : "bench.scope.off");
+	log->setLevel(state.range(0) ? Level::debug() : Level::info());
+
+	for (auto _ : state)
+		timedFunction(log);
+}
+BENCHMARK(BM_ScopeTimer)->ArgName("enabled")->Arg(0)->Arg(1);
+
+// Logger::log() from 1..N threads all on the same logger
+static void BM_LogThreads(benchmark::State &state)
+{
+	static auto log = nullLogger("bench.threads");
+	const string msg = "dispatch benchmark message";
+
+	for (auto _ : state)
+		log->log(Level::info(), msg);
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogThreads)->ThreadRange(1, 16)->UseRealTime();
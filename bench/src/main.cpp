@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Same as BENCHMARK_MAIN() but results also go to sharklog_bench.json
+ * unless --benchmark_out is given, so every run leaves something that can
+ * be compared with compare.py or loaded into a dashboard.
+ */
+int main(int argc, char **argv)
+{
+	vector<char *> args(argv, argv + argc);
+
+	bool hasOut = false;
+	for (int i=1;i<argc;++i)
+	{
+		if (!strncmp(argv[i], "--benchmark_out=", 16))
+			hasOut = true;
+	}
+
+	char out[] = "--benchmark_out=sharklog_bench.json";
+	char format[] = "--benchmark_out_format=json";
+	if (!hasOut)
+	{
+		args.push_back(out);
+		args.push_back(format);
+	}
+	args.push_back(nullptr);
+
+	int count = (int)args.size() - 1;
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+		return 1;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __nulloutputter_H
+#define __nulloutputter_H
+
+#include <sharklog/outputter.h>
+#include <string>
+#include <cstddef>
+
+/*!
+ * \brief Outputter that drops every record
+ *
+ * Only the dispatch through the logger is timed, nothing is formatted.
+ */
+class NullOutputter : public sharklog::Outputter
+{
+public:
+	bool open() override { return true; }
+	void writeLog(const sharklog::Level &, const std::string &loggerName, const std::string &logMessage, const sharklog::Location &) override
+	{
+		sink_ = loggerName.size() + logMessage.size();
+	}
+	void close() override { }
+	bool isOpen() const override { return true; }
+	bool isValid() const override { return true; }
+
+private:
+	// keeps the optimizer from throwing the call away
+	volatile std::size_t sink_ = 0;
+};
+
+#endif // __nulloutputter_H
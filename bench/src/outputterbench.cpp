@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <benchmark/benchmark.h>
+#include <sharklog/logger.h>
+#include <sharklog/fileoutputter.h>
+#include <sharklog/standardlayout.h>
+#include <memory>
+#include <string>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	const string message = "file benchmark message with an order id 123456 and some text";
+
+	// one logger and file per target, shared by every thread of a run
+	struct FileTarget
+	{
+		FileTarget(const string &name, const string &path)
+			: log(Logger::logger(name))
+			, fop(make_shared<FileOutputter>(path))
+		{
+			fop->setLayout(make_shared<StandardLayout>());
+			log->addOutputter(fop);
+
+			// the size of one record for the bytes/second counter
+			string record;
+			fop->layout()->formatRecord(record, Level::info(), log->name(), message, SHARKLOG_LOCATION);
+			recordSize = record.size();
+		}
+
+		~FileTarget()
+		{
+			log->removeOutputter(fop);
+			fop->close();
+		}
+
+		LoggerPtr log;
+		shared_ptr<FileOutputter> fop;
+		size_t recordSize;
+	};
+
+	// made in the Setup() of each run so all its threads see the same file
+	unique_ptr<FileTarget> target;
+
+	void openTarget(const char *path)
+	{
+		target.reset(new FileTarget("bench.file", path));
+		if (!target->fop->open())
+			target.reset();
+	}
+
+	void closeTarget(const char *path)
+	{
+		target.reset();
+		if (string(path) != "/dev/null")
+			remove(path);
+	}
+}
+
+// StandardLayout::formatRecord() for a range(0) byte message
+static void BM_StandardLayout(benchmark::State &state)
+{
+	StandardLayout layout;
+	const string msg(state.range(0), 'x');
+	const string name = "bench.layout";
+	auto loc = SHARKLOG_LOCATION;
+	string result;
+
+	for (auto _ : state)
+	{
+		result.clear();
+		layout.formatRecord(result, Level::info(), name, msg, loc);
+		benchmark::DoNotOptimize(result.data());
+	}
+
+	state.SetBytesProcessed(state.iterations() * result.size());
+}
+BENCHMARK(BM_StandardLayout)->RangeMultiplier(8)->Range(16, 1024);
+
+// Logger::log() into a FileOutputter at path, from 1..N threads
+static void BM_FileOutputter(benchmark::State &state, const char *path)
+{
+	if (!target)
+	{
+		state.SkipWithError((string("can't open ") + path).c_str());
+		return;
+	}
+
+	for (auto _ : state)
+		target->log->log(Level::info(), message);
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * target->recordSize);
+}
+BENCHMARK_CAPTURE(BM_FileOutputter, devnull, "/dev/null")
+	->Setup([](const benchmark::State &) { openTarget("/dev/null"); })
+	->Teardown([](const benchmark::State &) { closeTarget("/dev/null"); })
+	->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_FileOutputter, tmpfs, "/dev/shm/sharklog_bench.log")
+	->Setup([](const benchmark::State &) { openTarget("/dev/shm/sharklog_bench.log"); })
+	->Teardown([](const benchmark::State &) { closeTarget("/dev/shm/sharklog_bench.log"); })
+	->ThreadRange(1, 8)->UseRealTime();
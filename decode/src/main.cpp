@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <iostream>
+#include <memory>
+#include <sharklog/binarylogreader.h>
+#include <sharklog/standardlayout.h>
+#include <sharklog/patternlayout.h>
+#include <sharklog/recordcontext.h>
+
+using namespace std;
+using namespace sharklog;
+
+void usage();
+int decode(const std::string &filename, LayoutPtr layout);
+
+int main(int ac, char **av)
+{
+    LayoutPtr layout;
+    int first = 1;
+
+    if (ac > 1 && string(av[1]) == "--help")
+    {
+        usage();
+        return 0;
+    }
+
+    if (ac > 2 && string(av[1]) == "-p")
+    {
+        layout = make_shared<PatternLayout>(av[2]);
+        first = 3;
+    }
+    else
+        layout = make_shared<StandardLayout>();
+
+    if (first >= ac)
+    {
+        usage();
+        return 1;
+    }
+
+    for (auto i=first;i<ac;++i)
+    {
+        auto res = decode(av[i], layout);
+        if (res)
+            return res;
+    }
+
+    return 0;
+}
+
+int decode(const std::string &filename, LayoutPtr layout)
+{
+    BinaryLogReader reader(filename);
+    if (!reader.open())
+    {
+        cerr << filename << ": " << reader.error() << endl;
+        return 1;
+    }
+
+    BinaryLogReader::Record rec;
+    string text;
+    while (reader.next(rec))
+    {
+        // the layout takes the time and thread from the file
+        RecordContext::Scope pin(rec.context);
+        text.clear();
+        layout->formatRecord(text, rec.level, rec.loggerName, rec.message, rec.location);
+        cout << text;
+    }
+
+    if (!reader.error().empty())
+    {
+        cerr << filename << ": " << reader.error() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+void usage()
+{
+    cout << "sharklog-decode [options] file..." << endl << endl;
+    cout << "Prints binary log files from BinaryFileOutputter as text" << endl << endl;
+
+    cout << "   --help                 Shows this help" << endl;
+    cout << "   -p pattern             Format with a PatternLayout, i.e. \"%d %-5p [%c] %m%n\"" << endl;
+    cout << "                          instead of the StandardLayout" << endl;
+    cout << endl;
+}
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+using namespace std;
+
+const unsigned int Histogram::SubBucketBits;
+const unsigned int Histogram::SubBucketCount;
+const unsigned int Histogram::SubBucketHalf;
+const unsigned int Histogram::IndexCount;
+
+Histogram::Histogram()
+	: counts_(IndexCount, 0)
+{
+	reset();
+}
+
+void Histogram::add(const Histogram &other)
+{
+	for (unsigned int i=0;i<IndexCount;++i)
+		counts_[i] += other.counts_[i];
+
+	count_ += other.count_;
+	total_ += other.total_;
+	if (other.max_ > max_)
+		max_ = other.max_;
+	if (other.min_ < min_)
+		min_ = other.min_;
+}
+
+void Histogram::reset()
+{
+	fill(counts_.begin(), counts_.end(), 0);
+	count_ = 0;
+	total_ = 0;
+	min_ = numeric_limits<uint64_t>::max();
+	max_ = 0;
+}
+
+uint64_t Histogram::min() const
+{
+	return count_ ? min_ : 0;
+}
+
+double Histogram::mean() const
+{
+	return count_ ? (double)total_ / count_ : 0.0;
+}
+
+uint64_t Histogram::percentile(double percentile) const
+{
+	if (!count_)
+		return 0;
+	if (percentile >= 100.0)
+		return max_;
+
+	auto target = (uint64_t)ceil(percentile / 100.0 * count_);
+	if (target < 1)
+		target = 1;
+
+	uint64_t seen = 0;
+	for (unsigned int i=0;i<IndexCount;++i)
+	{
+		seen += counts_[i];
+		if (seen >= target)
+		{
+			auto value = highestValue(i);
+			return value < max_ ? value : max_;
+		}
+	}
+
+	return max_;
+}
+
+void Histogram::writeDistribution(std::ostream &out, unsigned int ticks, double scale) const
+{
+	out << setw(12) << "Value" << setw(15) << "Percentile" << setw(11) << "TotalCount" << setw(18) << "1/(1-Percentile)" << endl << endl;
+	out << fixed;
+
+	if (count_)
+	{
+		// ticks lines for 0-50%, then ticks lines for each half of what is left
+		double percent = 0.0;
+		uint64_t seen = 0;
+		unsigned int i = 0;
+		while (seen < count_)
+		{
+			auto target = (uint64_t)ceil(percent / 100.0 * count_);
+			if (target < 1)
+				target = 1;
+			while (seen < target)
+				seen += counts_[i++];
+
+			auto value = highestValue(i - 1);
+			out << setw(12) << setprecision(3) << (value < max_ ? value : max_) / scale
+				<< setw(15) << setprecision(12) << percent / 100.0 << setw(11) << seen
+				<< setw(15) << setprecision(2) << 1.0 / (1.0 - percent / 100.0) << endl;
+
+			auto halvings = floor(log2(100.0 / (100.0 - percent)));
+			percent += 100.0 / (ticks * pow(2.0, halvings + 1));
+
+			// past what the number of values can tell apart
+			if (1.0 / (1.0 - percent / 100.0) > count_)
+				break;
+		}
+
+		out << setw(12) << setprecision(3) << max_ / scale << setw(15) << setprecision(12) << 1.0
+			<< setw(11) << count_ << setw(15) << "inf" << endl;
+	}
+
+	out << "#[Mean    = " << setw(12) << setprecision(3) << mean() / scale
+		<< ", Min            = " << setw(12) << min() / scale << "]" << endl;
+	out << "#[Max     = " << setw(12) << max_ / scale << ", Total count    = " << setw(12) << count_ << "]" << endl;
+	out.unsetf(ios::floatfield);
+}
+
+unsigned int Histogram::highestBit(std::uint64_t value)
+{
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(value);
+#else
+	unsigned int bit = 0;
+	while (value >>= 1)
+		++bit;
+	return bit;
+#endif
+}
+
+uint64_t Histogram::highestValue(unsigned int index)
+{
+	if (index < SubBucketCount)
+		return index;
+
+	unsigned int shift = index / SubBucketHalf - 1;
+	uint64_t sub = index % SubBucketHalf + SubBucketHalf;
+	return ((sub + 1) << shift) - 1;
+}
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __histogram_H
+#define __histogram_H
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+
+/*!
+ * \brief HDR style latency histogram
+ *
+ * Values below 128 are counted exactly, larger values go in buckets of 64
+ * sub-buckets per power of two, so every recorded value is kept to within
+ * 1/64 (1.6%) of what was recorded from 1ns up to hours.  Recording is an
+ * increment of a counter with no allocation, each thread keeps its own
+ * histogram and they are merged with \ref add() when the run is done.
+ *
+ * The minimum, maximum and mean are exact.
+ */
+class Histogram
+{
+public:
+	Histogram();
+
+	//! Counts one value
+	void record(std::uint64_t value)
+	{
+		++counts_[index(value)];
+		++count_;
+		total_ += value;
+		if (value > max_)
+			max_ = value;
+		if (value < min_)
+			min_ = value;
+	}
+
+	//! Adds all the counts in \a other to this histogram
+	void add(const Histogram &other);
+
+	//! Clears all counts
+	void reset();
+
+	//! Number of values recorded
+	std::uint64_t count() const { return count_; }
+
+	//! Smallest value recorded, 0 when empty
+	std::uint64_t min() const;
+
+	//! Largest value recorded
+	std::uint64_t max() const { return max_; }
+
+	//! Mean of the recorded values
+	double mean() const;
+
+	/*!
+	 * \brief Value at a percentile
+	 *
+	 * Returns the highest value that is in the same bucket as the value at
+	 * \a percentile (0-100), i.e. no recorded value below the percentile is
+	 * larger than what is returned.  100 returns \ref max().
+	 */
+	std::uint64_t percentile(double percentile) const;
+
+	/*!
+	 * \brief Writes the percentile distribution
+	 *
+	 * Uses the HdrHistogram .hgrm text layout (Value, Percentile, TotalCount,
+	 * 1/(1-Percentile)) with \a ticks lines per halving of the distance to
+	 * 100%, so the output can be plotted with the usual HdrHistogram tools.
+	 * Values are divided by \a scale, i.e. 1000 for microseconds from ns.
+	 */
+	void writeDistribution(std::ostream &out, unsigned int ticks = 5, double scale = 1.0) const;
+
+private:
+	static const unsigned int SubBucketBits = 7;
+	static const unsigned int SubBucketCount = 1 << SubBucketBits;
+	static const unsigned int SubBucketHalf = SubBucketCount / 2;
+	static const unsigned int IndexCount = (64 - SubBucketBits + 2) * SubBucketHalf;
+
+	static unsigned int index(std::uint64_t value)
+	{
+		if (value < SubBucketCount)
+			return (unsigned int)value;
+
+		unsigned int shift = highestBit(value) - (SubBucketBits - 1);
+		return shift * SubBucketHalf + (unsigned int)(value >> shift);
+	}
+
+	static unsigned int highestBit(std::uint64_t value);
+
+	//! highest value that lands in the bucket at \a index
+	static std::uint64_t highestValue(unsigned int index);
+
+	std::vector<std::uint64_t> counts_;
+	std::uint64_t count_;
+	std::uint64_t total_;
+	std::uint64_t min_;
+	std::uint64_t max_;
+};
+
+#endif // __histogram_H
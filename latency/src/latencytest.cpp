@@ -0,0 +1,413 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "latencytest.h"
+#include "histogram.h"
+#include <sharklog/logger.h>
+#include <sharklog/outputter.h>
+#include <sharklog/fileoutputter.h>
+#include <sharklog/rawfileoutputter.h>
+#include <sharklog/mappedfileoutputter.h>
+#include <sharklog/rollingfileoutputter.h>
+#include <sharklog/binaryfileoutputter.h>
+#include <sharklog/asyncoutputter.h>
+#include <sharklog/standardlayout.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define SHARKLOG_LATENCY_TSC
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+#endif
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	// takes the message and does nothing with it so only dispatch is timed
+	class NullOutputter : public Outputter
+	{
+	public:
+		bool open() override { return true; }
+		void writeLog(const Level &, const std::string &loggerName, const std::string &logMessage, const Location &) override
+		{
+			sink_ = loggerName.size() + logMessage.size();
+		}
+		void close() override { }
+		bool isOpen() const override { return true; }
+		bool isValid() const override { return true; }
+
+	private:
+		volatile std::size_t sink_ = 0;
+	};
+
+	// nanoseconds from std::chrono::steady_clock
+	struct SteadyClock
+	{
+		static uint64_t now()
+		{
+			return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t toNanoseconds(uint64_t ticks) { return ticks; }
+	};
+
+#if defined(SHARKLOG_LATENCY_TSC)
+	// time stamp counter ticks, calibrated against steady_clock
+	struct TscClock
+	{
+		static uint64_t now() { return __rdtsc(); }
+
+		static uint64_t toNanoseconds(uint64_t ticks) { return (uint64_t)(ticks * nsPerTick); }
+
+		static void calibrate()
+		{
+			auto start = steady_clock::now();
+			auto ticks = now();
+			while (steady_clock::now() - start < milliseconds(200))
+				;
+			ticks = now() - ticks;
+			nsPerTick = (double)duration_cast<std::chrono::nanoseconds>(steady_clock::now() - start).count() / ticks;
+		}
+
+		static double nsPerTick;
+	};
+
+	double TscClock::nsPerTick = 1.0;
+#endif
+
+	// the smallest difference between two reads of the clock, in ns
+	template <class Clock>
+	uint64_t clockOverhead()
+	{
+		uint64_t best = ~(uint64_t)0;
+		for (int i=0;i<100000;++i)
+		{
+			auto start = Clock::now();
+			auto end = Clock::now();
+			best = std::min(best, end - start);
+		}
+		return Clock::toNanoseconds(best);
+	}
+
+	OutputterPtr makeOutputter(const string &type, const string &filename)
+	{
+		if (!type.compare(0, 6, "async-"))
+		{
+			auto op = makeOutputter(type.substr(6), filename);
+			return op ? make_shared<AsyncOutputter>(op) : op;
+		}
+
+		OutputterPtr op;
+		if (type == "null")
+			return make_shared<NullOutputter>();
+		else if (type == "file")
+			op = make_shared<FileOutputter>(filename);
+		else if (type == "raw")
+			op = make_shared<RawFileOutputter>(filename);
+		else if (type == "mapped")
+			op = make_shared<MappedFileOutputter>(filename);
+		else if (type == "rolling")
+			op = make_shared<RollingFileOutputter>(filename);
+		else if (type == "binary")
+			return make_shared<BinaryFileOutputter>(filename);
+		else
+			return op;
+
+		op->setLayout(make_shared<StandardLayout>());
+		return op;
+	}
+
+	// disk and cpu load that runs next to the logging threads
+	class Noise
+	{
+	public:
+		Noise(const vector<string> &types, const string &directory)
+			: stop_(false)
+			, filename_(directory + "/latency-noise.tmp")
+		{
+			for (auto &type : types)
+			{
+				if (type == "fsync")
+					threads_.push_back(thread(&Noise::fsyncLoop, this));
+				else if (type == "cpu")
+				{
+					for (unsigned int i=0;i<std::max(1u, thread::hardware_concurrency());++i)
+						threads_.push_back(thread(&Noise::cpuLoop, this));
+				}
+			}
+		}
+
+		~Noise()
+		{
+			stop_ = true;
+			for (auto &it : threads_)
+				it.join();
+			remove(filename_.c_str());
+		}
+
+	private:
+		// writes 64KB and syncs it to disk over and over
+		void fsyncLoop()
+		{
+#if !defined(_WIN32) && !defined(_WIN64)
+			int fd = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0)
+				return;
+
+			const string block(65536, 'n');
+			unsigned int writes = 0;
+			while (!stop_)
+			{
+				if (::write(fd, block.data(), block.size()) < 0)
+					break;
+				fsync(fd);
+
+				// start over every 64MB so the disk doesn't fill up
+				if (++writes == 1024)
+				{
+					writes = 0;
+					if (ftruncate(fd, 0) || lseek(fd, 0, SEEK_SET) < 0)
+						break;
+				}
+			}
+			::close(fd);
+#endif
+		}
+
+		void cpuLoop()
+		{
+			volatile uint64_t spin = 0;
+			while (!stop_)
+				++spin;
+		}
+
+		atomic<bool> stop_;
+		string filename_;
+		vector<thread> threads_;
+	};
+
+	struct RunResult
+	{
+		Histogram histogram;
+		double seconds = 0;
+	};
+
+	template <class Clock>
+	bool run(const LatencyOptions &options, const string &type, unsigned int threadCount, size_t size, RunResult &result)
+	{
+		static unsigned int runs = 0;
+		const string filename = options.directory + "/latency-" + type + ".log";
+
+		auto op = makeOutputter(type, filename);
+		if (!op || !op->open())
+			return false;
+
+		auto log = Logger::logger("latency.run" + to_string(++runs));
+		log->addOutputter(op);
+
+		string msg = "latency test message ";
+		msg.resize(size, 'x');
+
+		const uint64_t interval = options.rate > 0 ? (uint64_t)(1e9 / options.rate) : 0;
+		vector<Histogram> histograms(threadCount);
+		atomic<unsigned int> ready(0);
+		atomic<bool> go(false);
+		vector<thread> threads;
+		for (unsigned int t=0;t<threadCount;++t)
+		{
+			threads.push_back(thread([&, t]() {
+				auto &histogram = histograms[t];
+				for (uint64_t i=0;i<options.warmup;++i)
+					log->log(Level::info(), msg);
+
+				++ready;
+				while (!go.load())
+					this_thread::yield();
+
+				// the schedule is kept in steady ns, Clock ticks are only compared to ticks
+				uint64_t due = SteadyClock::now();
+				for (uint64_t i=0;i<options.messages;++i)
+				{
+					// a call that is late because the one before it stalled counts the wait too
+					uint64_t late = 0;
+					if (interval)
+					{
+						uint64_t now;
+						while ((now = SteadyClock::now()) < due)
+							;
+						late = now - due;
+						due += interval;
+					}
+
+					auto start = Clock::now();
+					log->log(Level::info(), msg);
+					histogram.record(Clock::toNanoseconds(Clock::now() - start) + late);
+				}
+			}));
+		}
+
+		while (ready.load() < threadCount)
+			this_thread::yield();
+
+		auto start = steady_clock::now();
+		go = true;
+		for (auto &it : threads)
+			it.join();
+		result.seconds = duration<double>(steady_clock::now() - start).count();
+
+		log->removeOutputter(op);
+		op->close();
+		remove(filename.c_str());
+
+		result.histogram.reset();
+		for (auto &it : histograms)
+			result.histogram.add(it);
+
+		return true;
+	}
+}
+
+const std::vector<std::string> &outputterTypes()
+{
+	static const vector<string> types = { "null", "file", "raw", "mapped", "rolling", "binary",
+		"async-null", "async-file", "async-raw", "async-mapped", "async-rolling", "async-binary" };
+	return types;
+}
+
+const std::vector<std::string> &noiseTypes()
+{
+	static const vector<string> types = { "fsync", "cpu" };
+	return types;
+}
+
+int runLatencyTest(const LatencyOptions &options)
+{
+	for (auto &type : options.outputters)
+	{
+		if (find(outputterTypes().begin(), outputterTypes().end(), type) == outputterTypes().end())
+		{
+			cout << "Unknown outputter type " << type << endl;
+			return 1;
+		}
+	}
+	for (auto &type : options.noise)
+	{
+		if (find(noiseTypes().begin(), noiseTypes().end(), type) == noiseTypes().end())
+		{
+			cout << "Unknown noise type " << type << endl;
+			return 1;
+		}
+	}
+
+	bool (*runner)(const LatencyOptions &, const string &, unsigned int, size_t, RunResult &) = &run<SteadyClock>;
+	uint64_t overhead = 0;
+	if (options.clock == "tsc")
+	{
+#if defined(SHARKLOG_LATENCY_TSC)
+		TscClock::calibrate();
+		runner = &run<TscClock>;
+		overhead = clockOverhead<TscClock>();
+#else
+		cout << "The tsc clock is not available on this platform" << endl;
+		return 1;
+#endif
+	}
+	else if (options.clock == "steady")
+		overhead = clockOverhead<SteadyClock>();
+	else
+	{
+		cout << "Unknown clock " << options.clock << endl;
+		return 1;
+	}
+
+	cout << "Logger::log() latency, " << options.messages << " timed records per thread";
+	if (options.rate > 0)
+		cout << " at " << options.rate << "/sec, measured from when each call was due";
+	cout << endl;
+	cout << "clock: " << options.clock << " (" << overhead << "ns per read), hardware threads: " << thread::hardware_concurrency();
+	cout << ", noise: ";
+	if (options.noise.empty())
+		cout << "none";
+	for (size_t i=0;i<options.noise.size();++i)
+		cout << (i ? "," : "") << options.noise[i];
+	cout << endl << endl;
+
+	cout << setw(14) << "outputter" << setw(8) << "threads" << setw(7) << "size"
+		<< setw(10) << "p50 ns" << setw(10) << "p99 ns" << setw(11) << "p99.9 ns" << setw(12) << "p99.99 ns"
+		<< setw(12) << "max ns" << setw(10) << "mean ns" << setw(14) << "msgs/sec" << endl;
+
+	unique_ptr<Noise> noise;
+	if (!options.noise.empty())
+		noise.reset(new Noise(options.noise, options.directory));
+
+	RunResult result;
+	for (auto &type : options.outputters)
+	{
+		for (auto threadCount : options.threads)
+		{
+			for (auto size : options.sizes)
+			{
+				if (!runner(options, type, threadCount, size, result))
+				{
+					cout << "Failed to open a " << type << " outputter in " << options.directory << endl;
+					return 1;
+				}
+
+				auto &h = result.histogram;
+				cout << setw(14) << type << setw(8) << threadCount << setw(7) << size
+					<< setw(10) << h.percentile(50) << setw(10) << h.percentile(99) << setw(11) << h.percentile(99.9)
+					<< setw(12) << h.percentile(99.99) << setw(12) << h.max()
+					<< setw(10) << fixed << setprecision(0) << h.mean()
+					<< setw(14) << h.count() / result.seconds << endl;
+
+				if (!options.histogramPrefix.empty())
+				{
+					ofstream out(options.histogramPrefix + "-" + type + "-" + to_string(threadCount) + "t-" + to_string(size) + "b.hgrm");
+					h.writeDistribution(out, 5, 1000.0);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
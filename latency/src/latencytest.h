@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __latencytest_H
+#define __latencytest_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * \brief What \ref runLatencyTest() measures
+ *
+ * One run is made for every combination of \ref outputters, \ref threads
+ * and \ref sizes.
+ */
+struct LatencyOptions
+{
+	//! thread counts, every thread logs \ref messages records
+	std::vector<unsigned int> threads = { 1 };
+	//! message sizes in bytes
+	std::vector<std::size_t> sizes = { 64 };
+	//! outputter types, see \ref outputterTypes()
+	std::vector<std::string> outputters = { "file" };
+	//! background noise types, see \ref noiseTypes()
+	std::vector<std::string> noise;
+	//! timed records per thread
+	std::uint64_t messages = 1000000;
+	//! untimed records per thread before timing starts
+	std::uint64_t warmup = 10000;
+	//! records per second per thread, 0 logs as fast as possible
+	double rate = 0.0;
+	//! "steady" for std::chrono::steady_clock, "tsc" for the time stamp counter
+	std::string clock = "steady";
+	//! where log and noise files go
+	std::string directory = ".";
+	//! when set each run's distribution is written to <prefix>-<run>.hgrm
+	std::string histogramPrefix;
+};
+
+//! Outputter types the harness can log to
+const std::vector<std::string> &outputterTypes();
+
+//! Background noise the harness can run during a test
+const std::vector<std::string> &noiseTypes();
+
+/*!
+ * \brief Measures the latency of every Logger::log() call
+ *
+ * Every call is timed on its own and recorded into a per thread
+ * \ref Histogram, the table printed at the end has the percentiles of
+ * all threads together.
+ *
+ * With a \ref LatencyOptions::rate each thread logs on a fixed schedule and
+ * latency is measured from when the call was due, not when it was made, so
+ * a stall is counted against every call that had to wait for it.
+ *
+ * \return 0 on success, 1 if an option was bad or a file couldn't be opened
+ */
+int runLatencyTest(const LatencyOptions &options);
+
+#endif // __latencytest_H
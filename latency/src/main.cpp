@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "latencytest.h"
+#include <sharklog/logger.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace sharklog;
+
+void usage();
+std::vector<std::string> split(const std::string &list);
+
+int main(int ac, char **av)
+{
+    LatencyOptions options;
+
+    for (int i=1;i<ac;++i)
+    {
+        string arg = av[i];
+        if (arg == "--help")
+        {
+            usage();
+            return 0;
+        }
+
+        if (i + 1 >= ac)
+        {
+            usage();
+            return 1;
+        }
+
+        string value = av[++i];
+        if (arg == "-t")
+        {
+            options.threads.clear();
+            for (auto &it : split(value))
+                options.threads.push_back((unsigned int)strtoul(it.c_str(), nullptr, 10));
+        }
+        else if (arg == "-s")
+        {
+            options.sizes.clear();
+            for (auto &it : split(value))
+                options.sizes.push_back(strtoul(it.c_str(), nullptr, 10));
+        }
+        else if (arg == "-o")
+            options.outputters = split(value);
+        else if (arg == "-x")
+            options.noise = split(value);
+        else if (arg == "-n")
+            options.messages = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "-w")
+            options.warmup = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "-r")
+            options.rate = strtod(value.c_str(), nullptr);
+        else if (arg == "-c")
+            options.clock = value;
+        else if (arg == "-d")
+            options.directory = value;
+        else if (arg == "-g")
+            options.histogramPrefix = value;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    for (auto it : options.threads)
+    {
+        if (!it)
+        {
+            cout << "Thread counts must be at least 1" << endl;
+            return 1;
+        }
+    }
+
+    auto res = runLatencyTest(options);
+    Logger::closeRootLogger();
+    return res;
+}
+
+std::vector<std::string> split(const std::string &list)
+{
+    vector<string> res;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        if (!item.empty())
+            res.push_back(item);
+    }
+    return res;
+}
+
+void usage()
+{
+    cout << "sharklog-latency [options]" << endl << endl;
+    cout << "Times every Logger::log() call and prints p50, p99, p99.9, p99.99 and max" << endl;
+    cout << "for each outputter, thread count and message size" << endl << endl;
+
+    cout << "   --help                 Shows this help" << endl;
+    cout << "   -t 1,2,4               Thread counts (1)" << endl;
+    cout << "   -s 64,256              Message sizes in bytes (64)" << endl;
+    cout << "   -o file,async-file     Outputters (file), one of" << endl;
+    cout << "                          ";
+    for (auto &it : outputterTypes())
+    {
+        if (it.compare(0, 6, "async-"))
+            cout << it << " ";
+    }
+    cout << endl;
+    cout << "                          or async- and one of them for an AsyncOutputter" << endl;
+    cout << "   -x fsync,cpu           Background noise while logging (none)" << endl;
+    cout << "                          fsync: a thread writing 64KB and calling fsync() in a loop" << endl;
+    cout << "                          cpu: a spinning thread per hardware thread" << endl;
+    cout << "   -n count               Timed records per thread (1000000)" << endl;
+    cout << "   -w count               Untimed warm up records per thread (10000)" << endl;
+    cout << "   -r rate                Records per second per thread, latency is measured from" << endl;
+    cout << "                          when each call was due (0, as fast as possible)" << endl;
+    cout << "   -c steady|tsc          Clock for timing calls (steady)" << endl;
+    cout << "   -d directory           Where log and noise files are written (.)" << endl;
+    cout << "   -g prefix              Write each run's distribution in microseconds to" << endl;
+    cout << "                          prefix-outputter-Nt-Nb.hgrm (HdrHistogram format)" << endl;
+    cout << endl;
+}
@@ -0,0 +1,503 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "asyncoutputter.h"
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+
+using namespace sharklog;
+using namespace std;
+
+const std::size_t AsyncOutputter::DefaultCapacity;
+const unsigned int AsyncOutputter::DefaultDropReportInterval;
+std::mutex AsyncOutputter::allMutex_;
+std::vector<AsyncOutputter *> AsyncOutputter::all_;
+
+namespace
+{
+	std::size_t roundCapacity(std::size_t capacity)
+	{
+		std::size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		return size;
+	}
+}
+
+AsyncOutputter::AsyncOutputter(OutputterPtr op, std::size_t capacity)
+	: outputter_(op)
+	, slots_(roundCapacity(capacity))
+	, mask_(slots_.size() - 1)
+	, tail_(0)
+	, producers_(0)
+	, head_(0)
+	, processed_(0)
+	, running_(false)
+	, sleeping_(false)
+	, policy_(Block)
+	, threshold_(Level::WARN)
+	, reportInterval_(DefaultDropReportInterval)
+	, lastReport_(chrono::steady_clock::now())
+{
+	for (std::size_t i=0;i<slots_.size();++i)
+		slots_[i].seq.store(i, memory_order_relaxed);
+
+	for (int i=0;i<=Level::ALL;++i)
+	{
+		dropped_[i] = 0;
+		reported_[i] = 0;
+	}
+
+	{
+		lock_guard<mutex> lock(allMutex_);
+		all_.push_back(this);
+	}
+
+	running_ = true;
+	writer_ = thread(&AsyncOutputter::run, this);
+}
+
+AsyncOutputter::~AsyncOutputter()
+{
+	{
+		lock_guard<mutex> lock(allMutex_);
+		all_.erase(std::remove(all_.begin(), all_.end(), this), all_.end());
+	}
+
+	close();
+}
+
+OutputterPtr AsyncOutputter::outputter() const
+{
+	return outputter_;
+}
+
+std::size_t AsyncOutputter::capacity() const
+{
+	return slots_.size();
+}
+
+std::size_t AsyncOutputter::size() const
+{
+	auto head = head_.load(memory_order_acquire);
+	auto tail = tail_.load(memory_order_acquire);
+	return (tail > head) ? tail - head : 0;
+}
+
+bool AsyncOutputter::open()
+{
+	if (!outputter_)
+		return false;
+
+	lock_guard<mutex> lock(closeMutex_);
+
+	if (!outputter_->isOpen())
+		outputter_->open();
+
+	if (!running_)
+	{
+		running_ = true;
+		writer_ = thread(&AsyncOutputter::run, this);
+	}
+
+	return outputter_->isOpen();
+}
+
+void AsyncOutputter::close()
+{
+	lock_guard<mutex> lock(closeMutex_);
+
+	if (running_)
+	{
+		{
+			lock_guard<mutex> lock(mutex_);
+			running_ = false;
+		}
+		wake_.notify_all();
+	}
+
+	// producers that saw running_ finish their push, the ones that come
+	// after write straight to the outputter
+	while (producers_.load())
+		this_thread::yield();
+
+	if (writer_.joinable())
+		writer_.join();
+
+	// anything that was queued while the writer was stopping
+	while (pop([this](Record &rec) { std::swap(current_, rec); }))
+	{
+		write(current_);
+		processed_.fetch_add(1, memory_order_release);
+	}
+	notifyDrained();
+
+	if (outputter_ && reportInterval_)
+		reportDropped();
+
+	if (outputter_)
+		outputter_->close();
+}
+
+bool AsyncOutputter::isOpen() const
+{
+	return running_ && outputter_ && outputter_->isOpen();
+}
+
+bool AsyncOutputter::isValid() const
+{
+	return outputter_ && outputter_->isValid();
+}
+
+void AsyncOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	if (!isValid())
+		return;
+
+	// close() waits for producers_ to reach 0 after clearing running_
+	++producers_;
+	if (!running_)
+	{
+		--producers_;
+		outputter_->log(lev, loggerName, logMessage, loc);
+		return;
+	}
+
+	while (!push(lev, loggerName, logMessage, nullptr, loc))
+	{
+		if (!overflow(lev))
+		{
+			--producers_;
+			return;
+		}
+	}
+
+	--producers_;
+	wakeWriter();
+}
+
+void AsyncOutputter::writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc)
+{
+	if (!isValid())
+		return;
+
+	++producers_;
+	if (!running_)
+	{
+		--producers_;
+		outputter_->logDeferred(lev, loggerName, msg, loc);
+		return;
+	}
+
+	while (!push(lev, loggerName, std::string(), &msg, loc))
+	{
+		if (!overflow(lev))
+		{
+			--producers_;
+			return;
+		}
+	}
+
+	--producers_;
+	wakeWriter();
+}
+
+void AsyncOutputter::setOverflowPolicy(OverflowPolicy policy, const Level &threshold)
+{
+	threshold_ = threshold.level();
+	policy_ = policy;
+}
+
+AsyncOutputter::OverflowPolicy AsyncOutputter::overflowPolicy() const
+{
+	return (OverflowPolicy)policy_.load();
+}
+
+Level AsyncOutputter::dropThreshold() const
+{
+	return Level((Level::LogLevel)threshold_.load());
+}
+
+unsigned long long AsyncOutputter::droppedCount(const Level &lev) const
+{
+	return dropped_[lev.level()].load(memory_order_relaxed);
+}
+
+unsigned long long AsyncOutputter::droppedCount() const
+{
+	unsigned long long total = 0;
+	for (int i=0;i<=Level::ALL;++i)
+		total += dropped_[i].load(memory_order_relaxed);
+	return total;
+}
+
+void AsyncOutputter::setDropReportInterval(unsigned int ms)
+{
+	reportInterval_ = ms;
+}
+
+unsigned int AsyncOutputter::dropReportInterval() const
+{
+	return reportInterval_;
+}
+
+void AsyncOutputter::flush()
+{
+	auto target = tail_.load(memory_order_acquire);
+
+	unique_lock<mutex> lock(mutex_);
+	wake_.notify_one();
+	while (!drained_.wait_for(lock, chrono::milliseconds(100), [this, target] {
+		return processed_.load(memory_order_acquire) >= target || !running_;
+	}))
+		wake_.notify_one();
+}
+
+void AsyncOutputter::closeAll()
+{
+	lock_guard<mutex> lock(allMutex_);
+	for (auto op : all_)
+		op->close();
+}
+
+bool AsyncOutputter::push(const Level &lev, const std::string &loggerName, const std::string &logMessage, const DeferredMessage *deferred, const Location &loc)
+{
+	// bounded queue from D. Vyukov, each slot has a sequence number that
+	// tells producers and consumers whose turn it is
+	Slot *slot;
+	auto pos = tail_.load(memory_order_relaxed);
+	for (;;)
+	{
+		slot = &slots_[pos & mask_];
+		auto seq = slot->seq.load(memory_order_acquire);
+		auto diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0)
+		{
+			if (tail_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+			return false; // full
+		else
+			pos = tail_.load(memory_order_relaxed);
+	}
+
+	// assign so the slot strings keep their capacity
+	auto &rec = slot->record;
+	rec.level = lev;
+	rec.loggerName.assign(loggerName);
+	rec.isDeferred = deferred != nullptr;
+	if (deferred)
+		rec.deferred = *deferred;
+	else
+		rec.message.assign(logMessage);
+	rec.loc = loc;
+	rec.ctx = RecordContext::current();
+
+	slot->seq.store(pos + 1, memory_order_release);
+	return true;
+}
+
+template <class Func>
+bool AsyncOutputter::pop(Func func)
+{
+	Slot *slot;
+	auto pos = head_.load(memory_order_relaxed);
+	for (;;)
+	{
+		slot = &slots_[pos & mask_];
+		auto seq = slot->seq.load(memory_order_acquire);
+		auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+		if (diff == 0)
+		{
+			if (head_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+			return false; // empty
+		else
+			pos = head_.load(memory_order_relaxed);
+	}
+
+	func(slot->record);
+
+	slot->seq.store(pos + mask_ + 1, memory_order_release);
+	return true;
+}
+
+bool AsyncOutputter::overflow(const Level &lev)
+{
+	// returns true if the message should be pushed again
+	switch (policy_.load(memory_order_relaxed))
+	{
+	case DropNewest:
+		drop(lev);
+		return false;
+
+	case DropOldest:
+		if (pop([this](Record &rec) { drop(rec.level); }))
+			processed_.fetch_add(1, memory_order_release);
+		return true;
+
+	case DropBelowLevel:
+		// errors and fatals are always kept
+		if (lev.level() > Level::ERROR && lev.level() > threshold_.load(memory_order_relaxed))
+		{
+			drop(lev);
+			return false;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// wait on the writer to make room
+	wakeWriter();
+	this_thread::yield();
+	return true;
+}
+
+void AsyncOutputter::drop(const Level &lev)
+{
+	dropped_[lev.level()].fetch_add(1, memory_order_relaxed);
+	countDropped();
+}
+
+void AsyncOutputter::checkDropReport()
+{
+	auto interval = reportInterval_.load(memory_order_relaxed);
+	if (interval && chrono::steady_clock::now() - lastReport_ >= chrono::milliseconds(interval))
+		reportDropped();
+}
+
+void AsyncOutputter::reportDropped()
+{
+	// only called by the writer (or close() once it has stopped)
+	stringstream ss;
+	unsigned long long total = 0;
+	for (int i=0;i<=Level::ALL;++i)
+	{
+		auto dropped = dropped_[i].load(memory_order_relaxed);
+		if (dropped == reported_[i])
+			continue;
+
+		ss << " " << Level((Level::LogLevel)i).name() << "=" << dropped - reported_[i];
+		total += dropped - reported_[i];
+		reported_[i] = dropped;
+	}
+
+	lastReport_ = chrono::steady_clock::now();
+	if (!total)
+		return;
+
+	stringstream msg;
+	msg << "AsyncOutputter queue full, dropped " << total << " log messages:" << ss.str();
+	outputter_->log(Level::warn(), "sharklog", msg.str(), Location());
+}
+
+bool AsyncOutputter::empty() const
+{
+	return head_.load() == tail_.load();
+}
+
+void AsyncOutputter::write(Record &rec)
+{
+	RecordContext::Scope pin(rec.ctx);
+
+	// deferred messages are formatted here on the writer thread, or not at
+	// all by outputters that keep the arguments
+	if (rec.isDeferred)
+		outputter_->logDeferred(rec.level, rec.loggerName, rec.deferred, rec.loc);
+	else
+		outputter_->log(rec.level, rec.loggerName, rec.message, rec.loc);
+}
+
+void AsyncOutputter::wakeWriter()
+{
+	// the writer sets sleeping_ before checking for work, so either it sees
+	// our message or we see it sleeping
+	atomic_thread_fence(memory_order_seq_cst);
+
+	// only the first producer to see it sleeping pays for the notify, the
+	// writer may not run for a while after it is woken
+	if (sleeping_.load() && sleeping_.exchange(false))
+	{
+		lock_guard<mutex> lock(mutex_);
+		wake_.notify_one();
+	}
+}
+
+void AsyncOutputter::notifyDrained()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+	}
+	drained_.notify_all();
+}
+
+void AsyncOutputter::run()
+{
+	for (;;)
+	{
+		unsigned int written = 0;
+		// take the message out of its slot before writing it so a slow write
+		// doesn't hold up the queue
+		while (pop([this](Record &rec) { std::swap(current_, rec); }))
+		{
+			write(current_);
+			processed_.fetch_add(1, memory_order_release);
+
+			// don't let a steady stream of messages hold back the reports
+			if ((++written & 1023) == 0)
+				checkDropReport();
+		}
+
+		if (written)
+			notifyDrained();
+
+		checkDropReport();
+
+		auto interval = reportInterval_.load(memory_order_relaxed);
+		unique_lock<mutex> lock(mutex_);
+		if (!running_ && empty())
+			break;
+
+		// wake up at least often enough to send the dropped reports
+		auto timeout = chrono::milliseconds(100);
+		if (interval && chrono::milliseconds(interval) < timeout)
+			timeout = chrono::milliseconds(interval);
+
+		sleeping_ = true;
+		wake_.wait_for(lock, timeout, [this] {
+			return !running_ || !empty();
+		});
+		sleeping_ = false;
+	}
+
+	notifyDrained();
+}
@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __asyncoutputter_H
+#define __asyncoutputter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/outputter.h>
+#include <sharklog/level.h>
+#include <sharklog/location.h>
+#include <sharklog/recordcontext.h>
+#include <sharklog/deferredmessage.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstddef>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Asynchronous outputter
+ *
+ * This outputter takes the writing of log messages off of the logging thread.
+ * It wraps any other \ref Outputter, queues the log messages into a
+ * preallocated lock-free ring buffer and writes them to the wrapped outputter
+ * from a dedicated writer thread.
+ *
+ * Any number of threads can log to it at once.  The time and thread of every
+ * message is captured when it is logged (see \ref RecordContext) so the
+ * layout of the wrapped outputter shows the same thing it would if it was
+ * written synchronously.
+ *
+ * When the queue is full what happens depends on the \ref OverflowPolicy.  By
+ * default the logging thread waits for the writer to make room.  Messages that
+ * are dropped are counted per \ref Level, see \ref droppedCount(), and a
+ * warning saying how many were dropped is written to the wrapped outputter
+ * every \ref dropReportInterval() milliseconds.
+ *
+ * The writer thread is started by the constructor.  \ref close() writes out
+ * everything that is queued, stops the writer and closes the wrapped outputter.
+ * \ref Logger::closeRootLogger() closes all AsyncOutputters.
+ *
+ * \code
+ * auto fop = std::make_shared<FileOutputter>("/tmp/test.log");
+ * fop->setLayout(std::make_shared<StandardLayout>());
+ * if (!fop->open())
+ *    return 1;
+ *
+ * // queue up to 16k messages for the file
+ * auto aop = std::make_shared<AsyncOutputter>(fop, 16384);
+ * Logger::rootLogger()->addOutputter(aop);
+ *
+ * SHARKLOG_INFO(Logger::rootLogger(), "written by the writer thread");
+ *
+ * // wait for everything logged so far to be written
+ * aop->flush();
+ * \endcode
+ *
+ * \note The wrapped outputter's layout is used, the layout of the
+ * AsyncOutputter itself is ignored.
+ */
+class SHARKLOGAPI AsyncOutputter : public Outputter
+{
+public:
+	//! Default queue capacity
+	static const std::size_t DefaultCapacity = 8192;
+
+	//! Default milliseconds between dropped message reports
+	static const unsigned int DefaultDropReportInterval = 10000;
+
+	/*!
+	 * What to do with a message when the queue is full.
+	 */
+	enum OverflowPolicy
+	{
+		Block //!< wait for the writer to make room, nothing is lost
+		, DropNewest //!< drop the message being logged
+		, DropOldest //!< drop the oldest queued message to make room
+		, DropBelowLevel //!< drop the message if it is less severe than the threshold, otherwise wait
+	};
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * Creates an AsyncOutputter that writes to \a op and starts the writer
+	 * thread.
+	 *
+	 * \a capacity is the number of messages the queue can hold, it is rounded
+	 * up to a power of 2.  All the queue slots are allocated here.
+	 *
+	 * \param op the outputter to write to
+	 * \param capacity the queue capacity
+	 */
+	AsyncOutputter(OutputterPtr op, std::size_t capacity = DefaultCapacity);
+
+	//! Destructor, closes the outputter
+	virtual ~AsyncOutputter();
+
+	/*!
+	 * \brief Wrapped outputter
+	 *
+	 * \return the outputter messages are written to
+	 */
+	OutputterPtr outputter() const;
+
+	/*!
+	 * \brief Queue capacity
+	 *
+	 * The number of messages that can be queued before logging has to
+	 * wait on the writer thread.
+	 *
+	 * \return the queue capacity
+	 */
+	std::size_t capacity() const;
+
+	/*!
+	 * \brief Queued messages
+	 *
+	 * The number of messages waiting to be written.  This is only a snapshot
+	 * as other threads may be logging.
+	 *
+	 * \return the number of queued messages
+	 */
+	std::size_t size() const;
+
+	/*!
+	 * \brief Opens the outputter
+	 *
+	 * Opens the wrapped outputter if it is not already open and starts the
+	 * writer thread if it was stopped by \ref close().
+	 *
+	 * \return true if the wrapped outputter is open
+	 */
+	bool open() override;
+
+	/*!
+	 * \brief Queues a log message
+	 *
+	 * Queues the message to be written by the writer thread.  If the writer
+	 * is stopped the message is written to the wrapped outputter directly.
+	 */
+	void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+	/*!
+	 * \brief Queues a message that isn't formatted yet
+	 *
+	 * Copies the captured arguments into the queue, they are formatted on the
+	 * writer thread just before the wrapped outputter's writeLog().
+	 */
+	void writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc) override;
+
+	/*!
+	 * \brief Closes the outputter
+	 *
+	 * Writes out all the queued messages, stops the writer thread and closes
+	 * the wrapped outputter.  Messages being queued by other threads while
+	 * it runs are written too, by close() or, once the writer has stopped,
+	 * by the logging thread.
+	 */
+	void close() override;
+
+	//! True if the writer is running and the wrapped outputter is open
+	bool isOpen() const override;
+
+	//! True if the wrapped outputter is valid
+	bool isValid() const override;
+
+	/*!
+	 * \brief Waits for the queue to drain
+	 *
+	 * Blocks until every message queued before this call has been written
+	 * to the wrapped outputter.
+	 */
+	void flush();
+
+	/*!
+	 * \brief Sets the overflow policy
+	 *
+	 * Sets what happens when a message is logged while the queue is full.
+	 * The default is \ref Block.
+	 *
+	 * For \ref DropBelowLevel, messages less severe than \a threshold are
+	 * dropped and the rest wait for room.  \ref Level::error() and
+	 * \ref Level::fatal() messages are never dropped, even if \a threshold
+	 * is set to one of them.
+	 *
+	 * \param policy what to do when the queue is full
+	 * \param threshold the least severe level kept by \ref DropBelowLevel
+	 * \sa droppedCount()
+	 */
+	void setOverflowPolicy(OverflowPolicy policy, const Level &threshold = Level::warn());
+
+	//! Gets the current overflow policy
+	OverflowPolicy overflowPolicy() const;
+
+	//! Gets the \ref DropBelowLevel threshold
+	Level dropThreshold() const;
+
+	/*!
+	 * \brief Dropped messages for a level
+	 *
+	 * The number of messages at \a lev that were dropped because the
+	 * queue was full.
+	 *
+	 * \param lev the level to get the count for
+	 * \return the number of dropped messages
+	 */
+	unsigned long long droppedCount(const Level &lev) const;
+
+	//! Total number of dropped messages for all levels
+	unsigned long long droppedCount() const;
+
+	/*!
+	 * \brief Sets the dropped message report interval
+	 *
+	 * When messages have been dropped, the writer thread writes a warning
+	 * with the counts per level to the wrapped outputter at most every
+	 * \a ms milliseconds.  The logger name of the warning is "sharklog".
+	 * Set to 0 to turn the reports off.
+	 *
+	 * \param ms milliseconds between reports
+	 */
+	void setDropReportInterval(unsigned int ms);
+
+	//! Gets the dropped message report interval in milliseconds
+	unsigned int dropReportInterval() const;
+
+	/*!
+	 * \brief Closes all AsyncOutputters
+	 *
+	 * Calls \ref close() on every AsyncOutputter that exists.  This is called
+	 * by \ref Logger::closeRootLogger().
+	 */
+	static void closeAll();
+
+private:
+	struct Record
+	{
+		Level level;
+		std::string loggerName;
+		std::string message;
+		DeferredMessage deferred;
+		bool isDeferred = false;
+		Location loc;
+		RecordContext ctx;
+	};
+
+	struct Slot
+	{
+		std::atomic<std::size_t> seq;
+		Record record;
+	};
+
+	AsyncOutputter(const AsyncOutputter &);
+	AsyncOutputter &operator=(const AsyncOutputter &);
+
+	bool push(const Level &lev, const std::string &loggerName, const std::string &logMessage, const DeferredMessage *deferred, const Location &loc);
+	template <class Func> bool pop(Func func);
+	bool empty() const;
+	bool overflow(const Level &lev);
+	void drop(const Level &lev);
+	void checkDropReport();
+	void reportDropped();
+	void write(Record &rec);
+	void wakeWriter();
+	void notifyDrained();
+	void run();
+
+	OutputterPtr outputter_;
+	std::vector<Slot> slots_;
+	std::size_t mask_;
+	Record current_;
+
+	// keep the producer and consumer positions on separate cache lines
+	char pad0_[64];
+	std::atomic<std::size_t> tail_;
+	// producers between checking running_ and publishing their record
+	std::atomic<unsigned int> producers_;
+	char pad1_[64];
+	std::atomic<std::size_t> head_;
+	char pad2_[64];
+
+	std::atomic<std::size_t> processed_;
+	std::atomic<bool> running_;
+	std::atomic<bool> sleeping_;
+	std::atomic<int> policy_;
+	std::atomic<int> threshold_;
+	std::atomic<unsigned long long> dropped_[Level::ALL + 1];
+	unsigned long long reported_[Level::ALL + 1];
+	std::atomic<unsigned int> reportInterval_;
+	std::chrono::steady_clock::time_point lastReport_;
+	std::thread writer_;
+	std::mutex mutex_;
+	std::mutex closeMutex_;
+	std::condition_variable wake_;
+	std::condition_variable drained_;
+
+	static std::mutex allMutex_;
+	static std::vector<AsyncOutputter *> all_;
+};
+
+} // sharklog
+
+#endif // asyncoutputter_H
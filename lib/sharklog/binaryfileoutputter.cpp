@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "binaryfileoutputter.h"
+#include "deferredmessage.h"
+#include "logsite.h"
+#include "location.h"
+#include "recordcontext.h"
+#include <sstream>
+#include <functional>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * File layout, numbers are in the byte order of the writer:
+ *
+ *   header  Magic, u16 Version, u32 ByteOrderMark, u8 sizeof(void *)
+ *   entries u8 Entry then its fields, strings are a u32 size and the bytes
+ *
+ *   'S' u32 id, u8 level, u8 has format, i32 line, format, file, function
+ *   'L' u32 id, name
+ *   'T' u32 id, text
+ *   'R' u32 site, i64 ns, u32 thread, u32 logger, u8 level, u32 size, arguments
+ *
+ * Definitions always come before the first record that uses them.
+ */
+const char BinaryFileOutputter::Magic[8] = { 'S', 'H', 'A', 'R', 'K', 'B', 'I', 'N' };
+const std::uint16_t BinaryFileOutputter::Version;
+const std::uint32_t BinaryFileOutputter::ByteOrderMark;
+const std::uint32_t BinaryFileOutputter::LocationSiteBase;
+
+std::size_t BinaryFileOutputter::LocationHash::operator()(const LocationKey &key) const
+{
+	auto h = hash<const void *>()(key.file);
+	h = h * 31 + hash<const void *>()(key.function);
+	return h * 31 + hash<int>()(key.line);
+}
+
+BinaryFileOutputter::BinaryFileOutputter(const std::string &filename)
+	: filename_(filename)
+	, open_(false)
+	, flushLevel_(Level::error())
+	, threadCount_(0)
+{
+}
+
+BinaryFileOutputter::~BinaryFileOutputter()
+{
+	close();
+}
+
+void BinaryFileOutputter::setFilename(const std::string &filename)
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	filename_ = filename;
+}
+
+std::string BinaryFileOutputter::filename() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return filename_;
+}
+
+void BinaryFileOutputter::setFlushLevel(const Level &level)
+{
+	lock_guard<mutex> lock(mutex_);
+	flushLevel_ = level;
+}
+
+Level BinaryFileOutputter::flushLevel() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return flushLevel_;
+}
+
+bool BinaryFileOutputter::open()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+
+	file_.open(filename_.c_str(), ios::out | ios::trunc | ios::binary);
+	if (!file_.is_open())
+		return false;
+
+	file_.write(Magic, sizeof(Magic));
+	writeValue(Version);
+	writeValue(ByteOrderMark);
+	writeValue((std::uint8_t)sizeof(void *));
+	open_ = true;
+	return true;
+}
+
+void BinaryFileOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	if (!isOpen())
+		return;
+
+	DeferredMessage msg;
+	msg.putString(logMessage.data(), logMessage.size());
+
+	auto &args = formatBuffer();
+	args.clear();
+	msg.encode(args);
+	writeRecord(lev, loggerName, nullptr, loc, args);
+}
+
+void BinaryFileOutputter::writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc)
+{
+	if (!isOpen())
+		return;
+
+	auto &args = formatBuffer();
+	args.clear();
+	msg.encode(args);
+	writeRecord(lev, loggerName, msg.site(), loc, args);
+}
+
+void BinaryFileOutputter::close()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+}
+
+bool BinaryFileOutputter::isOpen() const
+{
+	return open_;
+}
+
+bool BinaryFileOutputter::isValid() const
+{
+	return true;
+}
+
+void BinaryFileOutputter::flush()
+{
+	lock_guard<mutex> lock(mutex_);
+	if (file_.is_open())
+		file_.flush();
+}
+
+void BinaryFileOutputter::writeRecord(const Level &lev, const std::string &loggerName, const LogSite *site, const Location &loc, const std::string &args)
+{
+	auto ctx = RecordContext::current();
+	auto ns = (std::int64_t)duration_cast<nanoseconds>(ctx.time().time_since_epoch()).count();
+
+	lock_guard<mutex> lock(mutex_);
+	if (!file_.is_open())
+		return;
+
+	// definitions are written before the record that first uses them
+	auto siteNumber = siteId(site, loc);
+	auto threadNumber = threadId(ctx);
+	auto loggerNumber = loggerId(loggerName);
+
+	file_.put(RecordEntry);
+	writeValue(siteNumber);
+	writeValue(ns);
+	writeValue(threadNumber);
+	writeValue(loggerNumber);
+	writeValue((std::uint8_t)lev.level());
+	writeValue((std::uint32_t)args.size());
+	file_.write(args.data(), args.size());
+
+	// the record without the definitions written for it
+	auto size = 1 + sizeof(siteNumber) + sizeof(ns) + sizeof(threadNumber) + sizeof(loggerNumber) + 1 + 4 + args.size();
+	countFormatted(size);
+	if (file_)
+		countWritten(size);
+	else
+		countWriteError();
+
+	if (flushLevel_.level() != Level::NONE && lev.level() <= flushLevel_.level())
+		file_.flush();
+}
+
+std::uint32_t BinaryFileOutputter::siteId(const LogSite *site, const Location &loc)
+{
+	if (site)
+	{
+		auto id = site->id();
+		if (id >= sites_.size())
+			sites_.resize(id + 1, false);
+		if (!sites_[id])
+		{
+			writeSite(id, site->level(), site->format(), site->location());
+			sites_[id] = true;
+		}
+		return id;
+	}
+
+	LocationKey key = { loc.file(), loc.function(), loc.line() };
+	auto it = locations_.find(key);
+	if (it != locations_.end())
+		return it->second;
+
+	auto id = LocationSiteBase + (std::uint32_t)locations_.size();
+	writeSite(id, Level::NONE, nullptr, loc);
+	locations_[key] = id;
+	return id;
+}
+
+std::uint32_t BinaryFileOutputter::loggerId(const std::string &loggerName)
+{
+	auto it = loggers_.find(loggerName);
+	if (it != loggers_.end())
+		return it->second;
+
+	auto id = (std::uint32_t)loggers_.size();
+	file_.put(LoggerEntry);
+	writeValue(id);
+	writeString(loggerName.data(), loggerName.size());
+	loggers_[loggerName] = id;
+	return id;
+}
+
+std::uint32_t BinaryFileOutputter::threadId(const RecordContext &ctx)
+{
+	auto it = threads_.find(ctx.threadId());
+	if (it != threads_.end() && it->second.name == ctx.sharedThreadName())
+		return it->second.number;
+
+	// the same text the layouts print for the thread
+	std::string text;
+	if (ctx.threadName())
+		text = *ctx.threadName();
+	else
+	{
+		stringstream ss;
+		ss << "0x" << hex << ctx.threadId();
+		text = ss.str();
+	}
+
+	auto number = threadCount_++;
+	file_.put(ThreadEntry);
+	writeValue(number);
+	writeString(text.data(), text.size());
+	threads_[ctx.threadId()] = Thread { number, ctx.sharedThreadName() };
+	return number;
+}
+
+void BinaryFileOutputter::writeSite(std::uint32_t id, Level::LogLevel level, const char *format, const Location &loc)
+{
+	file_.put(SiteEntry);
+	writeValue(id);
+	writeValue((std::uint8_t)level);
+	writeValue((std::uint8_t)(format != nullptr));
+	writeValue((std::int32_t)loc.line());
+	writeString(format ? format : "", format ? strlen(format) : 0);
+	writeString(loc.file(), strlen(loc.file()));
+	writeString(loc.function(), strlen(loc.function()));
+}
+
+void BinaryFileOutputter::writeString(const char *text, std::size_t size)
+{
+	writeValue((std::uint32_t)size);
+	file_.write(text, size);
+}
+
+void BinaryFileOutputter::closeFile()
+{
+	open_ = false;
+	if (file_.is_open())
+		file_.close();
+
+	// a new file needs its own definitions
+	sites_.clear();
+	locations_.clear();
+	loggers_.clear();
+	threads_.clear();
+	threadCount_ = 0;
+}
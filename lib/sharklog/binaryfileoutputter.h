@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __binaryfileoutputter_H
+#define __binaryfileoutputter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/outputter.h>
+#include <sharklog/level.h>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+namespace sharklog
+{
+
+class LogSite;
+class RecordContext;
+
+/*!
+ * \brief File outputter that writes binary records instead of text
+ *
+ * Nothing is formatted when a record is written.  Each record is the id of
+ * its call site, the time, the thread, the logger and the packed arguments of
+ * its \ref DeferredMessage.  The format string and location of a site, the
+ * name of a logger and the id of a thread are written once per file, the
+ * first time a record uses them.
+ *
+ * Records from the SHARKLOG_BINARY_* macros are written as they are.  Other
+ * records, from the SHARKLOG_* and SHARKLOG_DEFER_* macros, get a site for
+ * their location without a format string and their text or arguments.
+ *
+ * The file is turned back into text with \ref BinaryLogReader and a
+ * \ref Layout, or with the sharklog-decode tool:
+ *
+ * \code
+ * sharklog-decode /tmp/test.slb
+ * sharklog-decode -p "%d %-5p [%c] %m%n" /tmp/test.slb
+ * \endcode
+ *
+ * Numbers are written in the byte order of the machine, files are decoded on
+ * the same kind of machine that wrote them.  The outputter doesn't need a
+ * layout.
+ *
+ * \code
+ * auto bop = std::make_shared<BinaryFileOutputter>("/tmp/test.slb");
+ * if (!bop->open())
+ *    return 1; // fail
+ * Logger::rootLogger()->addOutputter(bop);
+ * SHARKLOG_BINARY_INFO(Logger::rootLogger(), "order {} filled at {}", id, price);
+ * \endcode
+ */
+class SHARKLOGAPI BinaryFileOutputter : public Outputter
+{
+public:
+	//! Bytes at the start of every binary log file
+	static const char Magic[8];
+
+	//! Version of the file format
+	static const std::uint16_t Version = 1;
+
+	//! Written after \ref Magic so readers can tell the byte order matches
+	static const std::uint32_t ByteOrderMark = 0x01020304;
+
+	//! Site ids at or above this are for locations without a \ref LogSite
+	static const std::uint32_t LocationSiteBase = 0x80000000u;
+
+	//! The first byte of each entry after the header
+	enum Entry : char
+	{
+		SiteEntry = 'S' //!< id, level, has format, line, format, file, function
+		, LoggerEntry = 'L' //!< id, name
+		, ThreadEntry = 'T' //!< id, thread id text
+		, RecordEntry = 'R' //!< site, nanoseconds since the epoch, thread, logger, level, arguments
+	};
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * \param filename the file path to the file you want to write
+	 * \sa setFilename()
+	 */
+	BinaryFileOutputter(const std::string &filename = std::string());
+
+	//! Destructor, closes the file
+	virtual ~BinaryFileOutputter();
+
+	/*!
+	 * \brief Sets the file name/path
+	 *
+	 * Closes the file if it is open, see \ref close().
+	 *
+	 * \param filename the filename and path for the log file
+	 */
+	void setFilename(const std::string &filename);
+
+	//! Gets the file name and path for the log file
+	std::string filename() const;
+
+	/*!
+	 * \brief Sets the level that is flushed straight away
+	 *
+	 * Records at \a level or more severe are flushed to the file as soon as
+	 * they are written.  Level() (NONE) turns this off, the default is
+	 * Level::error().
+	 */
+	void setFlushLevel(const Level &level);
+
+	//! Gets the level that is flushed straight away
+	Level flushLevel() const;
+
+	/*!
+	 * \brief Open the log file
+	 *
+	 * The file is always truncated, a binary log starts with its header.
+	 *
+	 * \return true if opened, false if failed
+	 */
+	virtual bool open() override;
+
+	//! Writes a text record, its message is the only argument
+	virtual void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+	//! Writes the arguments of \a msg without formatting them
+	virtual void writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc) override;
+
+	//! Closes the file
+	virtual void close() override;
+
+	//! Checks to see if the file is open
+	virtual bool isOpen() const override;
+
+	//! Always true, binary records don't need a layout
+	virtual bool isValid() const override;
+
+	//! Flushes the file
+	void flush();
+
+private:
+	BinaryFileOutputter(const BinaryFileOutputter &);
+	BinaryFileOutputter &operator=(const BinaryFileOutputter &);
+
+	// location of a record without a site
+	struct LocationKey
+	{
+		const char *file;
+		const char *function;
+		int line;
+
+		bool operator==(const LocationKey &other) const
+		{
+			return file == other.file && function == other.function && line == other.line;
+		}
+	};
+
+	struct LocationHash
+	{
+		std::size_t operator()(const LocationKey &key) const;
+	};
+
+	void writeRecord(const Level &lev, const std::string &loggerName, const LogSite *site, const Location &loc, const std::string &args);
+	std::uint32_t siteId(const LogSite *site, const Location &loc);
+	std::uint32_t loggerId(const std::string &loggerName);
+	std::uint32_t threadId(const RecordContext &ctx);
+	void writeSite(std::uint32_t id, Level::LogLevel level, const char *format, const Location &loc);
+	void writeString(const char *text, std::size_t size);
+	void closeFile();
+
+	template <class T>
+	void writeValue(const T &value)
+	{
+		file_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+	}
+
+private:
+	std::string filename_;
+	std::ofstream file_;
+	std::atomic<bool> open_;
+	Level flushLevel_;
+	std::vector<bool> sites_;
+	std::unordered_map<LocationKey, std::uint32_t, LocationHash> locations_;
+	std::unordered_map<std::string, std::uint32_t> loggers_;
+	// the name is kept so a renamed thread is noticed
+	struct Thread
+	{
+		std::uint32_t number;
+		std::shared_ptr<const std::string> name;
+	};
+
+	std::unordered_map<std::thread::id, Thread> threads_;
+	std::uint32_t threadCount_;
+	mutable std::mutex mutex_;
+};
+
+} // sharklog
+
+#endif // binaryfileoutputter_H
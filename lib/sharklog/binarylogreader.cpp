@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "binarylogreader.h"
+#include "binaryfileoutputter.h"
+#include <cstring>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+BinaryLogReader::BinaryLogReader(const std::string &filename)
+	: filename_(filename)
+	, size_(0)
+{
+}
+
+void BinaryLogReader::setFilename(const std::string &filename)
+{
+	close();
+	filename_ = filename;
+}
+
+std::string BinaryLogReader::filename() const
+{
+	return filename_;
+}
+
+bool BinaryLogReader::open()
+{
+	close();
+
+	file_.open(filename_.c_str(), ios::in | ios::binary);
+	if (!file_.is_open())
+		return fail("can't open the file");
+
+	// sizes are checked against it so a damaged one can't allocate gigabytes
+	file_.seekg(0, ios::end);
+	size_ = file_.tellg();
+	file_.seekg(0, ios::beg);
+
+	char magic[sizeof(BinaryFileOutputter::Magic)];
+	std::uint16_t version = 0;
+	std::uint32_t mark = 0;
+	std::uint8_t pointerSize = 0;
+	if (!file_.read(magic, sizeof(magic)) || memcmp(magic, BinaryFileOutputter::Magic, sizeof(magic)))
+		return fail("not a binary log file");
+	if (!readValue(version) || !readValue(mark) || !readValue(pointerSize))
+		return fail("the header is cut short");
+	if (version != BinaryFileOutputter::Version)
+		return fail("unsupported binary log version");
+	if (mark != BinaryFileOutputter::ByteOrderMark || pointerSize != sizeof(void *))
+		return fail("written on a machine with a different byte order or word size");
+
+	return true;
+}
+
+void BinaryLogReader::close()
+{
+	if (file_.is_open())
+		file_.close();
+	file_.clear();
+	error_.clear();
+	sites_.clear();
+	loggers_.clear();
+	threads_.clear();
+}
+
+bool BinaryLogReader::isOpen() const
+{
+	return file_.is_open();
+}
+
+bool BinaryLogReader::next(Record &rec)
+{
+	if (!file_.is_open() || !error_.empty())
+		return false;
+
+	// definitions come before the records that use them
+	for (;;)
+	{
+		auto entry = file_.get();
+		if (entry == char_traits<char>::eof())
+			return false;
+
+		switch (entry)
+		{
+		case BinaryFileOutputter::SiteEntry:
+			if (!readSite())
+				return false;
+			break;
+		case BinaryFileOutputter::LoggerEntry:
+			if (!readName(loggers_))
+				return false;
+			break;
+		case BinaryFileOutputter::ThreadEntry:
+			if (!readName(threads_))
+				return false;
+			break;
+		case BinaryFileOutputter::RecordEntry:
+			return readRecord(rec);
+		default:
+			return fail("unknown entry");
+		}
+	}
+}
+
+std::string BinaryLogReader::error() const
+{
+	return error_;
+}
+
+bool BinaryLogReader::readSite()
+{
+	std::uint32_t id;
+	std::uint8_t level;
+	std::uint8_t hasFormat;
+	std::int32_t line;
+	Site site;
+	if (!readValue(id) || !readValue(level) || !readValue(hasFormat) || !readValue(line)
+		|| !readString(site.format) || !readString(site.file) || !readString(site.function))
+		return fail("a site is cut short");
+
+	site.level = (Level::LogLevel)level;
+	site.hasFormat = hasFormat != 0;
+	site.line = line;
+	sites_[id] = std::move(site);
+	return true;
+}
+
+bool BinaryLogReader::readName(std::unordered_map<std::uint32_t, std::string> &names)
+{
+	std::uint32_t id;
+	std::string name;
+	if (!readValue(id) || !readString(name))
+		return fail("a definition is cut short");
+
+	names[id] = std::move(name);
+	return true;
+}
+
+bool BinaryLogReader::readRecord(Record &rec)
+{
+	std::uint32_t siteId, threadId, loggerId, size;
+	std::int64_t ns;
+	std::uint8_t level;
+	if (!readValue(siteId) || !readValue(ns) || !readValue(threadId) || !readValue(loggerId)
+		|| !readValue(level) || !readValue(size))
+		return fail("a record is cut short");
+
+	if (size > remaining())
+		return fail("a record is cut short");
+
+	args_.resize(size);
+	if (size && !file_.read(&args_[0], size))
+		return fail("a record is cut short");
+
+	auto site = sites_.find(siteId);
+	auto thread = threads_.find(threadId);
+	auto logger = loggers_.find(loggerId);
+	if (site == sites_.end() || thread == threads_.end() || logger == loggers_.end())
+		return fail("a record uses an undefined site, thread or logger");
+	if (!msg_.decode(args_.data(), args_.size()))
+		return fail("a record has damaged arguments");
+
+	rec.level = Level((Level::LogLevel)level);
+	rec.loggerName = logger->second;
+	rec.message.clear();
+	if (site->second.hasFormat)
+		msg_.format(rec.message, site->second.format.c_str());
+	else
+		msg_.format(rec.message);
+
+	// the site and thread strings live as long as the maps
+	rec.location = Location(site->second.file.c_str(), site->second.function.c_str(), site->second.line);
+	auto time = RecordContext::Clock::time_point(duration_cast<RecordContext::Clock::duration>(nanoseconds(ns)));
+	rec.context = RecordContext(time, thread->second.c_str());
+	return true;
+}
+
+bool BinaryLogReader::readString(std::string &text)
+{
+	std::uint32_t size;
+	if (!readValue(size) || size > remaining())
+		return false;
+
+	text.resize(size);
+	return !size || (bool)file_.read(&text[0], size);
+}
+
+std::uint64_t BinaryLogReader::remaining()
+{
+	std::streamoff pos = file_.tellg();
+	return pos < 0 || pos > size_ ? 0 : (std::uint64_t)(size_ - pos);
+}
+
+bool BinaryLogReader::fail(const char *what)
+{
+	error_ = what;
+	return false;
+}
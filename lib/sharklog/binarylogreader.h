@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __binarylogreader_H
+#define __binarylogreader_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/level.h>
+#include <sharklog/location.h>
+#include <sharklog/recordcontext.h>
+#include <sharklog/deferredmessage.h>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Reads the records of a \ref BinaryFileOutputter file
+ *
+ * Each call to \ref next() reads one record and formats its message.  The
+ * record can then be formatted with any \ref Layout, pin its context so the
+ * layout uses the time and thread from the file:
+ *
+ * \code
+ * BinaryLogReader reader("/tmp/test.slb");
+ * if (!reader.open())
+ *    return 1; // reader.error() says why
+ *
+ * StandardLayout layout;
+ * BinaryLogReader::Record rec;
+ * while (reader.next(rec))
+ * {
+ *    std::string text;
+ *    RecordContext::Scope pin(rec.context);
+ *    layout.formatRecord(text, rec.level, rec.loggerName, rec.message, rec.location);
+ *    std::cout << text;
+ * }
+ * \endcode
+ */
+class SHARKLOGAPI BinaryLogReader
+{
+public:
+	//! A record read from the file
+	struct Record
+	{
+		//! The level it was logged at
+		Level level;
+
+		//! Name of the logger it was logged to
+		std::string loggerName;
+
+		//! The formatted message
+		std::string message;
+
+		//! Where it was logged, valid until the reader is closed
+		Location location;
+
+		//! When and by which thread it was logged, valid until the reader is closed
+		RecordContext context;
+	};
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * \param filename the binary log file to read
+	 */
+	BinaryLogReader(const std::string &filename = std::string());
+
+	//! Sets the file to read, closes the current one
+	void setFilename(const std::string &filename);
+
+	//! Gets the file name
+	std::string filename() const;
+
+	/*!
+	 * \brief Opens the file and checks its header
+	 *
+	 * \return false if it can't be opened or isn't a binary log written on
+	 * this kind of machine, see \ref error()
+	 */
+	bool open();
+
+	//! Closes the file
+	void close();
+
+	//! True if the file is open
+	bool isOpen() const;
+
+	/*!
+	 * \brief Reads the next record
+	 *
+	 * \return false at the end of the file or if it is damaged, \ref error()
+	 * is empty at the end
+	 */
+	bool next(Record &rec);
+
+	//! Why \ref open() or \ref next() failed, empty if they didn't
+	std::string error() const;
+
+private:
+	BinaryLogReader(const BinaryLogReader &);
+	BinaryLogReader &operator=(const BinaryLogReader &);
+
+	struct Site
+	{
+		Level::LogLevel level;
+		bool hasFormat;
+		std::string format;
+		std::string file;
+		std::string function;
+		int line;
+	};
+
+	bool readSite();
+	bool readName(std::unordered_map<std::uint32_t, std::string> &names);
+	bool readRecord(Record &rec);
+	bool readString(std::string &text);
+	std::uint64_t remaining();
+	bool fail(const char *what);
+
+	template <class T>
+	bool readValue(T &value)
+	{
+		return (bool)file_.read(reinterpret_cast<char *>(&value), sizeof(T));
+	}
+
+	std::string filename_;
+	std::ifstream file_;
+	std::streamoff size_;
+	std::string error_;
+	std::unordered_map<std::uint32_t, Site> sites_;
+	std::unordered_map<std::uint32_t, std::string> loggers_;
+	std::unordered_map<std::uint32_t, std::string> threads_;
+	std::string args_;
+	DeferredMessage msg_;
+};
+
+} // sharklog
+
+#endif // binarylogreader_H
@@ -24,16 +24,78 @@
 
 #include "consoleoutputter.h"
 #include <iostream>
+#include <cerrno>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 using namespace sharklog;
 using namespace std;
+using namespace std::chrono;
 
+const std::size_t ConsoleOutputter::DefaultBufferSize;
+const unsigned int ConsoleOutputter::DefaultFlushInterval;
 std::mutex ConsoleOutputter::mutex_;
 
+namespace
+{
+    // file descriptors for ConsoleOutputter::Stream
+    const int fds_[] = { 2, 1 };
+
+    bool terminal(int fd)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return _isatty(fd) != 0;
+#else
+        return isatty(fd) != 0;
+#endif
+    }
+
+    // returns the number of bytes written, less than size if a write failed
+    std::size_t writeAll(int fd, const char *data, std::size_t size)
+    {
+        std::size_t written = 0;
+        while (size)
+        {
+#if defined(_WIN32) || defined(_WIN64)
+            auto res = _write(fd, data, (unsigned int)size);
+#else
+            auto res = ::write(fd, data, size);
+#endif
+            if (res < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return written;
+            }
+            data += res;
+            size -= res;
+            written += res;
+        }
+        return written;
+    }
+}
+
 ConsoleOutputter::ConsoleOutputter()
     : useStdOut_(true)
     , useStdErr_(false)
+    , mode_(Streams)
+    , buffering_(AutoBuffering)
+    , bufferSize_(DefaultBufferSize)
+    , flushInterval_(DefaultFlushInterval)
+    , flushLevel_(Level::error())
+    , lastFlush_(steady_clock::now())
+{
+    tty_[Err] = terminal(fds_[Err]);
+    tty_[Out] = terminal(fds_[Out]);
+}
+
+ConsoleOutputter::~ConsoleOutputter()
 {
+    flush();
 }
 
 bool ConsoleOutputter::open()
@@ -43,6 +105,7 @@ bool ConsoleOutputter::open()
 
 void ConsoleOutputter::close()
 {
+    flush();
 }
 
 bool ConsoleOutputter::isOpen() const
@@ -54,22 +117,49 @@ void ConsoleOutputter::writeLog(const Level &lev, const std::string &loggerName,
 {
     if (!isValid())
         return;
+
+    auto &log = formatBuffer();
+    log.clear();
+    layout()->formatRecord(log, lev, loggerName, message, loc);
+    countFormatted(log.size());
+
+    if (mode_ == Buffered)
+    {
+        writeBuffered(lev, log);
+        return;
+    }
     
     lock_guard<mutex> lock(mutex_);
     
-    string log;
-    layout()->appendHeader(log);
-    layout()->formatMessage(log, lev, loggerName, message);
-    layout()->appendFooter(log);
-    
     if (useStdErr_)
+    {
         cerr << log;
+        cerr.flush();
+        countStream(cerr, log.size());
+    }
     
     if (useStdOut_)
+    {
         cout << log;
-    
-    cerr.flush();
-    cout.flush();
+        cout.flush();
+        countStream(cout, log.size());
+    }
+}
+
+void ConsoleOutputter::countStream(const std::ostream &stream, std::size_t size)
+{
+    if (stream)
+        countWritten(size);
+    else
+        countWriteError();
+}
+
+void ConsoleOutputter::writeFd(int fd, const char *data, std::size_t size)
+{
+    auto written = writeAll(fd, data, size);
+    countWritten(written);
+    if (written < size)
+        countWriteError();
 }
 
 void ConsoleOutputter::setUseStdOut(bool use)
@@ -91,3 +181,134 @@ bool ConsoleOutputter::useStdErr() const
 {
     return useStdErr_;
 }
+
+void ConsoleOutputter::setMode(Mode mode)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    if (mode_ == Buffered && mode != Buffered)
+        flushBuffers();
+    mode_ = mode;
+}
+
+ConsoleOutputter::Mode ConsoleOutputter::mode() const
+{
+    return mode_;
+}
+
+void ConsoleOutputter::setBuffering(Buffering buffering)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    buffering_ = buffering;
+}
+
+ConsoleOutputter::Buffering ConsoleOutputter::buffering() const
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    return buffering_;
+}
+
+void ConsoleOutputter::setBufferSize(std::size_t bytes)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    bufferSize_ = bytes;
+}
+
+std::size_t ConsoleOutputter::bufferSize() const
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    return bufferSize_;
+}
+
+void ConsoleOutputter::setFlushInterval(unsigned int ms)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    flushInterval_ = ms;
+}
+
+unsigned int ConsoleOutputter::flushInterval() const
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    return flushInterval_;
+}
+
+void ConsoleOutputter::setFlushLevel(const Level &level)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    flushLevel_ = level;
+}
+
+Level ConsoleOutputter::flushLevel() const
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    return flushLevel_;
+}
+
+void ConsoleOutputter::flush()
+{
+    lock_guard<mutex> lock(bufferMutex_);
+    flushBuffers();
+}
+
+bool ConsoleOutputter::isLineBuffered(Stream stream) const
+{
+    return buffering_ == LineBuffering || (buffering_ == AutoBuffering && tty_[stream]);
+}
+
+void ConsoleOutputter::writeBuffered(const Level &lev, const std::string &record)
+{
+    lock_guard<mutex> lock(bufferMutex_);
+
+    auto urgent = flushLevel_.level() != Level::NONE && lev.level() <= flushLevel_.level();
+    auto now = steady_clock::now();
+    auto due = flushInterval_ && now - lastFlush_ >= milliseconds(flushInterval_);
+
+    const bool use[] = { useStdErr_, useStdOut_ };
+    for (int s=Err;s<=Out;++s)
+    {
+        if (!use[s])
+            continue;
+
+        auto &buffer = buffers_[s];
+        if (!buffer.empty() && buffer.size() + record.size() > bufferSize_)
+        {
+            writeFd(fds_[s], buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        if (urgent || due || isLineBuffered((Stream)s) || record.size() >= bufferSize_)
+        {
+            // write what was buffered with this record, in one call if it fits
+            if (buffer.empty())
+                writeFd(fds_[s], record.data(), record.size());
+            else
+            {
+                buffer += record;
+                writeFd(fds_[s], buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        else
+        {
+            if (buffer.capacity() < bufferSize_)
+                buffer.reserve(bufferSize_);
+            buffer += record;
+        }
+    }
+
+    if (due || urgent)
+        flushBuffers();
+}
+
+void ConsoleOutputter::flushBuffers()
+{
+    // called with bufferMutex_ held
+    for (int s=Err;s<=Out;++s)
+    {
+        if (!buffers_[s].empty())
+        {
+            writeFd(fds_[s], buffers_[s].data(), buffers_[s].size());
+            buffers_[s].clear();
+        }
+    }
+    lastFlush_ = steady_clock::now();
+}
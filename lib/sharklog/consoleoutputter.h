@@ -27,7 +27,13 @@
 
 #include <sharklog/sharklogdefs.h>
 #include <sharklog/outputter.h>
+#include <sharklog/level.h>
+#include <string>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
 
 namespace sharklog
 {
@@ -43,12 +49,51 @@ namespace sharklog
  * It helps with console debugging while developing as well as 
  * for end users to see any warnings/error issues that might pop 
  * up. 
+ *
+ * By default every record is written through std::cout/std::cerr and flushed
+ * straight away.  In \ref Buffered mode records are collected in a buffer
+ * per stream and written to file descriptor 1 or 2 with write(), which is much
+ * cheaper when stdout is a pipe or a file.  The buffer is written when it
+ * reaches \ref bufferSize(), when a record comes in \ref flushInterval()
+ * milliseconds after the last write (nothing is written while no records
+ * come in), for records at \ref flushLevel() or more severe, and after every
+ * record when the stream is line buffered.  With \ref AutoBuffering streams
+ * going to a terminal are line buffered and everything else is block
+ * buffered.
+ *
+ * Buffered records bypass std::cout, so anything else printed with it can
+ * show up out of order.  Call \ref flush() or \ref close() before exiting or
+ * the end of the buffer is lost.
  */
 class SHARKLOGAPI ConsoleOutputter : public Outputter
 {
 public:
+	//! How records get to the console
+	enum Mode
+	{
+		Streams //!< through std::cout and std::cerr, flushed after each record (the default)
+		, Buffered //!< buffered and written to file descriptors 1 and 2
+	};
+
+	//! When \ref Buffered mode writes its buffer besides the other triggers
+	enum Buffering
+	{
+		AutoBuffering //!< line buffered on a terminal, block buffered otherwise
+		, LineBuffering //!< after every record
+		, BlockBuffering //!< only on size, time or level
+	};
+
+	//! Default buffer size per stream in \ref Buffered mode
+	static const std::size_t DefaultBufferSize = 32 * 1024;
+
+	//! Default milliseconds records can wait in the buffer
+	static const unsigned int DefaultFlushInterval = 1000;
+
 	//! Constructor
     ConsoleOutputter();
+
+	//! Destructor, writes anything buffered
+	virtual ~ConsoleOutputter();
     
 	/*!
 	 * \brief Opens the outputter 
@@ -63,7 +108,7 @@ public:
 	/*!
 	 * \brief Close outputter 
 	 *  
-	 * This function is not used on the console outputter. 
+	 * Writes anything buffered, the outputter can still be used after.
 	 * 
 	 */
     void close() final;
@@ -114,10 +159,76 @@ public:
 	 * \return bool true allowed to use stderr, false if not
 	 */
     bool useStdErr() const;
+
+	/*!
+	 * \brief Sets the output mode
+	 *
+	 * Switching from \ref Buffered writes anything buffered first.
+	 *
+	 * \param mode \ref Streams or \ref Buffered
+	 */
+	void setMode(Mode mode);
+
+	//! Gets the output mode
+	Mode mode() const;
+
+	//! Sets when \ref Buffered mode writes, \ref AutoBuffering by default
+	void setBuffering(Buffering buffering);
+
+	//! Gets the buffering
+	Buffering buffering() const;
+
+	//! Sets the buffer size per stream, records are written once it fills
+	void setBufferSize(std::size_t bytes);
+
+	//! Gets the buffer size per stream
+	std::size_t bufferSize() const;
+
+	/*!
+	 * \brief Writes the buffers when a record comes in \a ms milliseconds after the last write
+	 *
+	 * The interval is only checked when a record is written, there is no
+	 * timer.  Records buffered before the outputter goes quiet stay in the
+	 * buffer until the next record, \ref flush() or \ref close(), so call
+	 * \ref flush() yourself if they have to show up while nothing is logged.
+	 *
+	 * \param ms the interval, 0 turns this off
+	 */
+	void setFlushInterval(unsigned int ms);
+
+	//! Gets the flush interval in milliseconds
+	unsigned int flushInterval() const;
+
+	//! Records at \a level or more severe are written straight away, Level() (NONE) turns this off
+	void setFlushLevel(const Level &level);
+
+	//! Gets the level that is written straight away, Level::error() by default
+	Level flushLevel() const;
+
+	//! Writes anything buffered
+	void flush();
     
+private:
+	enum Stream { Err, Out };
+
+	bool isLineBuffered(Stream stream) const;
+	void writeBuffered(const Level &lev, const std::string &record);
+	void flushBuffers();
+	void writeFd(int fd, const char *data, std::size_t size);
+	void countStream(const std::ostream &stream, std::size_t size);
+
 private:
     bool useStdOut_;
     bool useStdErr_;
+	std::atomic<Mode> mode_;
+	Buffering buffering_;
+	bool tty_[2];
+	std::string buffers_[2];
+	std::size_t bufferSize_;
+	unsigned int flushInterval_;
+	Level flushLevel_;
+	std::chrono::steady_clock::time_point lastFlush_;
+	mutable std::mutex bufferMutex_;
     static std::mutex mutex_;
 };
     
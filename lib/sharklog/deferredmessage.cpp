@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "deferredmessage.h"
+#include "logsite.h"
+#include <cstdio>
+#include <cinttypes>
+
+using namespace sharklog;
+using namespace std;
+
+const std::size_t DeferredMessage::Capacity;
+
+namespace
+{
+	template <class T>
+	T read(const char *data)
+	{
+		T value;
+		memcpy(&value, data, sizeof(T));
+		return value;
+	}
+
+	// same text as streaming the value into a std::ostream with default flags
+	void appendSigned(std::string &result, long long value)
+	{
+		char buffer[32];
+		auto len = snprintf(buffer, sizeof(buffer), "%lld", value);
+		result.append(buffer, len);
+	}
+
+	void appendUnsigned(std::string &result, unsigned long long value)
+	{
+		char buffer[32];
+		auto len = snprintf(buffer, sizeof(buffer), "%llu", value);
+		result.append(buffer, len);
+	}
+
+	void appendDouble(std::string &result, double value)
+	{
+		char buffer[64];
+		auto len = snprintf(buffer, sizeof(buffer), "%g", value);
+		result.append(buffer, len);
+	}
+
+	void appendPointer(std::string &result, const void *value)
+	{
+		if (!value)
+		{
+			result += '0';
+			return;
+		}
+
+		char buffer[32];
+		auto len = snprintf(buffer, sizeof(buffer), "0x%" PRIxPTR, (uintptr_t)value);
+		result.append(buffer, len);
+	}
+}
+
+std::size_t DeferredMessage::appendValue(std::string &result, char tag, const char *data)
+{
+	switch (tag)
+	{
+	case Signed:
+		appendSigned(result, read<long long>(data));
+		return sizeof(long long);
+	case Unsigned:
+		appendUnsigned(result, read<unsigned long long>(data));
+		return sizeof(unsigned long long);
+	case Double:
+		appendDouble(result, read<double>(data));
+		return sizeof(double);
+	case Bool:
+		result += read<bool>(data) ? '1' : '0';
+		return sizeof(bool);
+	case Char:
+		result += read<char>(data);
+		return sizeof(char);
+	case Pointer:
+		appendPointer(result, read<const void *>(data));
+		return sizeof(const void *);
+	case Literal:
+		result += read<const char *>(data);
+		return sizeof(const char *);
+	default: // String
+	{
+		auto len = read<std::uint32_t>(data);
+		result.append(data + sizeof(len), len);
+		return sizeof(len) + len;
+	}
+	}
+}
+
+std::size_t DeferredMessage::valueSize(char tag, const char *data)
+{
+	switch (tag)
+	{
+	case Signed: return sizeof(long long);
+	case Unsigned: return sizeof(unsigned long long);
+	case Double: return sizeof(double);
+	case Bool: return sizeof(bool);
+	case Char: return sizeof(char);
+	case Pointer: return sizeof(const void *);
+	case Literal: return sizeof(const char *);
+	default: return sizeof(std::uint32_t) + read<std::uint32_t>(data); // String
+	}
+}
+
+DeferredMessage::DeferredMessage(const DeferredMessage &other)
+	: size_(other.size_)
+	, heap_(other.heap_)
+	, site_(other.site_)
+{
+	if (heap_.empty())
+		memcpy(data_, other.data_, size_);
+}
+
+DeferredMessage &DeferredMessage::operator=(const DeferredMessage &other)
+{
+	if (this != &other)
+	{
+		if (other.heap_.empty())
+		{
+			memcpy(data_, other.data_, other.size_);
+			heap_.clear();
+		}
+		else
+			heap_ = other.heap_;
+		size_ = other.size_;
+		site_ = other.site_;
+	}
+	return *this;
+}
+
+void DeferredMessage::format(std::string &result) const
+{
+	if (site_)
+	{
+		format(result, site_->format());
+		return;
+	}
+
+	auto data = this->data();
+	auto size = bytes();
+	std::size_t pos = 0;
+	while (pos < size)
+	{
+		auto tag = data[pos++];
+		pos += appendValue(result, tag, data + pos);
+	}
+}
+
+void DeferredMessage::format(std::string &result, const char *pattern) const
+{
+	auto data = this->data();
+	auto size = bytes();
+	std::size_t pos = 0;
+
+	while (*pattern)
+	{
+		auto next = strstr(pattern, "{}");
+		if (!next)
+		{
+			result += pattern;
+			break;
+		}
+
+		result.append(pattern, next - pattern);
+		if (pos < size)
+		{
+			auto tag = data[pos++];
+			pos += appendValue(result, tag, data + pos);
+		}
+		else
+			result.append(next, 2);
+		pattern = next + 2;
+	}
+
+	// arguments without a {} go at the end
+	while (pos < size)
+	{
+		auto tag = data[pos++];
+		pos += appendValue(result, tag, data + pos);
+	}
+}
+
+std::string DeferredMessage::str() const
+{
+	std::string result;
+	format(result);
+	return result;
+}
+
+void DeferredMessage::clear()
+{
+	size_ = 0;
+	heap_.clear();
+}
+
+void DeferredMessage::encode(std::string &result) const
+{
+	auto data = this->data();
+	auto size = bytes();
+	std::size_t pos = 0;
+	while (pos < size)
+	{
+		auto start = pos;
+		auto tag = data[pos++];
+		if (tag == Literal)
+		{
+			// the pointer means nothing outside this process, copy the text
+			auto text = read<const char *>(data + pos);
+			auto len = (std::uint32_t)strlen(text);
+			result += (char)String;
+			result.append((const char *)&len, sizeof(len));
+			result.append(text, len);
+			pos += sizeof(const char *);
+			continue;
+		}
+
+		pos += valueSize(tag, data + pos);
+		result.append(data + start, pos - start);
+	}
+}
+
+bool DeferredMessage::decode(const char *data, std::size_t size)
+{
+	clear();
+
+	// check every value is complete before keeping any of them
+	std::size_t pos = 0;
+	while (pos < size)
+	{
+		auto tag = data[pos++];
+
+		// literals are never encoded
+		if (tag < Signed || tag > String || tag == Literal)
+			return false;
+		if (tag == String && size - pos < sizeof(std::uint32_t))
+			return false;
+
+		auto valueSize = DeferredMessage::valueSize(tag, data + pos);
+		if (size - pos < valueSize)
+			return false;
+		pos += valueSize;
+	}
+
+	if (size)
+		memcpy(reserve(size), data, size);
+	return true;
+}
+
+char *DeferredMessage::grow(std::size_t bytes)
+{
+	if (heap_.empty())
+		heap_.assign(data_, size_);
+
+	auto used = heap_.size();
+	heap_.resize(used + bytes);
+	return &heap_[used];
+}
@@ -0,0 +1,337 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __deferredmessage_H
+#define __deferredmessage_H
+
+#include <sharklog/sharklogdefs.h>
+#include <string>
+#include <sstream>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace sharklog
+{
+
+class LogSite;
+
+/*!
+ * \brief A string captured by pointer instead of copied
+ *
+ * Wrap a string literal in it to save copying it into a \ref DeferredMessage.
+ * Only the pointer is kept, so the string must outlive the record, which is
+ * only guaranteed for literals.
+ *
+ * \code
+ * SHARKLOG_DEFER_INFO(log, DeferredLiteral("order "), id);
+ * \endcode
+ */
+struct DeferredLiteral
+{
+	//! Constructor, \a text must outlive the records it is captured in
+	explicit DeferredLiteral(const char *text) : text(text) { }
+
+	//! The string
+	const char *text;
+};
+
+/*!
+ * \brief Log message arguments captured now and formatted later
+ *
+ * A DeferredMessage copies the raw values of its arguments into a small
+ * inline buffer, it doesn't format or allocate.  \ref format() turns them
+ * into text the same way streaming them into a std::ostream would, which
+ * \ref AsyncOutputter does on its writer thread.  See the SHARKLOG_DEFER_*
+ * macros in logger.h.
+ *
+ * How arguments are captured:
+ *
+ * - integers, enums, floating point, bool, char and pointers by value
+ * - char arrays, const char * and std::string by copy, string literals too
+ * - a \ref DeferredLiteral by pointer, the string must outlive the record
+ * - anything else that can be streamed with operator<< is formatted straight
+ *   away and copied as text
+ *
+ * When the arguments don't fit in \ref Capacity bytes they are moved to the
+ * heap, it is still correct, just not free.
+ *
+ * A message from the SHARKLOG_BINARY_* macros also has a \ref LogSite, its
+ * format string says where the arguments go.  \ref encode() and \ref decode()
+ * turn the arguments into bytes that can be written to a file and read back,
+ * see \ref BinaryFileOutputter.
+ */
+class SHARKLOGAPI DeferredMessage
+{
+public:
+	//! Bytes of captured arguments that fit before they are moved to the heap
+	static const std::size_t Capacity = 160;
+
+	//! Constructor, an empty message for \a site, if any
+	explicit DeferredMessage(const LogSite *site = nullptr) : size_(0), site_(site) { }
+
+	//! Copies the captured arguments
+	DeferredMessage(const DeferredMessage &other);
+
+	//! Copies the captured arguments
+	DeferredMessage &operator=(const DeferredMessage &other);
+
+	//! Captures \a args, after anything captured already
+	template <class... Args>
+	void capture(const Args &... args);
+
+	/*!
+	 * \brief Appends the formatted message to \a result
+	 *
+	 * Without a \ref site() the arguments are appended one after the other,
+	 * with one they replace the {} in the site's format string.
+	 */
+	void format(std::string &result) const;
+
+	/*!
+	 * \brief Appends the message formatted with \a pattern to \a result
+	 *
+	 * Each {} in \a pattern is replaced by the next argument.  A {} without an
+	 * argument is left as it is and arguments without a {} are appended at
+	 * the end, so nothing is lost when they don't match.
+	 */
+	void format(std::string &result, const char *pattern) const;
+
+	//! The formatted message
+	std::string str() const;
+
+	//! True if nothing was captured
+	bool empty() const { return bytes() == 0; }
+
+	//! Forgets the captured arguments, the site is kept
+	void clear();
+
+	//! The call site of the message, null for messages without a format string
+	const LogSite *site() const { return site_; }
+
+	//! Sets the call site of the message
+	void setSite(const LogSite *site) { site_ = site; }
+
+	/*!
+	 * \brief Appends the arguments to \a result as bytes
+	 *
+	 * \ref DeferredLiteral strings are copied, so the bytes stand on their
+	 * own.  Numbers are in the byte order and sizes of this machine.
+	 */
+	void encode(std::string &result) const;
+
+	/*!
+	 * \brief Replaces the arguments with ones from \ref encode()
+	 *
+	 * \return false if \a data isn't a complete encoded message, the message is
+	 * empty then
+	 */
+	bool decode(const char *data, std::size_t size);
+
+	//! @{
+	//! Captures one argument, used by \ref capture()
+	void putSigned(long long value) { putValue(Signed, value); }
+	void putUnsigned(unsigned long long value) { putValue(Unsigned, value); }
+	void putDouble(double value) { putValue(Double, value); }
+	void putBool(bool value) { putValue(Bool, value); }
+	void putChar(char value) { putValue(Char, value); }
+	void putPointer(const void *value) { putValue(Pointer, value); }
+	void putLiteral(const char *value) { putValue(Literal, value); }
+	void putString(const char *value, std::size_t size)
+	{
+		auto len = (std::uint32_t)size;
+		auto p = reserve(1 + sizeof(len) + size);
+		*p = String;
+		memcpy(p + 1, &len, sizeof(len));
+		memcpy(p + 1 + sizeof(len), value, size);
+	}
+	//! @}
+
+private:
+	enum Tag : char
+	{
+		Signed
+		, Unsigned
+		, Double
+		, Bool
+		, Char
+		, Pointer
+		, Literal
+		, String
+	};
+
+	template <class T>
+	void putValue(Tag tag, const T &value)
+	{
+		auto p = reserve(1 + sizeof(T));
+		*p = tag;
+		memcpy(p + 1, &value, sizeof(T));
+	}
+
+	// room for bytes more bytes, moves everything to heap_ when data_ is full
+	char *reserve(std::size_t bytes)
+	{
+		if (heap_.empty() && size_ + bytes <= Capacity)
+		{
+			auto p = data_ + size_;
+			size_ += (std::uint16_t)bytes;
+			return p;
+		}
+		return grow(bytes);
+	}
+
+	char *grow(std::size_t bytes);
+
+	const char *data() const { return heap_.empty() ? data_ : heap_.data(); }
+	std::size_t bytes() const { return heap_.empty() ? size_ : heap_.size(); }
+
+	// appends the value for tag stored at data, returns the bytes it used
+	static std::size_t appendValue(std::string &result, char tag, const char *data);
+
+	// bytes used by the value for tag stored at data
+	static std::size_t valueSize(char tag, const char *data);
+
+	char data_[Capacity];
+	std::uint16_t size_;
+	std::string heap_;
+	const LogSite *site_;
+};
+
+namespace detail
+{
+	// picks the DeferredMessage::put function for an argument type, the
+	// primary template formats anything else with operator<<
+	template <class T, class Enable = void>
+	struct DeferredArgument
+	{
+		static void put(DeferredMessage &msg, const T &value)
+		{
+			std::ostringstream ss;
+			ss << value;
+			auto text = ss.str();
+			msg.putString(text.data(), text.size());
+		}
+	};
+
+	template <class T>
+	struct DeferredArgument<T, typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value) || std::is_enum<T>::value>::type>
+	{
+		static void put(DeferredMessage &msg, const T &value) { msg.putSigned((long long)value); }
+	};
+
+	template <class T>
+	struct DeferredArgument<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type>
+	{
+		static void put(DeferredMessage &msg, const T &value) { msg.putUnsigned(value); }
+	};
+
+	template <class T>
+	struct DeferredArgument<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+	{
+		static void put(DeferredMessage &msg, const T &value) { msg.putDouble((double)value); }
+	};
+
+	template <>
+	struct DeferredArgument<bool>
+	{
+		static void put(DeferredMessage &msg, bool value) { msg.putBool(value); }
+	};
+
+	// streams print all the char types as characters
+	template <>
+	struct DeferredArgument<char>
+	{
+		static void put(DeferredMessage &msg, char value) { msg.putChar(value); }
+	};
+
+	template <>
+	struct DeferredArgument<signed char>
+	{
+		static void put(DeferredMessage &msg, signed char value) { msg.putChar((char)value); }
+	};
+
+	template <>
+	struct DeferredArgument<unsigned char>
+	{
+		static void put(DeferredMessage &msg, unsigned char value) { msg.putChar((char)value); }
+	};
+
+	// an array may go out of scope or change before the record is formatted,
+	// so it is copied up to the terminator
+	template <std::size_t N>
+	struct DeferredArgument<char[N]>
+	{
+		static void put(DeferredMessage &msg, const char (&value)[N])
+		{
+			auto end = static_cast<const char *>(memchr(value, '\0', N));
+			msg.putString(value, end ? end - value : N);
+		}
+	};
+
+	template <>
+	struct DeferredArgument<const char *>
+	{
+		static void put(DeferredMessage &msg, const char *value)
+		{
+			if (value)
+				msg.putString(value, strlen(value));
+			else
+				msg.putPointer(nullptr);
+		}
+	};
+
+	template <>
+	struct DeferredArgument<char *> : DeferredArgument<const char *> { };
+
+	template <>
+	struct DeferredArgument<std::string>
+	{
+		static void put(DeferredMessage &msg, const std::string &value) { msg.putString(value.data(), value.size()); }
+	};
+
+	template <>
+	struct DeferredArgument<DeferredLiteral>
+	{
+		static void put(DeferredMessage &msg, const DeferredLiteral &value) { msg.putLiteral(value.text); }
+	};
+
+	template <class T>
+	struct DeferredArgument<T *>
+	{
+		static void put(DeferredMessage &msg, const T *value) { msg.putPointer(value); }
+	};
+}
+
+template <class... Args>
+void DeferredMessage::capture(const Args &... args)
+{
+	// braced lists are evaluated in order so the arguments stay in order
+	int expand[] = { 0, (detail::DeferredArgument<Args>::put(*this, args), 0)... };
+	(void)expand;
+}
+
+} // sharklog
+
+#endif // deferredmessage_H
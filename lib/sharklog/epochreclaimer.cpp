@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "epochreclaimer.h"
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+	#include <linux/membarrier.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	const std::size_t CacheLine = 64;
+
+	bool registerMembarrier()
+	{
+#if defined(__linux__) && defined(__NR_membarrier)
+		auto commands = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0);
+		return commands > 0 && (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+			&& syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#else
+		return false;
+#endif
+	}
+
+	struct Retired
+	{
+		std::shared_ptr<const void> object;
+		// epoch it was retired in, readers that published it or later can't see it
+		std::uint64_t epoch;
+	};
+
+	struct RetiredList
+	{
+		std::mutex mutex;
+		std::vector<Retired> objects;
+	};
+
+	RetiredList &retiredList()
+	{
+		static RetiredList list;
+		return list;
+	}
+
+	std::atomic<EpochReclaimer::ThreadSlot *> slots_(nullptr);
+}
+
+struct EpochReclaimer::SlotOwner
+{
+	~SlotOwner()
+	{
+		auto &slot = detail::epochSlot();
+		if (!slot)
+			return;
+		slot->used.store(false, memory_order_release);
+		slot = nullptr;
+	}
+};
+
+static_assert(sizeof(EpochReclaimer::ThreadSlot) <= CacheLine, "a thread slot must fit a cache line");
+
+std::atomic<std::uint64_t> EpochReclaimer::epoch_(1);
+bool EpochReclaimer::asymmetric_ = registerMembarrier();
+
+void EpochReclaimer::retire(std::shared_ptr<const void> object)
+{
+	{
+		auto &list = retiredList();
+		lock_guard<mutex> lock(list.mutex);
+		Retired retired;
+		retired.object = std::move(object);
+		// readers that publish the new epoch load what replaced the object
+		retired.epoch = epoch_.fetch_add(1) + 1;
+		list.objects.push_back(std::move(retired));
+	}
+
+	reclaim();
+}
+
+void EpochReclaimer::reclaim()
+{
+	vector<std::shared_ptr<const void>> freed;
+	{
+		auto &list = retiredList();
+		lock_guard<mutex> lock(list.mutex);
+		if (list.objects.empty())
+			return;
+
+		// readers store their epoch then load, we stored the new version and
+		// load their epochs, so both sides need a full fence
+#if defined(__linux__) && defined(__NR_membarrier)
+		if (!asymmetric_ || syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) != 0)
+#endif
+			atomic_thread_fence(memory_order_seq_cst);
+
+		auto oldest = epoch_.load();
+		for (auto it = slots_.load(memory_order_acquire); it; it = it->next)
+		{
+			auto epoch = it->epoch.load(memory_order_relaxed);
+			if (epoch && epoch < oldest)
+				oldest = epoch;
+		}
+
+		auto kept = list.objects.begin();
+		for (auto it = list.objects.begin(); it != list.objects.end(); ++it)
+		{
+			if (it->epoch <= oldest)
+				freed.push_back(std::move(it->object));
+			else
+				*kept++ = std::move(*it);
+		}
+		list.objects.erase(kept, list.objects.end());
+	}
+
+	// destructors run here, without the lock, they may retire more
+}
+
+EpochReclaimer::ThreadSlot *EpochReclaimer::assignSlot()
+{
+	ThreadSlot *slot = nullptr;
+	for (auto it = slots_.load(memory_order_acquire); it && !slot; it = it->next)
+	{
+		auto used = false;
+		if (!it->used.load(memory_order_relaxed) && it->used.compare_exchange_strong(used, true, memory_order_acquire))
+			slot = it;
+	}
+
+	if (!slot)
+	{
+		// new doesn't align to a cache line before C++17, pad and line it up
+		// here.  Slots are never freed
+		auto memory = new char[CacheLine + CacheLine];
+		auto aligned = reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(memory) + CacheLine - 1) & ~(std::uintptr_t)(CacheLine - 1));
+		slot = new (aligned) ThreadSlot;
+		slot->epoch.store(0, memory_order_relaxed);
+		slot->used.store(true, memory_order_relaxed);
+		auto head = slots_.load(memory_order_relaxed);
+		do
+		{
+			slot->next = head;
+		} while (!slots_.compare_exchange_weak(head, slot, memory_order_release, memory_order_relaxed));
+	}
+
+	detail::epochSlot() = slot;
+	thread_local SlotOwner owner;
+	(void)owner;
+	return slot;
+}
+
+std::size_t EpochReclaimer::retiredCount()
+{
+	auto &list = retiredList();
+	lock_guard<mutex> lock(list.mutex);
+	return list.objects.size();
+}
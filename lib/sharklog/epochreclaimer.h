@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __epochreclaimer_H
+#define __epochreclaimer_H
+
+#include <sharklog/sharklogdefs.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Frees shared data once no thread can still be reading it
+ *
+ * This is how the lock-free readers in the library, like \ref LoggerRegistry
+ * lookups, let a writer replace what they read.  It is internal to the
+ * library.
+ *
+ * A thread reads inside a \ref Reader, which publishes the epoch the thread
+ * started reading in.  A writer publishes the new version first, then hands
+ * the old one to \ref retire().  It is freed once every thread is either not
+ * reading or started reading after it was retired, those threads can only
+ * have seen the new version.
+ *
+ * Readers never free anything.  Retired objects are freed by \ref retire()
+ * and \ref reclaim() on the writer's thread, so destructors don't run inside
+ * some reader's call.  An object a thread was still reading when it was
+ * retired is freed by a later call.
+ *
+ * Publishing the epoch needs a full fence between the reader's store and its
+ * next load.  On Linux the membarrier() system call, registered once when the
+ * library is loaded, lets the writer put that fence into the readers so they
+ * only keep the compiler from reordering.  Elsewhere readers pay for the
+ * fence themselves.
+ */
+class SHARKLOGAPI EpochReclaimer
+{
+public:
+	/*!
+	 * \brief Where a thread publishes its epoch
+	 *
+	 * One per thread that reads, on a cache line of its own.  It is never
+	 * freed so writers can always scan it, it goes to another thread when its
+	 * owner exits.
+	 */
+	struct ThreadSlot
+	{
+		//! epoch the thread started reading in, 0 when it isn't reading
+		std::atomic<std::uint64_t> epoch;
+		//! true while a thread owns the slot
+		std::atomic<bool> used;
+		//! the next slot, all the slots are in one list
+		ThreadSlot *next;
+	};
+
+	/*!
+	 * \brief Marks the calling thread as reading while it is in scope
+	 *
+	 * Nothing retired after it was created is freed before it is destroyed.
+	 * Readers can be nested, only the outermost one publishes.
+	 */
+	class Reader
+	{
+	public:
+		//! Constructor, the thread is reading from here on
+		Reader()
+			: slot_(threadSlot())
+			, outer_(!slot_.epoch.load(std::memory_order_relaxed))
+		{
+			if (!outer_)
+				return;
+
+			// the epoch is published before anything shared is read
+			slot_.epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+			readerFence();
+		}
+
+		//! Destructor, the thread is done reading
+		~Reader()
+		{
+			// a writer that still sees the old epoch only frees later
+			if (outer_)
+				slot_.epoch.store(0, std::memory_order_release);
+		}
+
+	private:
+		Reader(const Reader &);
+		Reader &operator=(const Reader &);
+
+		ThreadSlot &slot_;
+		bool outer_;
+	};
+
+	/*!
+	 * \brief Frees \a object once no thread can be reading it
+	 *
+	 * Call it after whatever replaced \a object was published.  Frees
+	 * anything retired earlier that can go, see \ref reclaim().
+	 */
+	template <class T>
+	static void retire(std::unique_ptr<T> object)
+	{
+		retire(std::shared_ptr<const void>(std::move(object)));
+	}
+
+	//! Same as the template, \a object is freed when its last copy goes
+	static void retire(std::shared_ptr<const void> object);
+
+	//! Frees the retired objects no thread can be reading any more
+	static void reclaim();
+
+	//! The number of retired objects not freed yet
+	static std::size_t retiredCount();
+
+	//! The calling thread's slot, handing it one the first time
+	static ThreadSlot &threadSlot();
+
+private:
+	// gives the slot back when its thread exits
+	struct SlotOwner;
+
+	static ThreadSlot *assignSlot();
+
+	static void readerFence()
+	{
+		if (asymmetric_)
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		else
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	static std::atomic<std::uint64_t> epoch_;
+	// true once membarrier() is registered, set while the library is loaded
+	static bool asymmetric_;
+};
+
+namespace detail
+{
+	// the calling thread's slot, initial-exec so reading it is a load off the
+	// thread pointer, even from the shared library.  Not a member so it isn't
+	// part of the DLL interface
+	inline EpochReclaimer::ThreadSlot *&epochSlot()
+	{
+#if defined(__GNUC__) && !defined(_WIN32)
+		__attribute__((tls_model("initial-exec")))
+#endif
+		static thread_local EpochReclaimer::ThreadSlot *slot = nullptr;
+		return slot;
+	}
+}
+
+inline EpochReclaimer::ThreadSlot &EpochReclaimer::threadSlot()
+{
+	// one thread local lookup, the slow path is kept out of line
+	auto slot = detail::epochSlot();
+	if (!slot)
+		slot = assignSlot();
+	return *slot;
+}
+
+} // sharklog
+
+#endif // epochreclaimer_H
@@ -27,12 +27,11 @@
 using namespace sharklog;
 using namespace std;
 
-std::recursive_mutex FileOutputter::mutex_;
-
 FileOutputter::FileOutputter(const std::string &filename)
+    : append_(false)
+    , open_(false)
 {
     setFilename(filename);
-    setAppend(false);
 }
 
 FileOutputter::~FileOutputter()
@@ -42,10 +41,10 @@ FileOutputter::~FileOutputter()
 
 bool FileOutputter::open()
 {
-    lock_guard<recursive_mutex> lock(mutex_);
+    lock_guard<mutex> lock(mutex_);
 
 	// close file if it's already open
-	close();
+	closeFile();
 
 	// open file
 	if (append_)
@@ -53,7 +52,8 @@ bool FileOutputter::open()
 	else
 		file_.open(filename_, std::ofstream::out | std::ofstream::trunc);
 
-    return file_.is_open();
+	open_ = file_.is_open();
+    return open_;
 }
 
 void FileOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
@@ -61,48 +61,62 @@ void FileOutputter::writeLog(const Level &lev, const std::string &loggerName, co
 	if (!isOpen() || !isValid())
 		return;
 
-    lock_guard<recursive_mutex> lock(mutex_);
+    auto &log = formatBuffer();
+    log.clear();
+    layout()->formatRecord(log, lev, loggerName, logMessage, loc);
+    countFormatted(log.size());
+
+    lock_guard<mutex> lock(mutex_);
+	if (!file_.is_open())
+		return;
 
-    string log;
-    layout()->appendHeader(log);
-    layout()->formatMessage(log, lev, loggerName, logMessage);
-    layout()->appendFooter(log);
-	file_ << log;
+	if (file_.write(log.data(), log.size()))
+		countWritten(log.size());
+	else
+		countWriteError();
 }
 
 void FileOutputter::close()
 {
-    lock_guard<recursive_mutex> lock(mutex_);
+    lock_guard<mutex> lock(mutex_);
+	closeFile();
+}
 
+void FileOutputter::closeFile()
+{
+	// called with mutex_ held
+	open_ = false;
 	if (file_.is_open())
 		file_.close();
 }
 
 bool FileOutputter::isOpen() const
 {
-	return file_.is_open();
+	return open_;
 }
 
 void FileOutputter::setFilename(const std::string &filename)
 {
-    lock_guard<recursive_mutex> lock(mutex_);
+    lock_guard<mutex> lock(mutex_);
 
-	close();
+	closeFile();
     filename_ = filename;
 }
 
 std::string FileOutputter::filename() const
 {
+    lock_guard<mutex> lock(mutex_);
     return filename_;
 }
 
 void FileOutputter::setAppend(bool append)
 {
-    lock_guard<recursive_mutex> lock(mutex_);
+    lock_guard<mutex> lock(mutex_);
     append_ = append;
 }
 
 bool FileOutputter::append() const
 {
+    lock_guard<mutex> lock(mutex_);
     return append_;
 }
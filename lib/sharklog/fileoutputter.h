@@ -30,6 +30,7 @@
 #include <string>
 #include <fstream>
 #include <mutex>
+#include <atomic>
 
 namespace sharklog
 {
@@ -57,6 +58,10 @@ namespace sharklog
  * // log a message
  * SHARKLOG_TRACE(log, "hello log file");
  * \endcode
+ *
+ * Each FileOutputter has its own lock, so outputters writing to different files
+ * never wait on each other.  Records are formatted before the lock is taken,
+ * only the write to the file is serialized.
  */
 class SHARKLOGAPI FileOutputter : public Outputter
 {
@@ -169,11 +174,15 @@ public:
      */
     virtual bool isOpen() const override;
     
+private:
+    void closeFile();
+    
 private:
     std::ofstream file_;
     std::string filename_;
     bool append_;
-    static std::recursive_mutex mutex_;
+    std::atomic<bool> open_;
+    mutable std::mutex mutex_;
 };
     
 } // sharklog
@@ -23,7 +23,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "functrace.h"
-#include <sstream>
 
 using namespace sharklog;
 using namespace std;
@@ -31,20 +30,22 @@ using namespace std;
 std::string FuncTrace::enterHeader_ = ">>";
 std::string FuncTrace::exitHeader_ = "<<";
 
-FuncTrace::FuncTrace(LoggerPtr logger, const Location &loc)
+FuncTrace::FuncTrace(const LoggerPtr &logger, const Location &loc)
     : loc_(loc)
-    , logger_(logger)
 {
-    stringstream ss;
-    ss << enterHeader() << " " << loc.function();
-    logger->log(Level::functrace(), ss.str());
+    // nothing is built unless the logger takes functrace, the exit is only
+    // logged when the enter was
+    if (!logger->isEnabled(Level::FUNCTRACE))
+        return;
+
+    logger_ = logger;
+    logger->log(Level::functrace(), enterHeader() + " " + loc.function());
 }
 
 FuncTrace::~FuncTrace()
 {
-    stringstream ss;
-    ss << exitHeader() << " " << loc_.function();
-    logger_->log(Level::functrace(), ss.str());
+    if (logger_)
+        logger_->log(Level::functrace(), exitHeader() + " " + loc_.function());
 }
 
 std::string FuncTrace::enterHeader()
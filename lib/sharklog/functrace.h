@@ -98,6 +98,8 @@ class Location;
  *    sharklog::FuncTrace ft(Logger::rootLogger(), SHARKLOG_LOCATION);
  * }
  * \endcode
+ *
+ * To time a scope instead see \ref SHARKLOG_SCOPE_TIMER.
  */
 class SHARKLOGAPI FuncTrace
 {
@@ -110,10 +112,13 @@ public:
      * This is the only way to use this object as it is made to be utilized
      * during construct/destruct only.
      *
+     * Nothing is logged, or formatted, unless \a logger has functrace
+     * enabled.  The exit is logged if the enter was.
+     *
      * @param logger The logger to use for this message
      * @param loc A Location object for the current location in code
      */
-    FuncTrace(LoggerPtr logger, const Location &loc);
+    FuncTrace(const LoggerPtr &logger, const Location &loc);
     
     /*!
      * \brief Destructor
@@ -187,6 +192,9 @@ private:
  *
  * Use this macro to easily add a \ref FuncTrace to a function.
  *
+ * It compiles to nothing if SHARKLOG_COMPILE_MIN_LEVEL is below
+ * SHARKLOG_LEVEL_FUNCTRACE, see \ref CompileLevels.
+ *
  * \code
  * void myFunc()
  * {
@@ -194,7 +202,11 @@ private:
  * }
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_FUNCTRACE
 #define SHARKLOG_FUNCTRACE(logger) FuncTrace func_trace_(logger, SHARKLOG_LOCATION)
+#else
+#define SHARKLOG_FUNCTRACE(logger)
+#endif
 
 /*!
  * \brief FuncTrace Root Logger macro
@@ -209,7 +221,11 @@ private:
  * }
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_FUNCTRACE
 #define SHARKLOG_FUNCTRACE_ROOT FuncTrace func_trace_(sharklog::Logger::rootLogger(), SHARKLOG_LOCATION)
+#else
+#define SHARKLOG_FUNCTRACE_ROOT
+#endif
     
 } // sharklog
 
@@ -26,10 +26,37 @@
 #include <time.h>
 #include "sharklogdefs.h"
 #include "utilfunctions.h"
+#include "recordcontext.h"
+#include "threadinfo.h"
+#include <sstream>
+#include <algorithm>
+#include <cstring>
 
 using namespace sharklog;
 using namespace std;
 
+namespace
+{
+	// "0x..." for the last few threads seen, std::thread::id can only be
+	// formatted with a stream so it is done once per thread
+	struct ThreadIdCache
+	{
+		static const size_t Size = 8;
+
+		struct Entry
+		{
+			std::thread::id id;
+			size_t size = 0;
+			char text[40];
+		};
+
+		Entry entries[Size];
+		size_t next = 0;
+	};
+
+	thread_local ThreadIdCache threadIdCache_;
+}
+
 std::string Layout::contentType() const
 {
     return std::string("text/plain");
@@ -47,6 +74,14 @@ Layout::~Layout()
 {
 }
 
+void Layout::formatRecord(std::string &result, const Level &level, const std::string &loggerName,
+                          const std::string &logMessage, const Location &loc)
+{
+    appendHeader(result);
+    formatMessage(result, level, loggerName, logMessage);
+    appendFooter(result);
+}
+
 std::string Layout::formatTime(const std::string &format, tm *timeToUse)
 {
 	// get a time to use either from being passed in, or if that was null, get current time
@@ -54,7 +89,7 @@ std::string Layout::formatTime(const std::string &format, tm *timeToUse)
 	tm *tmt = timeToUse;
 	if (!tmt)
 	{
-		localCurTime = *UtilFunctions::Time().tmStruct();
+		localCurTime = *UtilFunctions::Time(RecordContext::current().time()).tmStruct();
 		tmt = &localCurTime;
 	}
 
@@ -65,3 +100,43 @@ std::string Layout::formatTime(const std::string &format, tm *timeToUse)
 
 	return string(curTimeStr);
 }
+
+void Layout::appendThreadId(std::string &result, const RecordContext &ctx)
+{
+    if (ctx.threadLabel())
+        result += ctx.threadLabel();
+    else if (ctx.threadName())
+        result += *ctx.threadName();
+    else
+    {
+        // records are normally formatted by the thread that logged them
+        auto &info = ThreadInfo::current();
+        if (info.id() == ctx.threadId())
+            result.append(info.idText(), info.idSize());
+        else
+            appendThreadId(result, ctx.threadId());
+    }
+}
+
+void Layout::appendThreadId(std::string &result, std::thread::id id)
+{
+    auto &cache = threadIdCache_;
+    for (auto &it : cache.entries)
+    {
+        if (it.size && it.id == id)
+        {
+            result.append(it.text, it.size);
+            return;
+        }
+    }
+    
+    stringstream ss;
+    ss << "0x" << hex << id;
+    auto text = ss.str();
+    result.append(text);
+    
+    auto &entry = cache.entries[cache.next++ % ThreadIdCache::Size];
+    entry.id = id;
+    entry.size = min(text.size(), sizeof(entry.text));
+    memcpy(entry.text, text.data(), entry.size);
+}
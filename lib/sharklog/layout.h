@@ -26,8 +26,10 @@
 #define __layout_H
 
 #include <sharklog/sharklogdefs.h>
+#include <sharklog/location.h>
 #include <string>
 #include <memory>
+#include <thread>
 
 struct tm;
 
@@ -36,6 +38,7 @@ namespace sharklog
     
 class Level;
 class Layout;
+class RecordContext;
     
 /*!
  * \var LayoutPtr
@@ -90,6 +93,24 @@ public:
 	 */
     virtual void formatMessage(std::string &result, const Level &level, const std::string &loggerName, const std::string &logMessage) = 0;
     
+	/*!
+	 * \brief Formats a whole record 
+	 *  
+	 * This is what the \ref Outputter's call to format a record.  It appends the 
+	 * header, the message and the footer to \a result, the same as calling 
+	 * \ref appendHeader(), \ref formatMessage() and \ref appendFooter(). 
+	 *  
+	 * Override it if your layout needs the source \a loc of the message, like 
+	 * \ref PatternLayout does. 
+	 * 
+	 * \param result output of the formatted string, append to it
+	 * \param level the current \ref Level of the log message
+	 * \param loggerName the name of the logger
+	 * \param logMessage the message to be logged
+	 * \param loc where the message was logged, can be empty
+	 */
+    virtual void formatRecord(std::string &result, const Level &level, const std::string &loggerName, const std::string &logMessage, const Location &loc);
+    
 	/*!
 	 * \brief Gets the content type 
 	 *  
@@ -149,6 +170,27 @@ protected:
 	 * \return std::string a formatted time string
 	 */
 	std::string formatTime(const std::string &format, tm *timeToUse=0);
+    
+	/*!
+	 * \brief Appends a thread id 
+	 *  
+	 * Appends \a id as hex, i.e. 0x7f7a19143740, to \a result.  The text for 
+	 * the last few threads is cached per thread so this does not allocate 
+	 * once they have been seen. 
+	 * 
+	 * \param result the string to append to
+	 * \param id the thread id, normally from \ref RecordContext::threadId()
+	 */
+	static void appendThreadId(std::string &result, std::thread::id id);
+
+	/*!
+	 * \brief Appends the thread of \a ctx
+	 *
+	 * Appends its \ref RecordContext::threadLabel() or thread name if it has
+	 * one, the id otherwise.  The id of the calling thread is formatted once
+	 * per thread, see \ref ThreadInfo.
+	 */
+	static void appendThreadId(std::string &result, const RecordContext &ctx);
 };
     
 } // sharklog
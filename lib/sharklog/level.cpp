@@ -29,6 +29,13 @@
 using namespace sharklog;
 using namespace std;
 
+// the preprocessor levels in sharklogdefs.h have to follow the enum
+static_assert(Level::FATAL == SHARKLOG_LEVEL_FATAL && Level::ERROR == SHARKLOG_LEVEL_ERROR
+	&& Level::WARN == SHARKLOG_LEVEL_WARN && Level::INFO == SHARKLOG_LEVEL_INFO
+	&& Level::TRACE == SHARKLOG_LEVEL_TRACE && Level::DEBUG == SHARKLOG_LEVEL_DEBUG
+	&& Level::FUNCTRACE == SHARKLOG_LEVEL_FUNCTRACE && Level::ALL == SHARKLOG_LEVEL_ALL,
+	"SHARKLOG_LEVEL_* values do not match Level::LogLevel");
+
 Level::Level(Level::LogLevel lev) : level_(lev)
 {
 }
@@ -60,11 +67,6 @@ Level::Level(const std::string &name)
 		level_ = f->second;
 }
 
-Level::LogLevel Level::level() const
-{
-    return level_;
-}
-
 Level Level::fatal()
 {
     return Level(FATAL);
@@ -102,21 +104,16 @@ Level Level::functrace()
 
 std::string Level::name() const
 {
-    static map<LogLevel, string> levelNames;
-    if (levelNames.empty())
-    {
-        levelNames[NONE] = "NONE";
-        levelNames[FATAL] = "FATAL";
-        levelNames[ERROR] = "ERROR";
-        levelNames[WARN] = "WARN";
-        levelNames[INFO] = "INFO";
-        levelNames[TRACE] = "TRACE";
-        levelNames[DEBUG] = "DEBUG";
-        levelNames[FUNCTRACE] = "FUNC";
-        levelNames[ALL] = "ALL";
-    }
+    return levelName(level_);
+}
+
+const char *Level::levelName(LogLevel lev)
+{
+    static const char *levelNames[] = { "NONE", "FATAL", "ERROR", "WARN", "INFO", "TRACE", "DEBUG", "FUNC", "ALL" };
+    if (lev < NONE || lev > ALL)
+        return levelNames[NONE];
     
-    return levelNames.at(level_);
+    return levelNames[lev];
 }
 
 bool Level::hasLevel(const Level &level) const
@@ -159,11 +156,6 @@ bool Level::hasFuncTrace() const
     return hasLevel(FUNCTRACE);
 }
 
-bool Level::hasLevel(LogLevel level) const
-{
-    return (level <= level_);
-}
-
 bool Level::operator==(const Level &lev)
 {
     return (level_ == lev.level());
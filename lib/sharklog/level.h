@@ -192,6 +192,17 @@ public:
 	 */
     std::string name() const;
 
+	/*!
+	 * \brief Gets a level name without allocating
+	 *
+	 * Same names as \ref name() but as a static string, for formatting
+	 * code that can not afford to build a std::string per record.
+	 *
+	 * \param lev the level
+	 * \return the name of the level i.e. DEBUG
+	 */
+	static const char *levelName(LogLevel lev);
+
 	/*!
 	 * \brief Enum log level 
 	 *  
@@ -203,13 +214,19 @@ public:
 	 *  
 	 * \return LogLevel enum value representing the log level.
 	 */
-    LogLevel level() const;
+    LogLevel level() const
+    {
+        return level_;
+    }
     
 	//! Checks if level has \a level
     bool hasLevel(const Level &level) const;
 
 	//! Checks if level has \a level
-    bool hasLevel(LogLevel level) const;
+    bool hasLevel(LogLevel level) const
+    {
+        return (level <= level_);
+    }
 
 	//! Checks if level has fatal
     bool hasFatal() const;
@@ -28,16 +28,9 @@
 using namespace sharklog;
 using namespace std;
 
-Location::Location(const std::string &file, const std::string &function, int line)
-    : file_(file)
-    , function_(function)
-    , line_(line)
-{
-}
-
 bool Location::empty() const
 {
-    return !(line_ && !function_.empty() && !file_.empty());
+    return !(line_ && *function_ && *file_);
 }
 
 std::string Location::formattedString() const
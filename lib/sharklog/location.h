@@ -48,12 +48,18 @@ namespace sharklog
  * a SHARKLOG_END, that will include location information as well. 
  *  
  * You should not need to allocate or use this class in your logging. 
+ *  
+ * A Location only holds pointers to the file and function names, normally 
+ * the string literals from __FILE__ and the compiler's function name, plus 
+ * the line.  It is constexpr so SHARKLOG_LOCATION costs nothing until a 
+ * layout actually prints it.  The strings have to outlive any record that 
+ * uses the Location, which string literals always do. 
  */
 class SHARKLOGAPI Location
 {
 public:
 	//! Default constructor
-    Location() : line_(0) { }
+    constexpr Location() : file_(""), function_(""), line_(0) { }
 
 	/*!
 	 * \brief Overloaded constructor 
@@ -61,11 +67,18 @@ public:
 	 * This constructor will build a Location object with the appropriate 
 	 * \a file, \a function, and \a line. 
 	 * 
+	 * The strings are not copied, see \ref Location. 
+	 * 
 	 * \param file the file we are located in, i.e. __FILE__
 	 * \param function the current function, i.e. in gcc __PRETTY_FUNCTION__
 	 * \param line the current line of code, i.e. __LINE__
 	 */
-    Location(const std::string &file, const std::string &function, int line);
+    constexpr Location(const char *file, const char *function, int line)
+        : file_(file ? file : "")
+        , function_(function ? function : "")
+        , line_(line)
+    {
+    }
     
 	/*!
 	 * \brief Checks if location is set 
@@ -82,20 +95,22 @@ public:
 	/*!
 	 * \brief Current file 
 	 *  
-	 * This returns the currently set file location as a string. 
+	 * This returns the currently set file location as a string.  It is 
+	 * never null, an unset file is "". 
 	 * 
-	 * \return std::string file location
+	 * \return const char * file location
 	 */
-    inline std::string file() const { return file_; }
+    constexpr const char *file() const { return file_; }
 
 	/*!
 	 * \brief Current function 
 	 *  
-	 * This returns the current function location as a string. 
+	 * This returns the current function location as a string.  It is 
+	 * never null, an unset function is "". 
 	 * 
-	 * \return std::string function location
+	 * \return const char * function location
 	 */
-    inline std::string function() const { return function_; }
+    constexpr const char *function() const { return function_; }
 
 	/*!
 	 * \brief Current line 
@@ -104,7 +119,7 @@ public:
 	 * 
 	 * \return int current line location
 	 */
-    inline int line() const { return line_; }
+    constexpr int line() const { return line_; }
     
 	/*!
 	 * \brief Formatted location string 
@@ -117,8 +132,8 @@ public:
     std::string formattedString() const;
     
 private:
-    std::string file_;
-    std::string function_;
+    const char *file_;
+    const char *function_;
     int line_;
 };
     
@@ -148,4 +163,11 @@ private:
     #define SHARKLOG_LOCATION sharklog::Location(__FILE__, __SHARKLOG_FUNC__, __LINE__)
 #endif
 
+/*!
+  Declares \a name as a static constexpr \ref Location for the current line, so
+  a call site builds its location once at compile time instead of on every call.
+  The log macros use this.
+  */
+#define SHARKLOG_STATIC_LOCATION(name) static constexpr sharklog::Location name = SHARKLOG_LOCATION
+
 #endif // location_H
@@ -30,37 +30,83 @@
 #include "utilfunctions.h"
 #include <iostream>
 #include "location.h"
+#include "asyncoutputter.h"
+#include "epochreclaimer.h"
 
 using namespace sharklog;
 using namespace std;
 
 LoggerPtr Logger::rootLogger_;
-Logger::LoggerMap Logger::allNamedLoggers_;
+LoggerRegistry Logger::allNamedLoggers_;
 std::recursive_mutex Logger::mutex_;
 std::string Logger::version_ = SHARKLOG_VERSION;
 
+namespace
+{
+	// accepted records are counted per level, Level::FATAL to Level::FUNCTRACE
+	enum Counter
+	{
+		Filtered,
+	};
+
+	std::size_t levelCounter(Level::LogLevel level)
+	{
+		return (level > Level::NONE && level < Level::ALL) ? level : Level::FUNCTRACE;
+	}
+}
+
+class Logger::ChainReader
+{
+public:
+	explicit ChainReader(const Logger &logger)
+		: chain_(logger.chain_.load(memory_order_acquire))
+	{
+	}
+
+	const Chain *operator->() const { return chain_; }
+
+private:
+	ChainReader(const ChainReader &);
+	ChainReader &operator=(const ChainReader &);
+
+	// publishes the epoch before chain_ is read
+	EpochReclaimer::Reader reader_;
+	const Chain *chain_;
+};
+
 Logger::Logger()
+    : additive_(true)
+    , chain_(nullptr)
+    , threshold_(Level::NONE)
 {
+    // log() always has a chain to look at, even before the first update
+    chain_ = new Chain;
     //cout << "create logger " << this << endl;
 }
 
 Logger::~Logger()
 {
+    // nothing can be logging here without a reference, older chains were retired
+    delete chain_.load();
     //cout << "decon logger " << this << " name " << name() << endl;
 }
 
 LoggerPtr Logger::rootLogger()
 {
-    if (!rootLogger_)
-    {
-		lock_guard<recursive_mutex> lock(mutex_);
-        LoggerPtr p(new Logger());
-        rootLogger_ = p;
-        assert(rootLogger_);
-        rootLogger_->setLevel(Level::all());
-    }
+    // read without the lock, so only through atomic_load()
+    auto root = atomic_load(&rootLogger_);
+    if (root)
+        return root;
+    
+    lock_guard<recursive_mutex> lock(mutex_);
+    root = atomic_load(&rootLogger_);
+    if (root)
+        return root;
     
-    return rootLogger_;
+    root.reset(new Logger());
+    root->setLevel(Level::all());
+    atomic_store(&rootLogger_, root);
+    return root;
 }
 
 bool Logger::isRoot() const
@@ -77,9 +123,15 @@ std::string Logger::name() const
 LoggerPtr Logger::logger(const std::string &name)
 {
     // find our if we have this logger already
-    auto logger = allNamedLoggers_.find(name);
-    if (logger != allNamedLoggers_.end())
-        return logger->second;
+    auto logger = allNamedLoggers_.get(name);
+    if (logger)
+        return logger;
+    
+    // another thread may have created it while we waited on the lock
+	lock_guard<recursive_mutex> lock(mutex_);
+    logger = allNamedLoggers_.get(name);
+    if (logger)
+        return logger;
     
     // create the logger since we don't have it
     return rootLogger()->createLoggers(name);
@@ -97,28 +149,38 @@ std::string Logger::baseName() const
 
 void Logger::closeRootLogger()
 {
-    if (!rootLogger_)
+    if (!atomic_load(&rootLogger_))
 		return;
     
+    // write out anything still queued before the loggers go away
+    AsyncOutputter::closeAll();
+    
 	lock_guard<recursive_mutex> lock(mutex_);
+    auto root = atomic_load(&rootLogger_);
+    if (!root)
+        return;
+    
     //cout << "closing root" << endl;
-    closeLogger(rootLogger_);
+    closeLogger(root);
     
     allNamedLoggers_.clear();
-    rootLogger_.reset();
+    atomic_store(&rootLogger_, LoggerPtr());
+    
+    // anything a thread was still reading when it was replaced
+    EpochReclaimer::reclaim();
 }
 
 LoggerPtr Logger::createLoggers(const std::string &loggerName)
 {
     // make sure we don't have this named logger already
-    assert(allNamedLoggers_.find(loggerName) == allNamedLoggers_.end());
+    assert(!allNamedLoggers_.find(loggerName));
     
     // find our parent logger and which loggers we need to create.
     vector<string> loggersToCreate;
+    // the parent's name is always a prefix of ours, only create what comes after it
     auto parent = findParent(loggerName);
-    auto pos = loggerName.find(parent->name());
-    if (pos != string::npos)
-        loggersToCreate = UtilFunctions::split(loggerName.substr(pos), '.');
+    if (!parent->isRoot())
+        loggersToCreate = UtilFunctions::split(loggerName.substr(parent->name().size()), '.');
     else
         loggersToCreate = UtilFunctions::split(loggerName, '.');
     
@@ -143,12 +205,9 @@ LoggerPtr Logger::findParent(const string &loggerName)
     while (s.find('.') != string::npos)
     {
         s = UtilFunctions::stripLastToken(s, '.');
-        auto it = allNamedLoggers_.find(s);
-        if (it != allNamedLoggers_.end())
-        {
-            parent = it->second;
+        parent = allNamedLoggers_.get(s);
+        if (parent)
             break;
-        }
     }
     
     if (!parent)
@@ -174,13 +233,14 @@ LoggerPtr Logger::createLogger(LoggerPtr parent, const std::string &baseName)
     auto fullName = ss.str();
     
     // make sure we don't have this logger already
-    assert(allNamedLoggers_.find(fullName) == allNamedLoggers_.end());
+    assert(!allNamedLoggers_.find(fullName));
     
     // create the logger
     LoggerPtr logger(new Logger());
     logger->parent_ = parent;
     logger->setName(fullName, baseName);
-    logger->allNamedLoggers_[fullName] = logger;
+    logger->updateChains();
+    allNamedLoggers_.insert(fullName, logger);
     parent->children_.push_back(logger);
     
     return logger;
@@ -195,15 +255,15 @@ void Logger::setName(const std::string &loggerName, const std::string &baseName)
 
 bool Logger::hasLogger(const std::string &name)
 {
-    return (allNamedLoggers_.find(name) != allNamedLoggers_.end());
+    return allNamedLoggers_.find(name) != nullptr;
 }
 
 unsigned int Logger::count()
 {
-    if (!rootLogger_)
+    if (!atomic_load(&rootLogger_))
         return 0;
     
-    return (unsigned int)rootLogger()->allNamedLoggers_.size() + 1;
+    return (unsigned int)allNamedLoggers_.size() + 1;
 }
 
 void Logger::closeLogger(LoggerPtr logger)
@@ -219,23 +279,39 @@ void Logger::closeLogger(LoggerPtr logger)
     
     // clean up logger
     logger->parent_.reset();
-    logger->allNamedLoggers_[logger->name()].reset();
-    logger->allNamedLoggers_.erase(logger->name());
+    allNamedLoggers_.erase(logger->name());
 }
 
 Level Logger::level() const
 {
-    return level_;
+    ChainReader chain(*this);
+    return chain->level;
 }
 
 void Logger::setLevel(const Level &lev)
 {
+	lock_guard<recursive_mutex> lock(mutex_);
     level_ = lev;
+    updateChains();
+}
+
+void Logger::setAdditivity(bool additive)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+    additive_ = additive;
+    updateChains();
+}
+
+bool Logger::additivity() const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+    return additive_;
 }
 
 bool Logger::isValid() const
 {
-	for (auto it : outputters())
+	ChainReader chain(*this);
+	for (auto it : chain->outputters)
 	{
 		if (it->isValid())
 			return true;
@@ -246,39 +322,178 @@ bool Logger::isValid() const
 
 Logger::OutputterList Logger::outputters() const
 {
+	lock_guard<recursive_mutex> lock(mutex_);
     return outputters_;
 }
 
 void sharklog::Logger::addOutputter(OutputterPtr op)
 {
 	lock_guard<recursive_mutex> lock(mutex_);
-	if (find(outputters_.begin(), outputters_.end(), op) == outputters_.end())
-		outputters_.push_back(op);
+	if (find(outputters_.begin(), outputters_.end(), op) != outputters_.end())
+		return;
+
+	outputters_.push_back(op);
+	updateChains();
 }
 
 void Logger::removeOutputter(OutputterPtr op)
 {
 	lock_guard<recursive_mutex> lock(mutex_);
+	if (find(outputters_.begin(), outputters_.end(), op) == outputters_.end())
+		return;
+
     outputters_.remove(op);
+	updateChains();
+}
+
+void Logger::updateChains()
+{
+	// called with mutex_ held, parents always have an up to date chain
+	const Chain *parentChain = nullptr;
+	if (parent_)
+		parentChain = parent_->chain_.load(memory_order_relaxed);
+
+	std::unique_ptr<Chain> chain(new Chain);
+	chain->level = (parentChain && level_.level() == Level::NONE) ? parentChain->level : level_;
+	chain->owners = outputters_;
+	if (additive_ && parentChain)
+	{
+		for (auto &it : parentChain->owners)
+		{
+			if (find(chain->owners.begin(), chain->owners.end(), it) == chain->owners.end())
+				chain->owners.push_back(it);
+		}
+	}
+
+	// nothing changed here so nothing changes for the children either
+	auto current = chain_.load(memory_order_relaxed);
+	if (current->level.level() == chain->level.level() && current->owners == chain->owners)
+		return;
+
+	for (auto &it : chain->owners)
+		chain->outputters.push_back(it.get());
+
+	threshold_.store((uint8_t)chain->level.level(), memory_order_relaxed);
+	chain_.store(chain.release());
+
+	// freed here or by a later change once no log() can still be reading it,
+	// never by log() itself, so outputters aren't destroyed while logging
+	EpochReclaimer::retire(std::unique_ptr<const Chain>(current));
+
+	for (auto &it : children_)
+		it->updateChains();
 }
 
 bool Logger::log(const Level &level, const std::string &msg, const Location &loc) const
 {
     // make sure we have this level
-    if (!level_.hasLevel(level))
+    if (!isEnabled(level.level()))
+    {
+        counters_.add(Filtered);
         return false;
+    }
+    
+    ChainReader chain(*this);
     
     // make sure we have at least 1 outputter
-    if (outputters().empty())
+    if (chain->outputters.empty())
         return false;
     
     // output message
-    for (auto op : outputters())
-		op->writeLog(level, name(), msg, loc);
+    auto &slot = ShardedCounters::threadSlot();
+    for (auto op : chain->outputters)
+		op->log(slot, level, fullName_, msg, loc);
     
+    counters_.add(slot, levelCounter(level.level()));
     return true;
 }
 
+bool Logger::logDeferred(const Level &level, const DeferredMessage &msg, const Location &loc) const
+{
+    if (!isEnabled(level.level()))
+    {
+        counters_.add(Filtered);
+        return false;
+    }
+    
+    ChainReader chain(*this);
+    
+    if (chain->outputters.empty())
+        return false;
+    
+    auto &slot = ShardedCounters::threadSlot();
+    for (auto op : chain->outputters)
+		op->logDeferred(slot, level, fullName_, msg, loc);
+    
+    counters_.add(slot, levelCounter(level.level()));
+    return true;
+}
+
+LoggerStats Logger::stats() const
+{
+    LoggerStats stats;
+    for (std::size_t l=Level::FATAL;l<Level::ALL;++l)
+    {
+        stats.levels[l] = counters_.total(l);
+        stats.accepted += stats.levels[l];
+    }
+    stats.filtered = counters_.total(Filtered);
+    return stats;
+}
+
+void Logger::resetStats()
+{
+    counters_.reset();
+}
+
+StatsSnapshot Logger::allStats()
+{
+    StatsSnapshot snapshot;
+
+    auto loggers = allNamedLoggers_.loggers();
+    sort(loggers.begin(), loggers.end(), [](const LoggerPtr &a, const LoggerPtr &b) { return a->name() < b->name(); });
+    loggers.insert(loggers.begin(), rootLogger());
+
+    vector<OutputterPtr> seen;
+    auto addOutputter = [&](const string &name, OutputterPtr op) {
+        if (find(seen.begin(), seen.end(), op) != seen.end())
+            return false;
+        seen.push_back(op);
+
+        StatsSnapshot::OutputterEntry entry;
+        entry.name = name;
+        entry.outputter = op;
+        entry.stats = op->stats();
+        snapshot.outputterTotal += entry.stats;
+        snapshot.outputters.push_back(std::move(entry));
+        return true;
+    };
+
+    for (auto &logger : loggers)
+    {
+        StatsSnapshot::LoggerEntry entry;
+        entry.name = logger->isRoot() ? "root" : logger->name();
+        entry.stats = logger->stats();
+        snapshot.loggerTotal += entry.stats;
+
+        unsigned int index = 0;
+        for (auto &op : logger->outputters())
+        {
+            auto name = entry.name + "#" + to_string(index++);
+            if (!addOutputter(name, op))
+                continue;
+
+            auto async = dynamic_pointer_cast<AsyncOutputter>(op);
+            if (async && async->outputter())
+                addOutputter(name + ".async", async->outputter());
+        }
+
+        snapshot.loggers.push_back(std::move(entry));
+    }
+
+    return snapshot;
+}
+
 std::string Logger::version()
 {
     return version_;
@@ -29,6 +29,10 @@
 #include <sharklog/level.h>
 #include <sharklog/outputter.h>
 #include <sharklog/location.h>
+#include <sharklog/deferredmessage.h>
+#include <sharklog/logsite.h>
+#include <sharklog/loggerregistry.h>
+#include <sharklog/stats.h>
 #include <string>
 #include <memory>
 #include <list>
@@ -36,6 +40,8 @@
 #include <sstream>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 #include <string.h>
 
 /*!
@@ -82,6 +88,19 @@ using LoggerPtr = std::shared_ptr<Logger>;
  * \ref setLevel().  See \ref Inheritance for more information on levels for loggers
  * inherited from the root.
  *
+ * \section Inheritance Inheritance
+ *
+ * A new named logger has a level of \ref Level::LogLevel NONE, which means it uses
+ * the level of its parent.  Setting a level on it overrides its parent, setting it
+ * back to NONE goes back to the parent's level.
+ *
+ * Messages are also sent to the outputters of every parent up to the root, unless
+ * \ref setAdditivity() is turned off somewhere along the way.  An outputter that is
+ * added to both a logger and one of its parents only gets the message once.
+ *
+ * The effective level and outputters are worked out when they change, not when a
+ * message is logged, so inherited settings cost nothing extra in \ref log().
+ *
  * \code
  * #include <sharklog/standardlayout.h>
  * #include <sharklog/consoleoutputter.h>
@@ -111,17 +130,7 @@ using LoggerPtr = std::shared_ptr<Logger>;
  */
 class SHARKLOGAPI Logger
 {
-    // custom case insensitive string compare
-    struct caseInsensitiveCompare : public std::binary_function<std::string, std::string, bool>
-    {
-        bool operator()(const std::string &lhs, const std::string &rhs) const
-        {
-            return strcasecmp(lhs.c_str(), rhs.c_str()) < 0;
-        }
-    };
-    
     using LoggerList = std::list<LoggerPtr>;
-    using LoggerMap = std::map<std::string, LoggerPtr, caseInsensitiveCompare>;
     
 public:
 	using OutputterList = std::list<OutputterPtr>;
@@ -158,6 +167,9 @@ public:
      *
      * \note Names are NOT case sensitive.
      *
+     * Looking up a logger that already exists does not lock and is safe while other
+     * threads are creating loggers.
+     *
      * \warning Logger names with trailing or extra periods will have the periods stripped.
      * So *com.* is the same as *com* ,  *x..y.z* is the same as *x.y.z*, and a name
      * of '.' is equivalent to an empty name.
@@ -271,6 +283,9 @@ public:
      * open.  However, any new calls to \ref rootLogger() will create a new root logger
      * and it will have to be configured again.
      *
+     * All \ref AsyncOutputter's are closed first, so anything they still have queued
+     * is written out.
+     *
      * @sa closeLogger()
      */
     static void closeRootLogger();
@@ -294,6 +309,8 @@ public:
      * This will return the current \ref Level of the \ref Logger.  This level is inherited see
      * \ref Inheritance for more information.
      *
+     * If no level was set on this logger it is the level of the closest parent that has one.
+     *
      * @return the current Level of the logger
      */
     Level level() const;
@@ -304,16 +321,55 @@ public:
      * Call this to set the \ref Level of the \ref Logger.  This level can be inherited see
      * \ref Inheritance for more information.
      *
+     * Setting a level of NONE on a logger that is not the root goes back to
+     * using the parent's level.
+     *
      * @param lev The \ref Level for the Logger.
      */
     void setLevel(const Level &lev);
     
+    /*!
+     * @brief Checks if a level is enabled
+     *
+     * Checks \a lev against the effective \ref level() of the logger.  This is what the
+     * log macros and \ref LoggerStream use before building a message.  It is inline and
+     * is a single relaxed atomic load, so it is safe to call while another thread calls
+     * \ref setLevel().
+     *
+     * @param lev the level of the message
+     * @return true if a message at \a lev would be logged, false if not
+     */
+    bool isEnabled(Level::LogLevel lev) const
+    {
+        return lev <= threshold_.load(std::memory_order_relaxed);
+    }
+    
+    /*!
+     * @brief Sets the additivity
+     *
+     * When additivity is on, which is the default, messages logged here are also
+     * sent to the outputters of the parent loggers.  Turn it off to only use the
+     * outputters of this logger and its children.  See \ref Inheritance.
+     *
+     * @param additive true to send messages to the parent's outputters, false if not
+     */
+    void setAdditivity(bool additive);
+    
+    /*!
+     * @brief Gets the additivity
+     *
+     * @return true if messages are also sent to the parent's outputters
+     * @sa setAdditivity()
+     */
+    bool additivity() const;
+    
     /*!
      * @brief Checks if valid
      *
      * Checks if the Logger is valid.
      *
-	 * It is valid if it has at least 1 outputter that is valid.
+	 * It is valid if it has at least 1 outputter that is valid, including
+	 * the ones it inherits from its parents.
 
 	 * It will return true if it has invalid Outputters as long
 	 * as one is valid.
@@ -329,6 +385,10 @@ public:
 	 * Add an \ref Outputter to the Logger.  All Outputters will be sent the 
 	 * log message when it is logged. 
 	 *  
+	 * Adding or removing an Outputter publishes a new set for \ref log() to use, on
+	 * this logger and its children.  Messages being logged at the same time finish
+	 * with the set they started with.
+	 *  
 	 * \param op The Outputter to add
 	 */
 	void addOutputter(OutputterPtr op);
@@ -345,8 +405,8 @@ public:
 	/*!
 	 * @brief List of Outputters 
 	 *  
-	 * Gets a list of all the Outputters that this Logger will use when a message 
-	 * is logged. 
+	 * Gets a list of the Outputters that were added to this Logger.  Outputters 
+	 * inherited from the parents are not included. 
 	 * 
 	 * \return OutputterList List of current Outputters
 	 */
@@ -356,7 +416,7 @@ public:
      * @brief Log a message
      *
      * Logs a message \a msg.  This will use the \ref Layout and all the \a Outputter's that
-     * are attached to this logger.
+     * are attached to this logger and, see \ref additivity(), its parents.
      *
      * You can call this function directly or you can use the macros \ref Macros.  You can also
      * use the streaming support class to log using a C++ stream.  See \ref LoggerStream.
@@ -367,6 +427,47 @@ public:
      * @returns true if logged, false if not
      */
     bool log(const Level &level, const std::string &msg, const Location &loc=Location()) const;
+
+    /*!
+     * @brief Log a message that isn't formatted yet
+     *
+     * Like \ref log() but hands the captured arguments in \a msg to the outputters
+     * with \ref Outputter::writeDeferred().  An \ref AsyncOutputter formats them on
+     * its writer thread, other outputters format them straight away.  Use the
+     * SHARKLOG_DEFER_* macros rather than calling this, see \ref SHARKLOG_DEFERRED.
+     *
+     * @param level The level to log this message with
+     * @param msg the captured message arguments
+     * @param loc where the message was logged
+     * @returns true if logged, false if not
+     */
+    bool logDeferred(const Level &level, const DeferredMessage &msg, const Location &loc=Location()) const;
+
+    /*!
+     * @brief Gets the counters
+     *
+     * Records this logger sent to its outputters, per level, and records \ref log() and
+     * \ref logDeferred() dropped for their level.  The counters are per thread
+     * so they cost the logging threads no shared cache lines.
+     *
+     * @sa Outputter::stats(), allStats()
+     */
+    LoggerStats stats() const;
+
+    //! Sets all the counters in \ref stats() to 0
+    void resetStats();
+
+    /*!
+     * @brief Gets the counters of every logger and outputter
+     *
+     * Includes the root logger, every named logger, the outputters added to them
+     * and the outputters wrapped by an \ref AsyncOutputter.
+     *
+     * \code
+     * Logger::allStats().write(std::cout);
+     * \endcode
+     */
+    static StatsSnapshot allStats();
     
     /*!
      * \brief Gets the version
@@ -394,16 +495,35 @@ private:
     LoggerPtr createLogger(LoggerPtr parent, const std::string &baseName);
     void setName(const std::string &loggerName, const std::string &baseName);
     LoggerPtr findParent(const std::string &loggerName);
+    void updateChains();
+    
+    // effective level and flattened outputters used by log(), never changed once
+    // published. The list keeps the raw pointers alive.
+    struct Chain
+    {
+        Level level;
+        OutputterList owners;
+        std::vector<Outputter *> outputters;
+    };
+
+    // reads chain_ and keeps it from being freed while it is in scope, chains
+    // replaced by updateChains() go to EpochReclaimer
+    class ChainReader;
     
 private:
     static LoggerPtr rootLogger_;
-    static LoggerMap allNamedLoggers_;
+    static LoggerRegistry allNamedLoggers_;
     std::string baseName_;
     std::string fullName_;
     LoggerList children_;
     LoggerPtr parent_;
     Level level_;
 	OutputterList outputters_;
+	bool additive_;
+	std::atomic<const Chain *> chain_;
+	// effective level of chain_ for isEnabled()
+	std::atomic<std::uint8_t> threshold_;
+	mutable ShardedCounters counters_;
 	static std::recursive_mutex mutex_;
     static std::string version_;
 };
@@ -415,14 +535,24 @@ private:
  *
  * Use this macro to quickly and easily log using the debug level.
  *
+ * All the log macros check \ref Logger::isEnabled() before the message is built and
+ * evaluate \a logger once.  They compile to nothing when their level is more detailed
+ * than SHARKLOG_COMPILE_MIN_LEVEL, see \ref CompileLevels.
+ *
  * \code
  * SHARKLOG_DEBUG(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_DEBUG
 #define SHARKLOG_DEBUG(logger, message) { \
-    if (logger->level().hasDebug()) {\
-        logger->log(Level::debug(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::DEBUG)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::debug(), message, sharklog_location_); } \
     }
+#else
+#define SHARKLOG_DEBUG(logger, message) { }
+#endif
 
 /*!
  * \brief Trace log macro
@@ -433,10 +563,16 @@ private:
  * SHARKLOG_TRACE(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_TRACE
 #define SHARKLOG_TRACE(logger, message) { \
-    if (logger->level().hasTrace()) {\
-        logger->log(Level::trace(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::TRACE)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::trace(), message, sharklog_location_); } \
     }
+#else
+#define SHARKLOG_TRACE(logger, message) { }
+#endif
 
 /*!
  * \brief Info log macro
@@ -447,10 +583,16 @@ private:
  * SHARKLOG_INFO(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_INFO
 #define SHARKLOG_INFO(logger, message) { \
-    if (logger->level().hasInfo()) {\
-        logger->log(Level::info(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::INFO)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::info(), message, sharklog_location_); } \
     }
+#else
+#define SHARKLOG_INFO(logger, message) { }
+#endif
 
 /*!
  * \brief Warn log macro
@@ -461,10 +603,16 @@ private:
  * SHARKLOG_WARN(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_WARN
 #define SHARKLOG_WARN(logger, message) { \
-    if (logger->level().hasWarn()) {\
-        logger->log(Level::warn(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::WARN)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::warn(), message, sharklog_location_); } \
     }
+#else
+#define SHARKLOG_WARN(logger, message) { }
+#endif
 
 /*!
  * \brief Error log macro
@@ -475,10 +623,16 @@ private:
  * SHARKLOG_ERROR(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_ERROR
 #define SHARKLOG_ERROR(logger, message) { \
-    if (logger->level().hasError()) {\
-        logger->log(Level::error(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::ERROR)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::error(), message, sharklog_location_); } \
     }
+#else
+#define SHARKLOG_ERROR(logger, message) { }
+#endif
 
 /*!
  * \brief Fatal log macro
@@ -489,9 +643,152 @@ private:
  * SHARKLOG_FATAL(Logger::rootLogger(), "hi guys");
  * \endcode
  */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_FATAL
 #define SHARKLOG_FATAL(logger, message) { \
-    if (logger->level().hasFatal()) {\
-        logger->log(Level::fatal(), message, SHARKLOG_LOCATION); } \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(sharklog::Level::FATAL)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog_logger_->log(sharklog::Level::fatal(), message, sharklog_location_); } \
+    }
+#else
+#define SHARKLOG_FATAL(logger, message) { }
+#endif
+
+/*!
+ * \brief Deferred log macro
+ *
+ * Logs the values of the arguments after \a lev (a Level::LogLevel) as if they
+ * were streamed one after the other, without formatting them on the calling
+ * thread.  The values are copied into a \ref sharklog::DeferredMessage and an
+ * \ref sharklog::AsyncOutputter formats them on its writer thread.  Strings
+ * are copied, wrap a literal in a \ref sharklog::DeferredLiteral to keep it
+ * by pointer, see \ref sharklog::DeferredMessage.
+ *
+ * Use the SHARKLOG_DEFER_* macros for each level, they are compiled out like the
+ * other log macros.
+ *
+ * \code
+ * SHARKLOG_DEFER_INFO(log, "order ", id, " filled ", qty, " at ", price);
+ * \endcode
+ */
+#define SHARKLOG_DEFERRED(logger, lev, ...) { \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(lev)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        sharklog::DeferredMessage sharklog_message_; \
+        sharklog_message_.capture(__VA_ARGS__); \
+        sharklog_logger_->logDeferred(sharklog::Level(lev), sharklog_message_, sharklog_location_); } \
+    }
+
+//! Deferred \ref SHARKLOG_DEBUG, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_DEBUG
+#define SHARKLOG_DEFER_DEBUG(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::DEBUG, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_DEBUG(logger, ...) { }
+#endif
+
+//! Deferred \ref SHARKLOG_TRACE, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_TRACE
+#define SHARKLOG_DEFER_TRACE(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::TRACE, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_TRACE(logger, ...) { }
+#endif
+
+//! Deferred \ref SHARKLOG_INFO, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_INFO
+#define SHARKLOG_DEFER_INFO(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::INFO, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_INFO(logger, ...) { }
+#endif
+
+//! Deferred \ref SHARKLOG_WARN, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_WARN
+#define SHARKLOG_DEFER_WARN(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::WARN, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_WARN(logger, ...) { }
+#endif
+
+//! Deferred \ref SHARKLOG_ERROR, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_ERROR
+#define SHARKLOG_DEFER_ERROR(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::ERROR, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_ERROR(logger, ...) { }
+#endif
+
+//! Deferred \ref SHARKLOG_FATAL, see \ref SHARKLOG_DEFERRED
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_FATAL
+#define SHARKLOG_DEFER_FATAL(logger, ...) SHARKLOG_DEFERRED(logger, sharklog::Level::FATAL, __VA_ARGS__)
+#else
+#define SHARKLOG_DEFER_FATAL(logger, ...) { }
+#endif
+
+/*!
+ * \brief Binary log macro
+ *
+ * Like \ref SHARKLOG_DEFERRED but with a format string, each {} in \a format
+ * is replaced by the next argument.  The call site registers \a format, \a lev
+ * and its location once as a \ref sharklog::LogSite and each record only
+ * carries the site and the arguments.  A \ref sharklog::BinaryFileOutputter
+ * writes them as they are, without formatting any text, other outputters
+ * format them like deferred messages.
+ *
+ * \a format must be a string literal.  Use the SHARKLOG_BINARY_* macros for
+ * each level, they are compiled out like the other log macros.
+ *
+ * \code
+ * SHARKLOG_BINARY_INFO(log, "order {} filled {} at {}", id, qty, price);
+ * \endcode
+ */
+#define SHARKLOG_BINARY(logger, lev, format, ...) { \
+    const auto &sharklog_logger_ = logger; \
+    if (sharklog_logger_->isEnabled(lev)) {\
+        SHARKLOG_STATIC_LOCATION(sharklog_location_); \
+        static const sharklog::LogSite *sharklog_site_ = sharklog::LogSite::add(format, lev, sharklog_location_); \
+        sharklog::DeferredMessage sharklog_message_(sharklog_site_); \
+        sharklog_message_.capture(__VA_ARGS__); \
+        sharklog_logger_->logDeferred(sharklog::Level(lev), sharklog_message_, sharklog_location_); } \
     }
 
+//! Binary \ref SHARKLOG_DEBUG, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_DEBUG
+#define SHARKLOG_BINARY_DEBUG(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::DEBUG, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_DEBUG(logger, ...) { }
+#endif
+
+//! Binary \ref SHARKLOG_TRACE, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_TRACE
+#define SHARKLOG_BINARY_TRACE(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::TRACE, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_TRACE(logger, ...) { }
+#endif
+
+//! Binary \ref SHARKLOG_INFO, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_INFO
+#define SHARKLOG_BINARY_INFO(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::INFO, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_INFO(logger, ...) { }
+#endif
+
+//! Binary \ref SHARKLOG_WARN, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_WARN
+#define SHARKLOG_BINARY_WARN(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::WARN, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_WARN(logger, ...) { }
+#endif
+
+//! Binary \ref SHARKLOG_ERROR, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_ERROR
+#define SHARKLOG_BINARY_ERROR(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::ERROR, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_ERROR(logger, ...) { }
+#endif
+
+//! Binary \ref SHARKLOG_FATAL, see \ref SHARKLOG_BINARY
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_FATAL
+#define SHARKLOG_BINARY_FATAL(logger, ...) SHARKLOG_BINARY(logger, sharklog::Level::FATAL, __VA_ARGS__)
+#else
+#define SHARKLOG_BINARY_FATAL(logger, ...) { }
+#endif
+
 #endif // Logger_H
@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "loggerregistry.h"
+#include "logger.h"
+#include "epochreclaimer.h"
+#include <cctype>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	const std::size_t MinBuckets = 16;
+
+	inline unsigned char foldChar(char c)
+	{
+		return (unsigned char)tolower((unsigned char)c);
+	}
+}
+
+LoggerRegistry::Table::Table(std::size_t bucketCount)
+	: buckets(bucketCount)
+	, mask(bucketCount - 1)
+	, erased(0)
+{
+	for (auto &it : buckets)
+		it.store(nullptr, memory_order_relaxed);
+}
+
+LoggerRegistry::LoggerRegistry()
+	: table_(new Table(MinBuckets))
+	, size_(0)
+{
+}
+
+LoggerRegistry::~LoggerRegistry()
+{
+	delete table_.load();
+}
+
+Logger *LoggerRegistry::find(const std::string &name) const
+{
+	return get(name).get();
+}
+
+std::shared_ptr<Logger> LoggerRegistry::get(const std::string &name) const
+{
+	// keeps the table from being freed while we look
+	EpochReclaimer::Reader reader;
+	auto node = findNode(name);
+
+	// erase() resets the logger while lookups may be copying it
+	return node ? atomic_load(&node->logger) : std::shared_ptr<Logger>();
+}
+
+const LoggerRegistry::Node *LoggerRegistry::findNode(const std::string &name) const
+{
+	auto h = hash(name);
+	auto table = table_.load(memory_order_acquire);
+
+	for (auto node = table->buckets[h & table->mask].load(memory_order_acquire); node; node = node->next)
+	{
+		if (node->hash != h || node->key.size() != name.size() || node->erased.load(memory_order_acquire))
+			continue;
+
+		std::size_t i = 0;
+		while (i < name.size() && (unsigned char)node->key[i] == foldChar(name[i]))
+			++i;
+
+		if (i == name.size())
+			return node;
+	}
+
+	return nullptr;
+}
+
+void LoggerRegistry::insert(const std::string &name, std::shared_ptr<Logger> logger)
+{
+	auto table = table_.load(memory_order_relaxed);
+
+	// keep the load factor at or below 1
+	if (size_ + 1 > table->buckets.size())
+	{
+		rebuild(table->buckets.size() * 2);
+		table = table_.load(memory_order_relaxed);
+	}
+
+	link(table, hash(name), fold(name), logger);
+	++size_;
+}
+
+void LoggerRegistry::erase(const std::string &name)
+{
+	auto node = findNode(name);
+	if (!node)
+		return;
+
+	// lookups skip erased nodes, they are dropped when the table is rebuilt.
+	// Readers copy the logger out, so it can go now
+	auto erased = const_cast<Node *>(node);
+	erased->erased.store(true, memory_order_release);
+	atomic_store(&erased->logger, std::shared_ptr<Logger>());
+	--size_;
+
+	auto table = table_.load(memory_order_relaxed);
+	if (++table->erased > MinBuckets && table->erased > size_)
+	{
+		auto buckets = table->buckets.size();
+		while (buckets > MinBuckets && size_ <= buckets / 4)
+			buckets /= 2;
+		rebuild(buckets);
+	}
+}
+
+void LoggerRegistry::clear()
+{
+	auto old = table_.exchange(new Table(MinBuckets));
+	delete old;
+	size_ = 0;
+}
+
+std::size_t LoggerRegistry::size() const
+{
+	return size_;
+}
+
+std::vector<std::shared_ptr<Logger>> LoggerRegistry::loggers() const
+{
+	std::vector<std::shared_ptr<Logger>> result;
+	EpochReclaimer::Reader reader;
+	auto table = table_.load(memory_order_acquire);
+	for (auto &bucket : table->buckets)
+	{
+		for (auto node = bucket.load(memory_order_acquire); node; node = node->next)
+		{
+			auto logger = atomic_load(&node->logger);
+			if (logger && !node->erased.load(memory_order_acquire))
+				result.push_back(logger);
+		}
+	}
+
+	return result;
+}
+
+void LoggerRegistry::link(Table *table, std::size_t hash, const std::string &key, std::shared_ptr<Logger> logger)
+{
+	auto &bucket = table->buckets[hash & table->mask];
+
+	std::unique_ptr<Node> node(new Node);
+	node->hash = hash;
+	node->key = key;
+	node->logger = logger;
+	node->erased.store(false, memory_order_relaxed);
+	node->next = bucket.load(memory_order_relaxed);
+
+	// the node is complete before it can be seen
+	bucket.store(node.get(), memory_order_release);
+	table->nodes.push_back(std::move(node));
+}
+
+void LoggerRegistry::rebuild(std::size_t bucketCount)
+{
+	auto old = table_.load(memory_order_relaxed);
+	std::unique_ptr<Table> table(new Table(bucketCount));
+
+	for (auto &it : old->nodes)
+	{
+		if (!it->erased.load(memory_order_relaxed))
+			link(table.get(), it->hash, it->key, it->logger);
+	}
+
+	table_.store(table.release(), memory_order_release);
+
+	// readers may still be walking the old table
+	EpochReclaimer::retire(std::unique_ptr<Table>(old));
+}
+
+std::size_t LoggerRegistry::hash(const std::string &name)
+{
+	// FNV-1a over the case folded name
+	unsigned long long h = 14695981039346656037ULL;
+	for (auto c : name)
+	{
+		h ^= foldChar(c);
+		h *= 1099511628211ULL;
+	}
+
+	return (std::size_t)h;
+}
+
+std::string LoggerRegistry::fold(const std::string &name)
+{
+	std::string folded(name);
+	for (auto &c : folded)
+		c = (char)foldChar(c);
+	return folded;
+}
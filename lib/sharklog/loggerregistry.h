@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __loggerregistry_H
+#define __loggerregistry_H
+
+#include <sharklog/sharklogdefs.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace sharklog
+{
+
+class Logger;
+
+/*!
+ * \brief Named logger registry
+ *
+ * This is the lookup table used by \ref Logger to find named loggers.  It is
+ * internal to the library.
+ *
+ * It is a hash table that is built for lookups.  Names are hashed and
+ * compared without case, the case folded name is computed once when a logger
+ * is added.  Lookups never take the \ref Logger lock and never allocate.  The
+ * only thing they can wait on is a thread adding or removing loggers copying
+ * the same shared pointer, entries are read and reset with std::atomic_load()
+ * and std::atomic_store().
+ *
+ * Changes are made by one thread at a time (\ref Logger holds its lock for
+ * that).  A new entry is linked in fully built and published with a single
+ * atomic store.  When the table needs to grow, or has too many removed
+ * entries, a new table is built and published atomically, copy-on-write
+ * style.  A lookup may still be reading the old table, it is handed to
+ * \ref EpochReclaimer and freed once no lookup can be.  A removed entry lets
+ * go of its logger straight away, the entry itself goes with the next table.
+ */
+class SHARKLOGAPI LoggerRegistry
+{
+public:
+	//! Constructor
+	LoggerRegistry();
+
+	//! Destructor
+	~LoggerRegistry();
+
+	/*!
+	 * \brief Finds a logger
+	 *
+	 * Finds the logger named \a name, case does not matter.  This can be
+	 * called from any thread at any time.
+	 *
+	 * The pointer is only good while the logger is in the registry, use
+	 * \ref get() to keep it.
+	 *
+	 * \param name the full name of the logger
+	 * \return a pointer to the Logger or nullptr if there is none
+	 */
+	Logger *find(const std::string &name) const;
+
+	/*!
+	 * \brief Finds a logger
+	 *
+	 * Same as \ref find() but returns the shared pointer.
+	 *
+	 * \param name the full name of the logger
+	 * \return the logger or an empty pointer if there is none
+	 */
+	std::shared_ptr<Logger> get(const std::string &name) const;
+
+	/*!
+	 * \brief Adds a logger
+	 *
+	 * Adds \a logger with \a name.  The caller must make sure only one
+	 * thread changes the registry at a time.
+	 *
+	 * \param name the full name of the logger
+	 * \param logger the logger
+	 */
+	void insert(const std::string &name, std::shared_ptr<Logger> logger);
+
+	/*!
+	 * \brief Removes a logger
+	 *
+	 * Removes the logger named \a name.  The caller must make sure only one
+	 * thread changes the registry at a time.
+	 *
+	 * \param name the full name of the logger
+	 */
+	void erase(const std::string &name);
+
+	/*!
+	 * \brief Removes all loggers
+	 *
+	 * Removes all the loggers.  No other thread may be using the registry
+	 * while this is called.
+	 */
+	void clear();
+
+	//! The number of loggers in the registry
+	std::size_t size() const;
+
+	/*!
+	 * \brief All loggers
+	 *
+	 * Returns all the loggers in the registry, in no particular order.
+	 *
+	 * \return the loggers
+	 */
+	std::vector<std::shared_ptr<Logger>> loggers() const;
+
+private:
+	struct Node
+	{
+		std::size_t hash;
+		std::string key; // case folded name
+		std::shared_ptr<Logger> logger;
+		std::atomic<bool> erased;
+		const Node *next;
+	};
+
+	struct Table
+	{
+		Table(std::size_t bucketCount);
+
+		std::vector<std::atomic<const Node *>> buckets;
+		std::vector<std::unique_ptr<Node>> nodes;
+		std::size_t mask;
+		std::size_t erased;
+	};
+
+	LoggerRegistry(const LoggerRegistry &);
+	LoggerRegistry &operator=(const LoggerRegistry &);
+
+	const Node *findNode(const std::string &name) const;
+	void link(Table *table, std::size_t hash, const std::string &key, std::shared_ptr<Logger> logger);
+	void rebuild(std::size_t bucketCount);
+
+	static std::size_t hash(const std::string &name);
+	static std::string fold(const std::string &name);
+
+	std::atomic<Table *> table_;
+	std::atomic<std::size_t> size_;
+};
+
+} // sharklog
+
+#endif // loggerregistry_H
@@ -23,21 +23,158 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "loggerstream.h"
+#include <streambuf>
+#include <vector>
+#include <memory>
+#include <cstring>
 
 using namespace sharklog;
 
+/*
+ * A streambuf that appends to a std::string through a small put area, and an
+ * ostream writing to it.  Both are built once and reused, constructing a
+ * stream costs a locale and resetting a stringstream allocates.
+ */
+class LoggerStream::Buffer : public std::streambuf
+{
+public:
+    Buffer() : stream_(this)
+    {
+        setp(chunk_, chunk_ + sizeof(chunk_));
+        defaultFlags_ = stream_.flags();
+        defaultFill_ = stream_.fill();
+    }
+    
+    std::ostream &stream() { return stream_; }
+    
+    // the message so far, valid until the next write
+    const std::string &text()
+    {
+        sync();
+        return text_;
+    }
+    
+    // forgets the text and the stream state for the next message
+    void reset()
+    {
+        text_.clear();
+        setp(chunk_, chunk_ + sizeof(chunk_));
+        stream_.clear();
+        stream_.flags(defaultFlags_);
+        stream_.precision(6);
+        stream_.width(0);
+        stream_.fill(defaultFill_);
+    }
+    
+protected:
+    int_type overflow(int_type c) override
+    {
+        sync();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        // long pieces skip the put area
+        if (n > epptr() - pptr())
+        {
+            sync();
+            text_.append(s, (std::size_t)n);
+        }
+        else
+        {
+            memcpy(pptr(), s, (std::size_t)n);
+            pbump((int)n);
+        }
+        return n;
+    }
+    
+    int sync() override
+    {
+        text_.append(pbase(), pptr() - pbase());
+        setp(chunk_, chunk_ + sizeof(chunk_));
+        return 0;
+    }
+    
+private:
+    char chunk_[128];
+    std::string text_;
+    std::ostream stream_;
+    std::ios_base::fmtflags defaultFlags_;
+    char defaultFill_;
+};
+
+namespace
+{
+    // set once the pool of this thread is gone, streams destroyed after that
+    // (i.e. statics on the main thread) free their buffer
+    thread_local bool poolGone_ = false;
+}
+
+std::vector<std::unique_ptr<LoggerStream::Buffer>> &LoggerStream::pool()
+{
+    // buffers not used by a stream, reused by the next one on this thread
+    struct Pool
+    {
+        std::vector<std::unique_ptr<Buffer>> free;
+        ~Pool() { poolGone_ = true; }
+    };
+    
+    thread_local Pool pool;
+    return pool.free;
+}
+
 LoggerStream::LoggerStream(LoggerPtr lp, const Level &lev)
+    : buffer_(nullptr)
 {
     setLevel(lev);
     setLogger(lp);
 }
 
 LoggerStream::LoggerStream(const std::string &loggerName, const Level &lev)
+    : buffer_(nullptr)
 {
     setLevel(lev);
     setLogger(Logger::logger(loggerName));
 }
 
+LoggerStream::~LoggerStream()
+{
+    if (!buffer_)
+        return;
+    
+    // the pool is the one of the thread destroying us, buffers can move
+    if (poolGone_)
+    {
+        delete buffer_;
+        return;
+    }
+    
+    buffer_->reset();
+    pool().emplace_back(buffer_);
+}
+
+LoggerStream::Buffer &LoggerStream::buffer()
+{
+    if (!buffer_)
+    {
+        auto &free = pool();
+        if (free.empty())
+            buffer_ = new Buffer;
+        else
+        {
+            buffer_ = free.back().release();
+            free.pop_back();
+        }
+    }
+    return *buffer_;
+}
+
 LoggerStream &LoggerStream::operator<<(const Level &lev)
 {
     setLevel(lev);
@@ -52,12 +189,19 @@ LoggerStream &LoggerStream::operator<<(const Location &loc)
 
 void LoggerStream::end()
 {
-    // log the message
-    logger()->log(level(), data_.str(), loc_);
+    if (!buffer_)
+    {
+        if (isEnabled())
+            logger()->log(level(), std::string(), loc_);
+        return;
+    }
+    
+    // log the message straight from the buffer, no copy
+    if (isEnabled())
+        logger()->log(level(), buffer_->text(), loc_);
     
     // clear the stream
-    std::basic_string<char> emp;
-    data_.str(emp);
+    buffer_->reset();
 }
 
 LoggerStream &LoggerStream::end(LoggerStream &s)
@@ -88,7 +232,7 @@ void LoggerStream::setLogger(LoggerPtr lp)
 
 std::string LoggerStream::data() const
 {
-    return data_.str();
+    return buffer_ ? buffer_->text() : std::string();
 }
 
 Location LoggerStream::location() const
@@ -103,5 +247,5 @@ LoggerStream &LoggerStream::operator<<(LoggerFuncPtr pf)
 
 LoggerStream::operator std::basic_ostream<char> &()
 {
-    return data_;
+    return buffer().stream();
 }
@@ -29,7 +29,10 @@
 #include <sharklog/level.h>
 #include <sharklog/logger.h>
 #include <sharklog/location.h>
-#include <sstream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <memory>
 
 /*!
  * \file loggerstream.h
@@ -69,6 +72,10 @@ using LoggerFuncPtr = LoggerStream &(*)(LoggerStream&);
  * \endcode
  *
  * \note A stream will never flush out to the logger if you don't call \ref end() or \ref SHARKLOG_END.
+ *
+ * The text is formatted into a buffer that is reused by the thread, so once
+ * it has grown to the longest message a streamed log line doesn't allocate.
+ * Each message starts with the default stream flags, precision and fill.
  */
 class SHARKLOGAPI LoggerStream
 {
@@ -102,6 +109,9 @@ public:
      */
     LoggerStream(const std::string &loggerName, const Level &lev=Level::trace());
     
+    //! Destructor, gives the buffer back to the thread
+    ~LoggerStream();
+    
     /*!
      * \brief Gets logger used by the stream
      *
@@ -227,16 +237,34 @@ public:
      * LoggerStream() << "an int " << 10 << SHARKLOG_END;
      * \endcode
      *
+     * Nothing is formatted while the level is not enabled on the logger, see
+     * \ref isEnabled().
+     *
      * @param val The variable to log
      * @return Reference to the stream
      */
     template <class var>
     inline sharklog::LoggerStream &operator<<(const var &val)
     {
-        ((std::basic_ostream<char>&) *this) << val;
+        if (isEnabled())
+            ((std::basic_ostream<char>&) *this) << val;
         return *this;
     }
     
+    /*!
+     * \brief Checks if the stream will log
+     *
+     * Checks the stream's \ref level() with \ref Logger::isEnabled().  Values streamed
+     * while this is false are skipped without being formatted and \ref end() does not
+     * log anything.
+     *
+     * @return true if the current level is enabled on the logger, false if not
+     */
+    bool isEnabled() const
+    {
+        return logger_ && logger_->isEnabled(level_.level());
+    }
+    
     /*!
      * \brief Ends the stream
      *
@@ -249,13 +277,18 @@ public:
     
 private:
     // block copies
-    LoggerStream(LoggerStream &) { }
+    LoggerStream(LoggerStream &) : buffer_(nullptr) { }
     LoggerStream &operator=(LoggerStream &) { return *this; }
     
+    // pooled per thread, taken the first time something is streamed
+    class Buffer;
+    Buffer &buffer();
+    static std::vector<std::unique_ptr<Buffer>> &pool();
+    
     Location loc_;
     LoggerPtr logger_;
     Level level_;
-    std::basic_stringstream<char> data_;
+    Buffer *buffer_;
 };
 
 /*!
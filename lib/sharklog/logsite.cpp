@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "logsite.h"
+#include <mutex>
+#include <deque>
+#include <memory>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	mutex &sitesMutex()
+	{
+		static mutex m;
+		return m;
+	}
+
+	// sites are only added, so the pointers handed out stay valid
+	deque<unique_ptr<LogSite>> &sites()
+	{
+		static deque<unique_ptr<LogSite>> s;
+		return s;
+	}
+}
+
+LogSite::LogSite(std::uint32_t id, const char *format, Level::LogLevel level, const Location &loc)
+	: id_(id)
+	, format_(format ? format : "")
+	, level_(level)
+	, location_(loc)
+{
+}
+
+const LogSite *LogSite::add(const char *format, Level::LogLevel level, const Location &loc)
+{
+	lock_guard<mutex> lock(sitesMutex());
+	auto &all = sites();
+	all.emplace_back(new LogSite((std::uint32_t)all.size() + 1, format, level, loc));
+	return all.back().get();
+}
+
+std::uint32_t LogSite::count()
+{
+	lock_guard<mutex> lock(sitesMutex());
+	return (std::uint32_t)sites().size();
+}
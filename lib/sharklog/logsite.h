@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __logsite_H
+#define __logsite_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/level.h>
+#include <sharklog/location.h>
+#include <cstdint>
+
+namespace sharklog
+{
+
+/*!
+ * \brief A log call site with a static format string
+ *
+ * Each SHARKLOG_BINARY_* macro registers its format string, level and
+ * \ref Location once, the first time it runs, and gets a LogSite with a
+ * numeric id.  Records from the site only carry the site and their arguments
+ * (see \ref DeferredMessage) so outputters that write binary records, like
+ * \ref BinaryFileOutputter, write the format string and location once per
+ * file instead of once per record.
+ *
+ * Sites are never removed, the pointers stay valid until the program exits.
+ */
+class SHARKLOGAPI LogSite
+{
+public:
+	/*!
+	 * \brief Registers a call site
+	 *
+	 * \param format the format string, {} is replaced by each argument.  It
+	 * must outlive the site, normally it is a literal
+	 * \param level the level logged at the site
+	 * \param loc the location of the site
+	 * \return the new site
+	 */
+	static const LogSite *add(const char *format, Level::LogLevel level, const Location &loc);
+
+	//! Number of sites registered so far, ids go from 1 to this
+	static std::uint32_t count();
+
+	//! The id of the site, unique in this process and never 0
+	std::uint32_t id() const { return id_; }
+
+	//! The format string of the site
+	const char *format() const { return format_; }
+
+	//! The level logged at the site
+	Level::LogLevel level() const { return level_; }
+
+	//! The location of the site
+	const Location &location() const { return location_; }
+
+private:
+	LogSite(std::uint32_t id, const char *format, Level::LogLevel level, const Location &loc);
+	LogSite(const LogSite &);
+	LogSite &operator=(const LogSite &);
+
+	std::uint32_t id_;
+	const char *format_;
+	Level::LogLevel level_;
+	Location location_;
+};
+
+} // sharklog
+
+#endif // logsite_H
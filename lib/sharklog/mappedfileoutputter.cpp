@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mappedfileoutputter.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <cstring>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#define SHARKLOG_HAVE_MMAP
+#endif
+
+using namespace sharklog;
+using namespace std;
+
+const std::size_t MappedFileOutputter::DefaultChunkSize;
+const std::size_t MappedFileOutputter::MaxChunks;
+
+namespace
+{
+#if defined(SHARKLOG_HAVE_MMAP)
+	// make sure the file has blocks up to size so writes to the mapping can't SIGBUS
+	bool reserve(int fd, std::uint64_t size)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && (std::uint64_t)st.st_size >= size)
+			return true;
+
+#if defined(__linux__)
+		if (posix_fallocate(fd, 0, size) == 0)
+			return true;
+#endif
+		// no fallocate or the file system doesn't support it
+		return ftruncate(fd, size) == 0;
+	}
+#endif
+}
+
+MappedFileOutputter::MappedFileOutputter(const std::string &filename)
+	: filename_(filename)
+	, append_(false)
+	, chunkSize_(DefaultChunkSize)
+	, openChunkSize_(DefaultChunkSize)
+	, fd_(-1)
+	, open_(false)
+	, offset_(0)
+	, writers_(0)
+	, dropped_(0)
+	, failedAt_(0)
+{
+	for (auto &it : chunks_)
+		it = nullptr;
+}
+
+MappedFileOutputter::~MappedFileOutputter()
+{
+	close();
+}
+
+void MappedFileOutputter::setFilename(const std::string &filename)
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	filename_ = filename;
+}
+
+std::string MappedFileOutputter::filename() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return filename_;
+}
+
+void MappedFileOutputter::setAppend(bool append)
+{
+	lock_guard<mutex> lock(mutex_);
+	append_ = append;
+}
+
+bool MappedFileOutputter::append() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return append_;
+}
+
+void MappedFileOutputter::setChunkSize(std::size_t bytes)
+{
+	lock_guard<mutex> lock(mutex_);
+	chunkSize_ = bytes;
+}
+
+std::size_t MappedFileOutputter::chunkSize() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return chunkSize_;
+}
+
+bool MappedFileOutputter::open()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+
+#if defined(SHARKLOG_HAVE_MMAP)
+	int flags = O_RDWR | O_CREAT | O_CLOEXEC | (append_ ? 0 : O_TRUNC);
+	fd_ = ::open(filename_.c_str(), flags, 0644);
+	if (fd_ < 0)
+		return false;
+
+	std::size_t page = sysconf(_SC_PAGESIZE);
+	openChunkSize_ = std::max<std::size_t>(page, (chunkSize_ + page - 1) / page * page);
+
+	struct stat st;
+	offset_ = (fstat(fd_, &st) == 0) ? st.st_size : 0;
+	dropped_ = 0;
+	failedAt_ = std::numeric_limits<std::uint64_t>::max();
+
+	open_ = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MappedFileOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	if (!isOpen() || !isValid())
+		return;
+
+	auto &record = formatBuffer();
+	record.clear();
+	layout()->formatRecord(record, lev, loggerName, logMessage, loc);
+	countFormatted(record.size());
+
+	// close() waits for writers_ to reach 0 after clearing open_
+	++writers_;
+	if (!open_)
+	{
+		--writers_;
+		return;
+	}
+
+	auto size = openChunkSize_;
+	auto start = offset_.fetch_add(record.size());
+	auto pos = start;
+	auto end = pos + record.size();
+
+	// map the next chunk when we cross the middle of this one
+	if (pos % size < size / 2 && (pos % size) + record.size() >= size / 2)
+		chunk(pos / size + 1);
+
+	const char *src = record.data();
+	while (pos < end)
+	{
+		auto index = pos / size;
+		auto dest = chunk(index);
+		if (!dest)
+		{
+			// the file is cut in front of this record and nothing after it is
+			// written, so it can't have holes where records are missing
+			open_ = false;
+			auto failed = failedAt_.load();
+			while (start < failed && !failedAt_.compare_exchange_weak(failed, start))
+				;
+			++dropped_;
+			countWriteError();
+			--writers_;
+			return;
+		}
+
+		auto at = pos % size;
+		auto len = std::min<std::uint64_t>(size - at, end - pos);
+		memcpy(dest + at, src, len);
+		src += len;
+		pos += len;
+	}
+	countWritten(record.size());
+
+	--writers_;
+}
+
+void MappedFileOutputter::close()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+}
+
+bool MappedFileOutputter::isOpen() const
+{
+	return open_;
+}
+
+std::uint64_t MappedFileOutputter::size() const
+{
+	return offset_;
+}
+
+unsigned long long MappedFileOutputter::droppedCount() const
+{
+	return dropped_;
+}
+
+char *MappedFileOutputter::chunk(std::size_t index)
+{
+	if (index >= MaxChunks)
+		return nullptr;
+
+	auto ptr = chunks_[index].load(memory_order_acquire);
+	if (ptr)
+		return ptr;
+
+#if defined(SHARKLOG_HAVE_MMAP)
+	lock_guard<mutex> lock(chunkMutex_);
+	ptr = chunks_[index].load(memory_order_acquire);
+	if (ptr)
+		return ptr;
+
+	std::uint64_t start = (std::uint64_t)index * openChunkSize_;
+	if (!reserve(fd_, start + openChunkSize_))
+		return nullptr;
+
+	int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+	// fault the pages in now instead of one at a time while writing records
+	flags |= MAP_POPULATE;
+#endif
+	auto map = mmap(nullptr, openChunkSize_, PROT_READ | PROT_WRITE, flags, fd_, start);
+	if (map == MAP_FAILED)
+		return nullptr;
+
+	ptr = static_cast<char *>(map);
+	chunks_[index].store(ptr, memory_order_release);
+#endif
+	return ptr;
+}
+
+void MappedFileOutputter::closeFile()
+{
+	// called with mutex_ held, open_ is already clear if a write failed
+	if (fd_ < 0)
+		return;
+
+	open_ = false;
+	while (writers_.load())
+		this_thread::yield();
+
+#if defined(SHARKLOG_HAVE_MMAP)
+	lock_guard<mutex> lock(chunkMutex_);
+	for (auto &it : chunks_)
+	{
+		auto ptr = it.exchange(nullptr);
+		if (ptr)
+			munmap(ptr, openChunkSize_);
+	}
+
+	// anything from the first record that failed on was dropped, not written
+	std::uint64_t written = std::min<std::uint64_t>(offset_, failedAt_);
+	auto res = ftruncate(fd_, written);
+	(void)res;
+	::close(fd_);
+#endif
+	fd_ = -1;
+}
@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __mappedfileoutputter_H
+#define __mappedfileoutputter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/outputter.h>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sharklog
+{
+
+/*!
+ * \brief File outputter that copies records into a memory mapped file
+ *
+ * MappedFileOutputter preallocates the log file in large chunks, maps each
+ * chunk and appends records with a memcpy into the mapping.  Threads reserve
+ * space for their record by advancing an atomic offset, so writers never take
+ * a lock.  The only lock is taken by the writer that first reaches a chunk
+ * that is not mapped yet, and writers map the next chunk before they get
+ * there once the current one is half full.
+ *
+ * Records are in the page cache as soon as the copy is done, so they survive
+ * the process crashing.  \ref close() cuts the file down to what was
+ * written.  A file left by a crash ends with zeros up to the end of the last
+ * chunk.
+ *
+ * When a chunk can't be mapped, or the file reaches \ref MaxChunks chunks, the
+ * record that needed it is dropped and the outputter stops writing,
+ * \ref isOpen() is false from then on.  \ref close() cuts the file in front
+ * of that record, so the file never has zeros where records are missing.
+ *
+ * Only available on POSIX systems, \ref open() fails on Windows.
+ *
+ * \code
+ * auto fop = std::make_shared<MappedFileOutputter>("/tmp/test.log");
+ * fop->setLayout(std::make_shared<StandardLayout>());
+ * if (!fop->open())
+ *    return 1; // fail
+ * Logger::rootLogger()->addOutputter(fop);
+ * \endcode
+ */
+class SHARKLOGAPI MappedFileOutputter : public Outputter
+{
+public:
+	//! Default size the file grows by, in bytes
+	static const std::size_t DefaultChunkSize = 64 * 1024 * 1024;
+
+	//! Most chunks a file can have, records past the last one are dropped
+	static const std::size_t MaxChunks = 4096;
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * \param filename the file path to the file you want to write
+	 * \sa setFilename()
+	 */
+	MappedFileOutputter(const std::string &filename = std::string());
+
+	//! Destructor, closes the file
+	virtual ~MappedFileOutputter();
+
+	/*!
+	 * \brief Sets the file name/path
+	 *
+	 * Closes the file if it is open, see \ref close().
+	 *
+	 * \param filename the filename and path for the log file
+	 */
+	void setFilename(const std::string &filename);
+
+	//! Gets the file name and path for the log file
+	std::string filename() const;
+
+	/*!
+	 * \brief Set append file mode
+	 *
+	 * True to append to an existing file, false (the default) to truncate it.
+	 * Only used when opening the file.
+	 */
+	void setAppend(bool append);
+
+	//! Get append mode
+	bool append() const;
+
+	/*!
+	 * \brief Sets how much the file grows by at a time
+	 *
+	 * Rounded up to a multiple of the page size.  Only used when opening the
+	 * file.
+	 */
+	void setChunkSize(std::size_t bytes);
+
+	//! Gets the chunk size in bytes
+	std::size_t chunkSize() const;
+
+	/*!
+	 * \brief Open the log file
+	 *
+	 * \return true if opened, false if failed
+	 */
+	virtual bool open() override;
+
+	//! Copies a formatted record into the mapping
+	virtual void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+	/*!
+	 * \brief Close the log file
+	 *
+	 * Waits for writers that are copying records, unmaps the file and truncates
+	 * it to the size that was written.
+	 */
+	virtual void close() override;
+
+	//! Checks to see if the file is open, false once a write failed
+	virtual bool isOpen() const override;
+
+	//! Bytes written since the file was opened, plus its size if appending
+	std::uint64_t size() const;
+
+	//! Records dropped because the file reached \ref MaxChunks chunks or a chunk couldn't be mapped
+	unsigned long long droppedCount() const;
+
+private:
+	MappedFileOutputter(const MappedFileOutputter &);
+	MappedFileOutputter &operator=(const MappedFileOutputter &);
+
+	char *chunk(std::size_t index);
+	void closeFile();
+
+private:
+	std::string filename_;
+	bool append_;
+	std::size_t chunkSize_;
+	std::size_t openChunkSize_;
+	int fd_;
+	std::atomic<bool> open_;
+
+	// every writer touches these, keep them on their own cache lines
+	char pad0_[64];
+	std::atomic<std::uint64_t> offset_;
+	char pad1_[64];
+	std::atomic<unsigned int> writers_;
+	char pad2_[64];
+
+	std::atomic<char *> chunks_[MaxChunks];
+	std::atomic<unsigned long long> dropped_;
+	// where the first record that couldn't be written starts, the file is cut there
+	std::atomic<std::uint64_t> failedAt_;
+	mutable std::mutex mutex_;
+	std::mutex chunkMutex_;
+};
+
+} // sharklog
+
+#endif // mappedfileoutputter_H
@@ -0,0 +1,433 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "metricsreporter.h"
+#include "asyncoutputter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+const unsigned int MetricsReporter::DefaultInterval;
+const char *const MetricsReporter::LoggerName = "sharklog.metrics";
+
+namespace
+{
+	string lowerLevelName(std::size_t level)
+	{
+		string name = Level::levelName((Level::LogLevel)level);
+		transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+		return name;
+	}
+
+	const LoggerStats *findLogger(const StatsSnapshot &snapshot, const string &name)
+	{
+		for (auto &it : snapshot.loggers)
+		{
+			if (it.name == name)
+				return &it.stats;
+		}
+		return nullptr;
+	}
+
+	const OutputterStats *findOutputter(const StatsSnapshot &snapshot, const Outputter *op)
+	{
+		for (auto &it : snapshot.outputters)
+		{
+			if (it.outputter.get() == op)
+				return &it.stats;
+		}
+		return nullptr;
+	}
+
+	// counts since earlier, or all of them if they were reset in between
+	LoggerStats since(const LoggerStats &now, const LoggerStats *earlier)
+	{
+		auto stats = now;
+		if (earlier && earlier->accepted <= now.accepted && earlier->filtered <= now.filtered)
+			stats -= *earlier;
+		return stats;
+	}
+
+	OutputterStats since(const OutputterStats &now, const OutputterStats *earlier)
+	{
+		auto stats = now;
+		if (earlier && earlier->records <= now.records && earlier->timedRecords <= now.timedRecords
+			&& earlier->bytesWritten <= now.bytesWritten && earlier->dropped <= now.dropped)
+			stats -= *earlier;
+		return stats;
+	}
+
+	void writeRate(ostream &out, std::uint64_t count, double seconds)
+	{
+		out << fixed << setprecision(count && seconds > 0 && count / seconds < 10 ? 1 : 0)
+			<< (seconds > 0 ? count / seconds : 0.0);
+	}
+
+	void writeNanos(ostream &out, std::uint64_t nanos)
+	{
+		out << fixed << setprecision(1);
+		if (nanos < 1000)
+			out << setprecision(0) << (double)nanos << "ns";
+		else if (nanos < 1000000)
+			out << nanos / 1e3 << "us";
+		else if (nanos < 1000000000)
+			out << nanos / 1e6 << "ms";
+		else
+			out << nanos / 1e9 << "s";
+	}
+
+	string escapeLabel(const string &value)
+	{
+		string escaped;
+		for (auto c : value)
+		{
+			if (c == '\\' || c == '"')
+				escaped += '\\';
+			if (c == '\n')
+			{
+				escaped += "\\n";
+				continue;
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	void writeFamily(ostream &out, const char *name, const char *type, const char *help)
+	{
+		out << "# HELP " << name << " " << help << "\n";
+		out << "# TYPE " << name << " " << type << "\n";
+	}
+}
+
+MetricsReporter::MetricsReporter()
+	: logger_(Logger::logger(LoggerName))
+	, level_(Level::INFO)
+	, interval_(DefaultInterval)
+	, last_(Logger::allStats())
+	, lastTime_(steady_clock::now())
+	, running_(false)
+{
+}
+
+MetricsReporter::~MetricsReporter()
+{
+	stop();
+}
+
+bool MetricsReporter::start()
+{
+	lock_guard<mutex> lock(mutex_);
+	if (running_)
+		return false;
+
+	running_ = true;
+	thread_ = std::thread(&MetricsReporter::run, this);
+	return true;
+}
+
+void MetricsReporter::stop()
+{
+	std::thread reporter;
+	{
+		lock_guard<mutex> lock(mutex_);
+		running_ = false;
+		reporter = std::move(thread_);
+	}
+
+	wake_.notify_all();
+	if (reporter.joinable())
+		reporter.join();
+}
+
+bool MetricsReporter::isRunning() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return running_;
+}
+
+void MetricsReporter::run()
+{
+	unique_lock<mutex> lock(mutex_);
+	while (running_)
+	{
+		if (wake_.wait_for(lock, milliseconds(interval_), [this] { return !running_; }))
+			break;
+
+		lock.unlock();
+		report();
+		lock.lock();
+	}
+}
+
+bool MetricsReporter::report()
+{
+	// one report at a time, they each move last_ on
+	lock_guard<mutex> reporting(reportMutex_);
+
+	LoggerPtr logger;
+	Level level;
+	string path;
+	{
+		lock_guard<mutex> lock(mutex_);
+		logger = logger_;
+		level = level_;
+		path = prometheusFile_;
+	}
+
+	auto now = Logger::allStats();
+	auto time = steady_clock::now();
+	auto seconds = duration<double>(time - lastTime_).count();
+
+	if (logger)
+		logger->log(level, summary(now, last_, seconds));
+
+	auto written = true;
+	if (!path.empty() && !writeFileAtomically(path, prometheusText(now, last_)))
+	{
+		written = false;
+		if (logger)
+			logger->log(Level::error(), "could not write metrics to " + path);
+	}
+
+	last_ = std::move(now);
+	lastTime_ = time;
+	return written;
+}
+
+void MetricsReporter::setInterval(unsigned int ms)
+{
+	lock_guard<mutex> lock(mutex_);
+	interval_ = ms ? ms : 1;
+}
+
+unsigned int MetricsReporter::interval() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return interval_;
+}
+
+void MetricsReporter::setLogger(LoggerPtr logger)
+{
+	lock_guard<mutex> lock(mutex_);
+	logger_ = logger;
+}
+
+LoggerPtr MetricsReporter::logger() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return logger_;
+}
+
+void MetricsReporter::setLevel(const Level &level)
+{
+	lock_guard<mutex> lock(mutex_);
+	level_ = level;
+}
+
+Level MetricsReporter::level() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return level_;
+}
+
+void MetricsReporter::setPrometheusFile(const std::string &path)
+{
+	lock_guard<mutex> lock(mutex_);
+	prometheusFile_ = path;
+}
+
+std::string MetricsReporter::prometheusFile() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return prometheusFile_;
+}
+
+std::string MetricsReporter::summary(const StatsSnapshot &now, const StatsSnapshot &earlier, double seconds)
+{
+	LoggerStats loggers;
+	for (auto &it : now.loggers)
+		loggers += since(it.stats, findLogger(earlier, it.name));
+
+	ostringstream out;
+	out << "metrics for " << fixed << setprecision(1) << seconds << "s: records/s ";
+	writeRate(out, loggers.accepted, seconds);
+	out << " (";
+	for (std::size_t l=Level::FATAL;l<Level::ALL;++l)
+	{
+		out << (l == Level::FATAL ? "" : " ") << lowerLevelName(l) << " ";
+		writeRate(out, loggers.levels[l], seconds);
+	}
+	out << ") filtered/s ";
+	writeRate(out, loggers.filtered, seconds);
+
+	OutputterStats total;
+	vector<pair<const StatsSnapshot::OutputterEntry *, OutputterStats>> outputters;
+	for (auto &it : now.outputters)
+	{
+		auto stats = since(it.stats, findOutputter(earlier, it.outputter.get()));
+		total += stats;
+		outputters.push_back(make_pair(&it, std::move(stats)));
+	}
+
+	out << " bytes/s ";
+	writeRate(out, total.bytesWritten, seconds);
+	out << " errors " << total.writeErrors << " dropped " << total.dropped;
+
+	for (auto &it : outputters)
+	{
+		auto &stats = it.second;
+		auto async = dynamic_pointer_cast<AsyncOutputter>(it.first->outputter);
+		if (!stats.records && !async)
+			continue;
+
+		out << "; " << it.first->name << " records/s ";
+		writeRate(out, stats.records, seconds);
+		if (stats.bytesWritten)
+		{
+			out << " bytes/s ";
+			writeRate(out, stats.bytesWritten, seconds);
+		}
+		if (stats.timedRecords)
+		{
+			out << " p99 ";
+			writeNanos(out, stats.writeLatencyPercentile(99));
+		}
+		if (async)
+			out << " queue " << async->size() << "/" << async->capacity() << " dropped " << stats.dropped;
+		if (stats.writeErrors)
+			out << " errors " << stats.writeErrors;
+	}
+
+	return out.str();
+}
+
+std::string MetricsReporter::prometheusText(const StatsSnapshot &now, const StatsSnapshot &earlier)
+{
+	ostringstream out;
+	out << setprecision(9);
+
+	// loggers that never counted anything would only add noise
+	vector<const StatsSnapshot::LoggerEntry *> loggers;
+	for (auto &it : now.loggers)
+	{
+		if (it.stats.accepted || it.stats.filtered)
+			loggers.push_back(&it);
+	}
+
+	writeFamily(out, "sharklog_records_total", "counter", "Records loggers sent to their outputters.");
+	for (auto it : loggers)
+	{
+		for (std::size_t l=Level::FATAL;l<Level::ALL;++l)
+			out << "sharklog_records_total{logger=\"" << escapeLabel(it->name) << "\",level=\"" << lowerLevelName(l) << "\"} " << it->stats.levels[l] << "\n";
+	}
+
+	writeFamily(out, "sharklog_filtered_total", "counter", "Records loggers dropped for their level.");
+	for (auto it : loggers)
+		out << "sharklog_filtered_total{logger=\"" << escapeLabel(it->name) << "\"} " << it->stats.filtered << "\n";
+
+	auto counter = [&](const char *name, const char *help, std::uint64_t OutputterStats::*value) {
+		writeFamily(out, name, "counter", help);
+		for (auto &it : now.outputters)
+			out << name << "{outputter=\"" << escapeLabel(it.name) << "\"} " << it.stats.*value << "\n";
+	};
+	counter("sharklog_outputter_records_total", "Records given to an outputter.", &OutputterStats::records);
+	counter("sharklog_outputter_formatted_bytes_total", "Bytes of records an outputter formatted.", &OutputterStats::bytesFormatted);
+	counter("sharklog_outputter_written_bytes_total", "Bytes an outputter wrote.", &OutputterStats::bytesWritten);
+	counter("sharklog_outputter_write_errors_total", "Writes that failed.", &OutputterStats::writeErrors);
+	counter("sharklog_outputter_dropped_total", "Records dropped instead of written.", &OutputterStats::dropped);
+
+	writeFamily(out, "sharklog_outputter_write_seconds", "summary", "Time spent in writeLog(), sampled one record in 64 per thread.");
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	for (auto &it : now.outputters)
+	{
+		auto name = escapeLabel(it.name);
+		auto recent = since(it.stats, findOutputter(earlier, it.outputter.get()));
+		for (auto q : quantiles)
+		{
+			out << "sharklog_outputter_write_seconds{outputter=\"" << name << "\",quantile=\"" << q << "\"} ";
+			if (recent.timedRecords)
+				out << recent.writeLatencyPercentile(q * 100) / 1e9 << "\n";
+			else
+				out << "NaN\n";
+		}
+		out << "sharklog_outputter_write_seconds_sum{outputter=\"" << name << "\"} " << it.stats.timedNanos / 1e9 << "\n";
+		out << "sharklog_outputter_write_seconds_count{outputter=\"" << name << "\"} " << it.stats.timedRecords << "\n";
+	}
+
+	vector<const StatsSnapshot::OutputterEntry *> queues;
+	for (auto &it : now.outputters)
+	{
+		if (dynamic_pointer_cast<AsyncOutputter>(it.outputter))
+			queues.push_back(&it);
+	}
+	if (!queues.empty())
+	{
+		writeFamily(out, "sharklog_queue_depth", "gauge", "Records waiting in an AsyncOutputter queue.");
+		for (auto it : queues)
+			out << "sharklog_queue_depth{outputter=\"" << escapeLabel(it->name) << "\"} " << static_pointer_cast<AsyncOutputter>(it->outputter)->size() << "\n";
+
+		writeFamily(out, "sharklog_queue_capacity", "gauge", "Records an AsyncOutputter queue can hold.");
+		for (auto it : queues)
+			out << "sharklog_queue_capacity{outputter=\"" << escapeLabel(it->name) << "\"} " << static_pointer_cast<AsyncOutputter>(it->outputter)->capacity() << "\n";
+	}
+
+	return out.str();
+}
+
+bool MetricsReporter::writeFileAtomically(const std::string &path, const std::string &text)
+{
+	auto temp = path + ".tmp";
+	{
+		ofstream file(temp, ios::out | ios::trunc | ios::binary);
+		file.write(text.data(), text.size());
+		file.close();
+		if (file.fail())
+		{
+			std::remove(temp.c_str());
+			return false;
+		}
+	}
+
+#if defined(_WIN32) || defined(_WIN64)
+	// rename() won't replace a file that exists on windows
+	auto renamed = MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	auto renamed = std::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+	if (!renamed)
+		std::remove(temp.c_str());
+	return renamed;
+}
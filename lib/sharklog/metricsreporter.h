@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __metricsreporter_H
+#define __metricsreporter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/logger.h>
+#include <sharklog/level.h>
+#include <sharklog/stats.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Reports the health of the logging system as log records
+ *
+ * Every \ref interval() milliseconds a background thread reads
+ * \ref Logger::allStats() and logs one record summing up the interval to
+ * the "sharklog.metrics" logger, so it lands in the same files as
+ * everything else:
+ *
+ * - records per second for each level and filtered records per second
+ * - bytes per second written and write errors
+ * - per outputter: records and bytes per second, the 99th percentile
+ *   writeLog() time and, for an \ref AsyncOutputter, the queue depth and the
+ *   messages dropped
+ *
+ * The same counters can be written to a file in the Prometheus text format
+ * for the node_exporter textfile collector, see \ref setPrometheusFile().
+ * The file is written to a temporary file next to it and renamed over it so
+ * the collector never reads half of one.
+ *
+ * \code
+ * MetricsReporter reporter;
+ * reporter.setInterval(30000);
+ * reporter.setPrometheusFile("/var/lib/node_exporter/myapp.prom");
+ * reporter.start();
+ * \endcode
+ *
+ * The records go through the usual level check, set the level of the
+ * "sharklog.metrics" logger or use \ref setLevel() if the root logger
+ * doesn't take \ref Level::info().  Stop the reporter before
+ * \ref Logger::closeRootLogger().
+ */
+class SHARKLOGAPI MetricsReporter
+{
+public:
+	//! Default milliseconds between reports
+	static const unsigned int DefaultInterval = 10000;
+
+	//! Name of the logger reports are logged to by default
+	static const char *const LoggerName;
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * The first report covers the time from here, the thread is not
+	 * started until \ref start().
+	 */
+	MetricsReporter();
+
+	//! Destructor, stops the thread
+	~MetricsReporter();
+
+	/*!
+	 * \brief Starts reporting
+	 *
+	 * Starts the thread that calls \ref report() every \ref interval()
+	 * milliseconds.
+	 *
+	 * \return false if it was already running
+	 */
+	bool start();
+
+	//! Stops the thread, waiting for a report in progress to finish
+	void stop();
+
+	//! True if the thread is running
+	bool isRunning() const;
+
+	/*!
+	 * \brief Reports now
+	 *
+	 * Logs the summary of everything counted since the last report and
+	 * writes the Prometheus file if one is set.  The thread calls this, it
+	 * can also be called directly.
+	 *
+	 * \return false if the Prometheus file couldn't be written
+	 */
+	bool report();
+
+	/*!
+	 * \brief Sets the milliseconds between reports
+	 *
+	 * Takes effect after the next report.  0 is taken as 1.
+	 *
+	 * \param ms milliseconds between reports
+	 */
+	void setInterval(unsigned int ms);
+
+	//! Gets the milliseconds between reports
+	unsigned int interval() const;
+
+	//! Sets the logger reports are logged to, "sharklog.metrics" by default
+	void setLogger(LoggerPtr logger);
+
+	//! Gets the logger reports are logged to
+	LoggerPtr logger() const;
+
+	//! Sets the level reports are logged at, \ref Level::info() by default
+	void setLevel(const Level &level);
+
+	//! Gets the level reports are logged at
+	Level level() const;
+
+	/*!
+	 * \brief Sets the Prometheus file
+	 *
+	 * Each report also writes the counters to \a path in the Prometheus
+	 * text format.  The file is written to \a path with ".tmp" added and
+	 * renamed to \a path, the node_exporter textfile collector only reads
+	 * files ending in .prom so it skips the temporary one.  An empty \a path,
+	 * the default, writes no file.
+	 *
+	 * \param path the file to write
+	 */
+	void setPrometheusFile(const std::string &path);
+
+	//! Gets the Prometheus file, empty if there is none
+	std::string prometheusFile() const;
+
+	/*!
+	 * \brief Formats a summary
+	 *
+	 * \param now the counters at the end of the interval
+	 * \param earlier the counters at the start of it
+	 * \param seconds the length of the interval
+	 * \return one line summing up the interval
+	 */
+	static std::string summary(const StatsSnapshot &now, const StatsSnapshot &earlier, double seconds);
+
+	/*!
+	 * \brief Formats counters in the Prometheus text format
+	 *
+	 * Counters are totals since they were last reset.  The writeLog()
+	 * latency quantiles cover the timed calls since \a earlier.
+	 *
+	 * \param now the counters to write
+	 * \param earlier the counters at the start of the interval
+	 * \return the text of a .prom file
+	 */
+	static std::string prometheusText(const StatsSnapshot &now, const StatsSnapshot &earlier);
+
+	/*!
+	 * \brief Writes a file atomically
+	 *
+	 * Writes \a text to \a path with ".tmp" added and renames it to \a path.
+	 *
+	 * \return false if either failed
+	 */
+	static bool writeFileAtomically(const std::string &path, const std::string &text);
+
+private:
+	MetricsReporter(const MetricsReporter &);
+	MetricsReporter &operator=(const MetricsReporter &);
+
+	void run();
+
+	LoggerPtr logger_;
+	Level level_;
+	std::string prometheusFile_;
+	unsigned int interval_;
+	StatsSnapshot last_;
+	std::chrono::steady_clock::time_point lastTime_;
+	bool running_;
+	std::thread thread_;
+	mutable std::mutex mutex_;
+	std::mutex reportMutex_;
+	std::condition_variable wake_;
+};
+
+} // sharklog
+
+#endif // metricsreporter_H
@@ -23,13 +23,65 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "outputter.h"
+#include "deferredmessage.h"
+#include <chrono>
 
 using namespace sharklog;
+using namespace std::chrono;
+
+namespace
+{
+	// see Outputter::formatBuffer()
+	thread_local std::string format_;
+
+	// deferred messages are formatted here, reused by each thread.  Not in
+	// format_ because writeLog() formats the record into that
+	thread_local std::string message_;
+}
 
 Outputter::~Outputter()
 {
 }
 
+std::string &Outputter::formatBuffer()
+{
+	return format_;
+}
+
+void Outputter::writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc)
+{
+	auto &message = message_;
+	message.clear();
+	msg.format(message);
+	writeLog(lev, loggerName, message, loc);
+}
+
+void Outputter::log(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	log(ShardedCounters::threadSlot(), lev, loggerName, logMessage, loc);
+}
+
+void Outputter::logDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc)
+{
+	logDeferred(ShardedCounters::threadSlot(), lev, loggerName, msg, loc);
+}
+
+void Outputter::logTimed(ShardedCounters::ThreadSlot &slot, const Level &lev, const std::string &loggerName,
+	const std::string *logMessage, const DeferredMessage *msg, const Location &loc)
+{
+	auto start = steady_clock::now();
+	if (logMessage)
+		writeLog(lev, loggerName, *logMessage, loc);
+	else
+		writeDeferred(lev, loggerName, *msg, loc);
+	auto nanos = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+	counters_.add(slot, Records);
+	counters_.add(slot, TimedRecords);
+	counters_.add(slot, TimedNanos, (std::uint64_t)nanos);
+	latency_.record(slot, (std::uint64_t)nanos);
+}
+
 bool Outputter::isOpen() const
 {
     return false;
@@ -49,3 +101,44 @@ bool Outputter::isValid() const
 {
 	return (layout() != nullptr);
 }
+
+OutputterStats Outputter::stats() const
+{
+	OutputterStats stats;
+	stats.records = counters_.total(Records);
+	stats.bytesFormatted = counters_.total(BytesFormatted);
+	stats.bytesWritten = counters_.total(BytesWritten);
+	stats.writeErrors = counters_.total(WriteErrors);
+	stats.timedRecords = counters_.total(TimedRecords);
+	stats.timedNanos = counters_.total(TimedNanos);
+	stats.dropped = counters_.total(Dropped);
+	if (stats.timedRecords)
+		stats.writeLatency = latency_.counts();
+	return stats;
+}
+
+void Outputter::resetStats()
+{
+	counters_.reset();
+	latency_.reset();
+}
+
+void Outputter::countFormatted(std::size_t bytes)
+{
+	counters_.add(BytesFormatted, bytes);
+}
+
+void Outputter::countWritten(std::size_t bytes)
+{
+	counters_.add(BytesWritten, bytes);
+}
+
+void Outputter::countWriteError()
+{
+	counters_.add(WriteErrors);
+}
+
+void Outputter::countDropped()
+{
+	counters_.add(Dropped);
+}
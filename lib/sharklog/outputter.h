@@ -29,12 +29,14 @@
 #include <string>
 #include <memory>
 #include <sharklog/layout.h>
+#include <sharklog/stats.h>
 
 namespace sharklog
 {
 
 class Level;
 class Location;
+class DeferredMessage;
 class Outputter;
 
 /*!
@@ -97,6 +99,59 @@ public:
 	 */
     virtual void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) = 0;
 
+	/*!
+	 * \brief Writes a message that isn't formatted yet
+	 *
+	 * Called by \ref Logger::logDeferred().  The default formats \a msg on
+	 * the calling thread and passes it to \ref writeLog().  Outputters that
+	 * write later, like \ref AsyncOutputter, keep a copy of \a msg and
+	 * format it when they write it.
+	 *
+	 * \param lev the level of the message
+	 * \param loggerName the name of the logger this message is logged to
+	 * \param msg the captured message arguments
+	 * \param loc where the message was logged
+	 */
+	virtual void writeDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc);
+
+	/*!
+	 * \brief Writes a log message and counts it
+	 *
+	 * Calls \ref writeLog() and counts the record in \ref stats().  One
+	 * record in every 64 per thread is timed.  \ref Logger and outputters
+	 * that hand records to another outputter call this instead of
+	 * \ref writeLog().
+	 */
+	void log(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc);
+
+	//! Same as \ref log() with the calling thread's \a slot looked up already
+	void log(ShardedCounters::ThreadSlot &slot, const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+	{
+		// reading the clock twice costs more than a lot of writes do
+		if (++slot.ticks & 63)
+		{
+			writeLog(lev, loggerName, logMessage, loc);
+			counters_.add(slot, Records);
+		}
+		else
+			logTimed(slot, lev, loggerName, &logMessage, nullptr, loc);
+	}
+
+	//! Same as \ref log() for \ref writeDeferred()
+	void logDeferred(const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc);
+
+	//! Same as \ref logDeferred() with the calling thread's \a slot looked up already
+	void logDeferred(ShardedCounters::ThreadSlot &slot, const Level &lev, const std::string &loggerName, const DeferredMessage &msg, const Location &loc)
+	{
+		if (++slot.ticks & 63)
+		{
+			writeDeferred(lev, loggerName, msg, loc);
+			counters_.add(slot, Records);
+		}
+		else
+			logTimed(slot, lev, loggerName, nullptr, &msg, loc);
+	}
+
 	/*!
 	 * \brief Closes the outputter 
 	 *  
@@ -145,13 +200,69 @@ public:
 	 *  
 	 * Checks if the outputter is valid.  It is valid if it has 
 	 * a layout set. 
+	 *  
+	 * Outputters that hand their messages to another outputter, like 
+	 * \ref AsyncOutputter, can override this to report on that one. 
 	 * 
 	 * \return bool true if valid, false if not
 	 */
-	bool isValid() const;
+	virtual bool isValid() const;
+
+	/*!
+	 * \brief Gets the counters
+	 *
+	 * Records and write time are counted by \ref log(), bytes and errors by
+	 * the outputter itself.  The counters are per thread so they cost the
+	 * writers no shared cache lines, reading them adds them up.
+	 *
+	 * \sa Logger::allStats()
+	 */
+	OutputterStats stats() const;
+
+	//! Sets all the counters in \ref stats() to 0
+	void resetStats();
+
+protected:
+	//! Counts \a bytes of records formatted
+	void countFormatted(std::size_t bytes);
+
+	//! Counts \a bytes handed to the file, stream or mapping
+	void countWritten(std::size_t bytes);
+
+	//! Counts a write that failed
+	void countWriteError();
+
+	//! Counts a record that was dropped instead of written
+	void countDropped();
+
+	/*!
+	 * \brief A string to format records in, one per thread
+	 *
+	 * Formatting into it outside the lock costs no allocation once it has
+	 * grown.  All outputters on the thread share it, so clear it first and
+	 * don't hold on to it while calling \ref writeLog() on another outputter.
+	 */
+	static std::string &formatBuffer();
 
 private:
+	enum Counter
+	{
+		Records,
+		BytesFormatted,
+		BytesWritten,
+		WriteErrors,
+		TimedRecords,
+		TimedNanos,
+		Dropped,
+	};
+
+	// writes one of logMessage or msg and counts how long it took
+	void logTimed(ShardedCounters::ThreadSlot &slot, const Level &lev, const std::string &loggerName,
+		const std::string *logMessage, const DeferredMessage *msg, const Location &loc);
+
 	LayoutPtr layout_;
+	ShardedCounters counters_;
+	ShardedHistogram latency_;
 };
     
 } // sharklog
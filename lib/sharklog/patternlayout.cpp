@@ -0,0 +1,418 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "patternlayout.h"
+#include "level.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	// stands in for %f until the milliseconds are patched in
+	const char MillisMarker[] = "\x01\x01\x01";
+
+	// formatted date fields for the current second, per thread
+	struct DateCache
+	{
+		static const size_t Size = 4;
+		static const size_t MaxMillis = 4;
+
+		struct Entry
+		{
+			unsigned int id = 0;
+			long long second = -1;
+			size_t size = 0;
+			size_t millisAt[MaxMillis];
+			size_t millisCount = 0;
+			char text[128];
+		};
+
+		Entry entries[Size];
+		size_t next = 0;
+	};
+
+	thread_local DateCache dateCache_;
+	atomic<unsigned int> nextDateId_(1);
+
+	void appendNumber(std::string &result, unsigned long long value)
+	{
+		char buf[24];
+		char *p = buf + sizeof(buf);
+		do
+		{
+			*--p = (char)('0' + value % 10);
+			value /= 10;
+		} while (value);
+
+		result.append(p, buf + sizeof(buf) - p);
+	}
+
+	// appends the last \a parts dot separated parts of \a name
+	void appendLoggerName(std::string &result, const std::string &name, unsigned int parts)
+	{
+		size_t start = 0;
+		if (parts)
+		{
+			size_t pos = name.size();
+			while (parts-- && pos)
+			{
+				pos = name.rfind('.', pos - 1);
+				if (pos == string::npos)
+					break;
+			}
+
+			// pos is still name.size() when there was nothing to search, i.e. the root logger
+			if (pos != string::npos && pos < name.size())
+				start = pos + 1;
+		}
+
+		result.append(name, start, string::npos);
+	}
+}
+
+const char *PatternLayout::DefaultPattern = "%d %-5p [%t] %c - %m%n";
+
+PatternLayout::PatternLayout(const std::string &pattern)
+	: pattern_(pattern)
+	, start_(RecordContext::Clock::now())
+{
+	parse(pattern);
+}
+
+PatternLayout::~PatternLayout()
+{
+}
+
+std::string PatternLayout::pattern() const
+{
+	return pattern_;
+}
+
+void PatternLayout::addLiteral(const std::string &text)
+{
+	if (text.empty())
+		return;
+
+	if (!ops_.empty() && ops_.back().type == Literal)
+	{
+		ops_.back().text += text;
+		return;
+	}
+
+	Op op;
+	op.text = text;
+	ops_.push_back(op);
+}
+
+void PatternLayout::parse(const std::string &pattern)
+{
+	size_t i = 0;
+	while (i < pattern.size())
+	{
+		auto percent = pattern.find('%', i);
+		if (percent == string::npos)
+		{
+			addLiteral(pattern.substr(i));
+			break;
+		}
+
+		addLiteral(pattern.substr(i, percent - i));
+		i = percent + 1;
+
+		// format modifiers, i.e. %-5p or %.10c
+		Op op;
+		if (i < pattern.size() && pattern[i] == '-')
+		{
+			op.leftAlign = true;
+			++i;
+		}
+
+		while (i < pattern.size() && isdigit((unsigned char)pattern[i]))
+			op.minWidth = op.minWidth * 10 + (pattern[i++] - '0');
+
+		if (i < pattern.size() && pattern[i] == '.')
+		{
+			++i;
+			while (i < pattern.size() && isdigit((unsigned char)pattern[i]))
+				op.maxWidth = op.maxWidth * 10 + (pattern[i++] - '0');
+		}
+
+		if (i >= pattern.size())
+		{
+			// a trailing % is just text
+			addLiteral(pattern.substr(percent));
+			break;
+		}
+
+		auto conversion = pattern[i++];
+
+		// optional {option} after the field
+		string option;
+		bool hasOption = false;
+		if (i < pattern.size() && pattern[i] == '{')
+		{
+			auto close = pattern.find('}', i);
+			if (close != string::npos)
+			{
+				option = pattern.substr(i + 1, close - i - 1);
+				hasOption = true;
+				i = close + 1;
+			}
+		}
+
+		switch (conversion)
+		{
+		case 'd':
+			op.type = Date;
+			op.id = nextDateId_++;
+			if (!hasOption || option == "ISO8601")
+				op.text = "%Y-%m-%d %H:%M:%S,%f";
+			else if (option == "ABSOLUTE")
+				op.text = "%H:%M:%S,%f";
+			else if (option == "DATE")
+				op.text = "%d %b %Y %H:%M:%S,%f";
+			else
+				op.text = option;
+			break;
+		case 'p':
+			op.type = LevelName;
+			break;
+		case 'c':
+			op.type = LoggerName;
+			if (hasOption)
+				op.precision = (unsigned int)atoi(option.c_str());
+			break;
+		case 't':
+			op.type = ThreadId;
+			break;
+		case 'T':
+			op.type = SystemThreadId;
+			break;
+		case 'F':
+			op.type = File;
+			break;
+		case 'L':
+			op.type = Line;
+			break;
+		case 'M':
+			op.type = Function;
+			break;
+		case 'l':
+			op.type = FullLocation;
+			break;
+		case 'r':
+			op.type = Elapsed;
+			break;
+		case 'm':
+			op.type = Message;
+			break;
+		case 'n':
+			op.type = NewLine;
+			break;
+		case '%':
+			addLiteral("%");
+			continue;
+		default:
+			// not a field we know, keep it as text
+			addLiteral(pattern.substr(percent, i - percent));
+			continue;
+		}
+
+		// the date format is built once, with a marker where the milliseconds go
+		if (op.type == Date)
+		{
+			string format;
+			for (size_t c = 0; c < op.text.size(); ++c)
+			{
+				if (op.text[c] == '%' && c + 1 < op.text.size() && op.text[c + 1] == 'f')
+				{
+					format += MillisMarker;
+					++c;
+				}
+				else
+				{
+					format += op.text[c];
+					if (op.text[c] == '%' && c + 1 < op.text.size())
+						format += op.text[++c];
+				}
+			}
+			op.text = format;
+		}
+
+		ops_.push_back(op);
+	}
+}
+
+void PatternLayout::formatMessage(std::string &result, const Level &level, const std::string &loggerName,
+                                  const std::string &logMessage)
+{
+	formatRecord(result, level, loggerName, logMessage, Location());
+}
+
+void PatternLayout::formatRecord(std::string &result, const Level &level, const std::string &loggerName,
+                                 const std::string &logMessage, const Location &loc)
+{
+	auto ctx = RecordContext::current();
+
+	for (auto &op : ops_)
+	{
+		auto start = result.size();
+
+		switch (op.type)
+		{
+		case Literal:
+			result += op.text;
+			break;
+		case Date:
+			appendDate(result, op, ctx);
+			break;
+		case LevelName:
+			result += Level::levelName(level.level());
+			break;
+		case LoggerName:
+			appendLoggerName(result, loggerName, op.precision);
+			break;
+		case ThreadId:
+			appendThreadId(result, ctx);
+			break;
+		case SystemThreadId:
+			appendNumber(result, (unsigned long long)max(0L, ctx.systemThreadId()));
+			break;
+		case File:
+			result += loc.file();
+			break;
+		case Line:
+			if (loc.line())
+				appendNumber(result, (unsigned long long)loc.line());
+			break;
+		case Function:
+			result += loc.function();
+			break;
+		case FullLocation:
+			if (!loc.empty())
+			{
+				result += loc.function();
+				result += '(';
+				result += loc.file();
+				result += ':';
+				appendNumber(result, (unsigned long long)loc.line());
+				result += ')';
+			}
+			break;
+		case Elapsed:
+			appendNumber(result, (unsigned long long)max(0LL, (long long)duration_cast<milliseconds>(ctx.time() - start_).count()));
+			break;
+		case Message:
+			result += logMessage;
+			break;
+		case NewLine:
+			result += '\n';
+			break;
+		}
+
+		// log4j style padding and truncating, truncating keeps the end
+		if (op.minWidth || op.maxWidth)
+		{
+			auto size = result.size() - start;
+			if (op.maxWidth && size > op.maxWidth)
+			{
+				result.erase(start, size - op.maxWidth);
+				size = op.maxWidth;
+			}
+
+			if (size < op.minWidth)
+			{
+				if (op.leftAlign)
+					result.append(op.minWidth - size, ' ');
+				else
+					result.insert(start, op.minWidth - size, ' ');
+			}
+		}
+	}
+}
+
+void PatternLayout::appendDate(std::string &result, const Op &op, const RecordContext &ctx) const
+{
+	auto ms = duration_cast<milliseconds>(ctx.time().time_since_epoch()).count();
+	auto second = ms / 1000;
+
+	// find this field's text for this second, or build it
+	auto &cache = dateCache_;
+	DateCache::Entry *entry = nullptr;
+	for (auto &it : cache.entries)
+	{
+		if (it.id == op.id)
+		{
+			entry = &it;
+			break;
+		}
+	}
+
+	if (!entry)
+	{
+		entry = &cache.entries[cache.next++ % DateCache::Size];
+		entry->id = op.id;
+		entry->second = -1;
+	}
+
+	if (entry->second != second)
+	{
+		time_t current = (time_t)second;
+		tm t;
+		localtime_r(&current, &t);
+		entry->size = strftime(entry->text, sizeof(entry->text), op.text.c_str(), &t);
+		entry->second = second;
+
+		entry->millisCount = 0;
+		auto marker = sizeof(MillisMarker) - 1;
+		for (size_t i = 0; i + marker <= entry->size && entry->millisCount < DateCache::MaxMillis; ++i)
+		{
+			if (memcmp(entry->text + i, MillisMarker, marker) == 0)
+			{
+				entry->millisAt[entry->millisCount++] = i;
+				i += marker - 1;
+			}
+		}
+	}
+
+	auto millis = (int)(ms % 1000);
+	for (size_t i = 0; i < entry->millisCount; ++i)
+	{
+		auto digits = entry->text + entry->millisAt[i];
+		digits[0] = (char)('0' + millis / 100);
+		digits[1] = (char)('0' + millis / 10 % 10);
+		digits[2] = (char)('0' + millis % 10);
+	}
+
+	result.append(entry->text, entry->size);
+}
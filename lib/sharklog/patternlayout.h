@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __patternlayout_H
+#define __patternlayout_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/layout.h>
+#include <sharklog/recordcontext.h>
+#include <string>
+#include <vector>
+
+namespace sharklog
+{
+    
+/*!
+ * @brief Pattern log layout
+ * 
+ * A layout that formats records with a log4j style conversion pattern.  The 
+ * pattern is parsed once when the layout is created, formatting a record just 
+ * runs the parsed fields in order. 
+ *  
+ * \code 
+ * auto layout = std::make_shared<PatternLayout>("%d{ISO8601} %-5p %c{1} [%t] %F:%L %m%n");
+ * // 2017-01-20 23:23:11,788 INFO  child [0x7f7a19143740] main.cpp:20 testing
+ * \endcode 
+ *  
+ * | Field | Output | 
+ * | ----- | ------ | 
+ * | %%d | Date and time, ISO8601 by default.  %%d{ISO8601}, %%d{ABSOLUTE} (time only), %%d{DATE} or a strftime format like %%d{%%H:%%M:%%S.%%f} where %%f is milliseconds | 
+ * | %%p | Level, i.e. INFO | 
+ * | %%c | Logger name, %%c{2} only keeps the last 2 parts of the name | 
+ * | %%t | Thread name if it has one (see \ref setThreadName()), thread id otherwise | 
+ * | %%T | Operating system thread id, i.e. gettid() on Linux | 
+ * | %%F | Source file | 
+ * | %%L | Source line | 
+ * | %%M | Source function | 
+ * | %%l | Source location as function(file:line) | 
+ * | %%r | Milliseconds since the layout was created | 
+ * | %%m | The log message | 
+ * | %%n | New line | 
+ * | %%%% | A single % | 
+ *  
+ * Fields can be padded and truncated like log4j, %-5p pads the level to 5 
+ * characters on the right, %10c pads the name on the left and %.10c keeps the 
+ * last 10 characters of it.  Anything that is not a field is copied as is. 
+ *  
+ * The source fields are empty when the message was logged without a 
+ * \ref Location. 
+ */
+class SHARKLOGAPI PatternLayout : public Layout
+{
+public:
+	//! Pattern used by the default constructor, "%d %-5p [%t] %c - %m%n"
+	static const char *DefaultPattern;
+
+	/*!
+	 * \brief Constructor 
+	 *  
+	 * Parses \a pattern, see \ref PatternLayout for the fields. 
+	 * 
+	 * \param pattern the conversion pattern
+	 */
+	PatternLayout(const std::string &pattern=DefaultPattern);
+
+	//! Destructor
+	virtual ~PatternLayout();
+
+	/*!
+	 * \brief Gets the pattern 
+	 * 
+	 * \return std::string the pattern this layout was created with
+	 */
+	std::string pattern() const;
+
+	/*!
+	 * \brief Layout formatMessage 
+	 *  
+	 * Formats the whole record, without any source location. 
+	 */
+	void formatMessage(std::string &result, const Level &level, const std::string &loggerName, const std::string &logMessage) override;
+
+	/*!
+	 * \brief Formats a whole record 
+	 *  
+	 * Called by the outputters, runs the parsed pattern. 
+	 */
+	void formatRecord(std::string &result, const Level &level, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+private:
+	enum OpType
+	{
+		Literal
+		, Date
+		, LevelName
+		, LoggerName
+		, ThreadId
+		, SystemThreadId
+		, File
+		, Line
+		, Function
+		, FullLocation
+		, Elapsed
+		, Message
+		, NewLine
+	};
+
+	struct Op
+	{
+		OpType type = Literal;
+		std::string text; // literal text or strftime format
+		unsigned int id = 0; // identifies a date field in the per thread cache
+		unsigned int precision = 0; // logger name parts to keep, 0 for all
+		unsigned int minWidth = 0;
+		unsigned int maxWidth = 0;
+		bool leftAlign = false;
+	};
+
+	void parse(const std::string &pattern);
+	void addLiteral(const std::string &text);
+	void appendDate(std::string &result, const Op &op, const RecordContext &ctx) const;
+
+	std::string pattern_;
+	std::vector<Op> ops_;
+	RecordContext::Clock::time_point start_;
+};
+    
+} // sharklog
+
+#endif // patternlayout_H
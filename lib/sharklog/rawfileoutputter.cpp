@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "rawfileoutputter.h"
+#include <cerrno>
+#include <fcntl.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <sys/uio.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+const std::size_t RawFileOutputter::DefaultFlushBytes;
+const unsigned int RawFileOutputter::DefaultFlushInterval;
+
+namespace
+{
+	int openFile(const std::string &filename, bool append)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		int flags = _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (append ? 0 : _O_TRUNC);
+		return _open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+		int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (append ? 0 : O_TRUNC);
+		return ::open(filename.c_str(), flags, 0644);
+#endif
+	}
+
+	void closeFd(int fd)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		_close(fd);
+#else
+		::close(fd);
+#endif
+	}
+
+	// writes both parts, retrying short writes, returns the number of calls made
+	// and adds the bytes that were written to written
+	unsigned int writeParts(int fd, const char *first, std::size_t firstSize, const char *second, std::size_t secondSize,
+		std::size_t &written)
+	{
+		unsigned int calls = 0;
+#if defined(_WIN32) || defined(_WIN64)
+		const char *parts[] = { first, second };
+		std::size_t sizes[] = { firstSize, secondSize };
+		for (int i=0;i<2;++i)
+		{
+			while (sizes[i])
+			{
+				++calls;
+				auto res = _write(fd, parts[i], (unsigned int)sizes[i]);
+				if (res < 0)
+					return calls;
+				written += res;
+				parts[i] += res;
+				sizes[i] -= res;
+			}
+		}
+#else
+		iovec iov[2];
+		iov[0].iov_base = const_cast<char *>(first);
+		iov[0].iov_len = firstSize;
+		iov[1].iov_base = const_cast<char *>(second);
+		iov[1].iov_len = secondSize;
+
+		iovec *next = iov;
+		int count = 2;
+		while (count)
+		{
+			// skip empty parts so a short write never loops on them
+			if (next->iov_len == 0)
+			{
+				++next;
+				--count;
+				continue;
+			}
+
+			++calls;
+			auto res = ::writev(fd, next, count);
+			if (res < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				return calls;
+			}
+
+			std::size_t done = res;
+			written += done;
+			while (count && done >= next->iov_len)
+			{
+				done -= next->iov_len;
+				++next;
+				--count;
+			}
+			if (count)
+			{
+				next->iov_base = static_cast<char *>(next->iov_base) + done;
+				next->iov_len -= done;
+			}
+		}
+#endif
+		return calls;
+	}
+}
+
+RawFileOutputter::RawFileOutputter(const std::string &filename)
+	: filename_(filename)
+	, append_(false)
+	, fd_(-1)
+	, open_(false)
+	, pending_(0)
+	, flushBytes_(DefaultFlushBytes)
+	, flushRecords_(0)
+	, flushInterval_(DefaultFlushInterval)
+	, flushLevel_(Level::error())
+	, writes_(0)
+{
+}
+
+RawFileOutputter::~RawFileOutputter()
+{
+	close();
+}
+
+void RawFileOutputter::setFilename(const std::string &filename)
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	filename_ = filename;
+}
+
+std::string RawFileOutputter::filename() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return filename_;
+}
+
+void RawFileOutputter::setAppend(bool append)
+{
+	lock_guard<mutex> lock(mutex_);
+	append_ = append;
+}
+
+bool RawFileOutputter::append() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return append_;
+}
+
+void RawFileOutputter::setFlushBytes(std::size_t bytes)
+{
+	lock_guard<mutex> lock(mutex_);
+	flushBytes_ = bytes;
+	if (buffer_.size() >= flushBytes_)
+		writeBuffer();
+	buffer_.reserve(flushBytes_);
+}
+
+std::size_t RawFileOutputter::flushBytes() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return flushBytes_;
+}
+
+void RawFileOutputter::setFlushRecords(unsigned int records)
+{
+	lock_guard<mutex> lock(mutex_);
+	flushRecords_ = records;
+}
+
+unsigned int RawFileOutputter::flushRecords() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return flushRecords_;
+}
+
+void RawFileOutputter::setFlushInterval(unsigned int ms)
+{
+	lock_guard<mutex> lock(mutex_);
+	flushInterval_ = ms;
+}
+
+unsigned int RawFileOutputter::flushInterval() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return flushInterval_;
+}
+
+void RawFileOutputter::setFlushLevel(const Level &level)
+{
+	lock_guard<mutex> lock(mutex_);
+	flushLevel_ = level;
+}
+
+Level RawFileOutputter::flushLevel() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return flushLevel_;
+}
+
+bool RawFileOutputter::open()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+
+	fd_ = openFile(filename_, append_);
+	if (fd_ < 0)
+		return false;
+
+	buffer_.reserve(flushBytes_);
+	lastWrite_ = steady_clock::now();
+	open_ = true;
+	return true;
+}
+
+void RawFileOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	if (!isOpen() || !isValid())
+		return;
+
+	auto &record = formatBuffer();
+	record.clear();
+	layout()->formatRecord(record, lev, loggerName, logMessage, loc);
+	countFormatted(record.size());
+
+	lock_guard<mutex> lock(mutex_);
+	if (fd_ < 0)
+		return;
+
+	// too big for the buffer, write both with one call
+	if (buffer_.size() + record.size() > flushBytes_)
+	{
+		writeBuffer(&record);
+		return;
+	}
+
+	buffer_ += record;
+	++pending_;
+
+	auto urgent = flushLevel_.level() != Level::NONE && lev.level() <= flushLevel_.level();
+	if (urgent || (flushRecords_ && pending_ >= flushRecords_))
+	{
+		writeBuffer();
+		return;
+	}
+
+	if (flushInterval_ && steady_clock::now() - lastWrite_ >= milliseconds(flushInterval_))
+		writeBuffer();
+}
+
+void RawFileOutputter::close()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+}
+
+bool RawFileOutputter::isOpen() const
+{
+	return open_;
+}
+
+void RawFileOutputter::flush()
+{
+	lock_guard<mutex> lock(mutex_);
+	writeBuffer();
+}
+
+unsigned long long RawFileOutputter::writeCount() const
+{
+	return writes_;
+}
+
+void RawFileOutputter::writeBuffer(const std::string *record)
+{
+	// called with mutex_ held
+	if (fd_ >= 0 && (!buffer_.empty() || record))
+	{
+		std::size_t size = buffer_.size() + (record ? record->size() : 0);
+		std::size_t written = 0;
+		writes_ += writeParts(fd_, buffer_.data(), buffer_.size(),
+			record ? record->data() : nullptr, record ? record->size() : 0, written);
+		countWritten(written);
+		if (written < size)
+			countWriteError();
+	}
+
+	buffer_.clear();
+	pending_ = 0;
+	lastWrite_ = steady_clock::now();
+}
+
+void RawFileOutputter::closeFile()
+{
+	// called with mutex_ held
+	open_ = false;
+	if (fd_ < 0)
+		return;
+
+	writeBuffer();
+	closeFd(fd_);
+	fd_ = -1;
+}
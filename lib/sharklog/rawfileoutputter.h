@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __rawfileoutputter_H
+#define __rawfileoutputter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/outputter.h>
+#include <sharklog/level.h>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace sharklog
+{
+
+/*!
+ * \brief File outputter that writes with a file descriptor and writev()
+ *
+ * RawFileOutputter writes the same files as \ref FileOutputter but skips
+ * std::ofstream.  Records are formatted outside the lock and copied into one
+ * large buffer, which is handed to the kernel in a single writev() call along
+ * with the record that didn't fit.  The file is opened with O_APPEND.
+ *
+ * The buffer is written when any of these happen:
+ *
+ * - it would grow past \ref flushBytes()
+ * - \ref flushRecords() records are waiting (0 turns this off)
+ * - a record is written and \ref flushInterval() milliseconds have passed
+ *   since the last write.  There is no timer, a quiet log stays buffered until
+ *   the next record, \ref flush() or \ref close()
+ * - a record at \ref flushLevel() or more severe is written, by default
+ *   Level::error() so errors are on disk before the program can crash
+ *
+ * \code
+ * auto fop = std::make_shared<RawFileOutputter>("/tmp/test.log");
+ * fop->setFlushRecords(100);
+ * fop->setLayout(std::make_shared<StandardLayout>());
+ * if (!fop->open())
+ *    return 1; // fail
+ * Logger::rootLogger()->addOutputter(fop);
+ * \endcode
+ */
+class SHARKLOGAPI RawFileOutputter : public Outputter
+{
+public:
+	//! Default buffer size in bytes
+	static const std::size_t DefaultFlushBytes = 64 * 1024;
+
+	//! Default milliseconds records can wait in the buffer
+	static const unsigned int DefaultFlushInterval = 1000;
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * \param filename the file path to the file you want to write
+	 * \sa setFilename()
+	 */
+	RawFileOutputter(const std::string &filename = std::string());
+
+	//! Destructor, writes anything buffered and closes the file
+	virtual ~RawFileOutputter();
+
+	/*!
+	 * \brief Sets the file name/path
+	 *
+	 * Closes the file if it is open, see \ref close().
+	 *
+	 * \param filename the filename and path for the log file
+	 */
+	void setFilename(const std::string &filename);
+
+	//! Gets the file name and path for the log file
+	std::string filename() const;
+
+	/*!
+	 * \brief Set append file mode
+	 *
+	 * True to append to an existing file, false (the default) to truncate it.
+	 * Only used when opening the file.
+	 */
+	void setAppend(bool append);
+
+	//! Get append mode
+	bool append() const;
+
+	/*!
+	 * \brief Sets the buffer size
+	 *
+	 * A record that would take the buffer past \a bytes is written with
+	 * everything buffered before it.  0 writes every record on its own.
+	 */
+	void setFlushBytes(std::size_t bytes);
+
+	//! Gets the buffer size in bytes
+	std::size_t flushBytes() const;
+
+	//! Writes the buffer once \a records records are waiting, 0 (the default) turns this off
+	void setFlushRecords(unsigned int records);
+
+	//! Gets the number of records that triggers a write, 0 if off
+	unsigned int flushRecords() const;
+
+	//! Writes the buffer when a record comes in \a ms milliseconds after the last write, 0 turns this off
+	void setFlushInterval(unsigned int ms);
+
+	//! Gets the flush interval in milliseconds
+	unsigned int flushInterval() const;
+
+	/*!
+	 * \brief Sets the level that is written straight away
+	 *
+	 * Records at \a level or more severe are written immediately, with
+	 * everything buffered before them.  Level() (NONE) turns this off.
+	 */
+	void setFlushLevel(const Level &level);
+
+	//! Gets the level that is written straight away
+	Level flushLevel() const;
+
+	/*!
+	 * \brief Open the log file
+	 *
+	 * \return true if opened, false if failed
+	 */
+	virtual bool open() override;
+
+	//! Formats and buffers a record, writing the buffer if a flush trigger is hit
+	virtual void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+	//! Writes anything buffered and closes the file
+	virtual void close() override;
+
+	//! Checks to see if the file is open
+	virtual bool isOpen() const override;
+
+	//! Writes anything buffered to the file
+	void flush();
+
+	//! Number of write system calls made, for benchmarks and tests
+	unsigned long long writeCount() const;
+
+private:
+	RawFileOutputter(const RawFileOutputter &);
+	RawFileOutputter &operator=(const RawFileOutputter &);
+
+	void writeBuffer(const std::string *record = nullptr);
+	void closeFile();
+
+private:
+	std::string filename_;
+	bool append_;
+	int fd_;
+	std::atomic<bool> open_;
+	std::string buffer_;
+	unsigned int pending_;
+	std::size_t flushBytes_;
+	unsigned int flushRecords_;
+	unsigned int flushInterval_;
+	Level flushLevel_;
+	std::chrono::steady_clock::time_point lastWrite_;
+	std::atomic<unsigned long long> writes_;
+	mutable std::mutex mutex_;
+};
+
+} // sharklog
+
+#endif // rawfileoutputter_H
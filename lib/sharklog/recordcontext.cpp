@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "recordcontext.h"
+#include "threadinfo.h"
+
+using namespace sharklog;
+
+namespace
+{
+	thread_local const RecordContext *pinned_ = nullptr;
+}
+
+RecordContext::RecordContext()
+	: time_(Clock::now())
+	, threadLabel_(nullptr)
+{
+	auto &info = ThreadInfo::current();
+	threadId_ = info.id();
+	systemThreadId_ = info.systemId();
+	threadName_ = info.name();
+}
+
+RecordContext::RecordContext(Clock::time_point time, std::thread::id threadId)
+	: time_(time)
+	, threadId_(threadId)
+	, threadLabel_(nullptr)
+	, systemThreadId_(0)
+{
+}
+
+RecordContext::RecordContext(Clock::time_point time, const char *threadLabel)
+	: time_(time)
+	, threadLabel_(threadLabel)
+	, systemThreadId_(0)
+{
+}
+
+RecordContext RecordContext::current()
+{
+	if (pinned_)
+		return *pinned_;
+
+	return RecordContext();
+}
+
+RecordContext::Scope::Scope(const RecordContext &ctx)
+	: previous_(pinned_)
+{
+	pinned_ = &ctx;
+}
+
+RecordContext::Scope::~Scope()
+{
+	pinned_ = previous_;
+}
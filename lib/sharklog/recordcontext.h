@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __recordcontext_H
+#define __recordcontext_H
+
+#include <sharklog/sharklogdefs.h>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <string>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Record context
+ *
+ * Holds the information about a log record that a \ref Layout can not get
+ * from the message itself, i.e. the time the record was logged and the
+ * thread that logged it.
+ *
+ * Normally a layout formats a record on the same thread, and at nearly the
+ * same time, as it was logged so it can just use \ref current().  Outputters
+ * that format records later or on another thread (like \ref AsyncOutputter)
+ * capture a RecordContext when the record is logged and pin it with a
+ * \ref RecordContext::Scope while the record is formatted.
+ *
+ * \code
+ * RecordContext ctx; // captured when logged
+ * ...
+ * {
+ *    RecordContext::Scope pin(ctx);
+ *    op->writeLog(lev, loggerName, msg, loc); // layouts see ctx
+ * }
+ * \endcode
+ */
+class SHARKLOGAPI RecordContext
+{
+public:
+	//! The clock used for record times
+	using Clock = std::chrono::system_clock;
+
+	//! Constructor, captures the current time and thread, see \ref ThreadInfo
+	RecordContext();
+
+	//! Constructor for a record logged at \a time by \a threadId
+	RecordContext(Clock::time_point time, std::thread::id threadId);
+
+	/*!
+	 * \brief Constructor for a record logged at \a time by another process
+	 *
+	 * Used to format records read back from a file, like
+	 * \ref BinaryLogReader does, where the thread only exists as text.
+	 * Layouts print \a threadLabel instead of a thread id, it must outlive the
+	 * context.
+	 */
+	RecordContext(Clock::time_point time, const char *threadLabel);
+
+	/*!
+	 * \brief Record time
+	 *
+	 * The time the record was logged.
+	 *
+	 * \return time point of the record
+	 */
+	Clock::time_point time() const { return time_; }
+
+	/*!
+	 * \brief Record thread
+	 *
+	 * The id of the thread that logged the record.
+	 *
+	 * \return thread id
+	 */
+	std::thread::id threadId() const { return threadId_; }
+
+	//! Text printed instead of \ref threadId(), null for records from this process
+	const char *threadLabel() const { return threadLabel_; }
+
+	//! The operating system's id for the thread, see \ref ThreadInfo::systemId(), 0 if not known
+	long systemThreadId() const { return systemThreadId_; }
+
+	//! The name the thread had when the record was logged, null if none, see \ref setThreadName()
+	const std::string *threadName() const { return threadName_.get(); }
+
+	//! Keeps \ref threadName() alive for as long as the caller needs it
+	const std::shared_ptr<const std::string> &sharedThreadName() const { return threadName_; }
+
+	/*!
+	 * \brief Context of the record being formatted
+	 *
+	 * Returns the context pinned on this thread with a \ref Scope, or a
+	 * freshly captured context if nothing is pinned.
+	 *
+	 * \return the current record context
+	 */
+	static RecordContext current();
+
+	/*!
+	 * \brief Pins a context to the current thread
+	 *
+	 * While a Scope is alive \ref current() returns the pinned context on
+	 * this thread.  Scopes nest, the previous context is restored when the
+	 * Scope is destroyed.
+	 */
+	class SHARKLOGAPI Scope
+	{
+	public:
+		//! Pins \a ctx for the current thread
+		Scope(const RecordContext &ctx);
+
+		//! Restores the previously pinned context
+		~Scope();
+
+	private:
+		Scope(const Scope &);
+		Scope &operator=(const Scope &);
+
+		const RecordContext *previous_;
+	};
+
+private:
+	Clock::time_point time_;
+	std::thread::id threadId_;
+	const char *threadLabel_;
+	long systemThreadId_;
+	std::shared_ptr<const std::string> threadName_;
+};
+
+} // sharklog
+
+#endif // recordcontext_H
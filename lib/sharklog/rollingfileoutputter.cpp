@@ -0,0 +1,458 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "rollingfileoutputter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+#include <ctime>
+
+#if defined(SHARKLOG_HAVE_ZLIB)
+	#include <zlib.h>
+#endif
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <dirent.h>
+	#define SHARKLOG_HAVE_DIRENT
+#endif
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+const std::uint64_t RollingFileOutputter::DefaultMaxFileSize;
+const unsigned int RollingFileOutputter::DefaultMaxArchives;
+
+namespace
+{
+	// true if name, from pos on, is a stamp made by archiveName(), i.e.
+	// YYYYMMDD-HHMMSS-NNN with an optional .gz
+	bool isArchiveStamp(const std::string &name, std::size_t pos)
+	{
+		static const char pattern[] = "00000000-000000-000";
+		const std::size_t length = sizeof(pattern) - 1;
+		if (name.size() < pos + length)
+			return false;
+		if (name.size() != pos + length && name.compare(pos + length, std::string::npos, ".gz") != 0)
+			return false;
+
+		for (std::size_t i=0;i<length;++i)
+		{
+			auto c = (unsigned char)name[pos + i];
+			if (pattern[i] == '-' ? c != '-' : !isdigit(c))
+				return false;
+		}
+		return true;
+	}
+
+#if defined(SHARKLOG_HAVE_ZLIB)
+	bool gzipFile(const std::string &source, const std::string &dest)
+	{
+		FILE *in = fopen(source.c_str(), "rb");
+		if (!in)
+			return false;
+
+		gzFile out = gzopen(dest.c_str(), "wb6");
+		if (!out)
+		{
+			fclose(in);
+			return false;
+		}
+
+		char buffer[64 * 1024];
+		bool ok = true;
+		std::size_t count;
+		while (ok && (count = fread(buffer, 1, sizeof(buffer), in)) > 0)
+			ok = gzwrite(out, buffer, (unsigned int)count) == (int)count;
+
+		ok = !ferror(in) && gzclose(out) == Z_OK && ok;
+		fclose(in);
+
+		if (!ok)
+			remove(dest.c_str());
+		return ok;
+	}
+#endif
+}
+
+RollingFileOutputter::RollingFileOutputter(const std::string &filename)
+	: filename_(filename)
+	, append_(false)
+	, open_(false)
+	, written_(0)
+	, maxFileSize_(DefaultMaxFileSize)
+	, interval_(Never)
+	, nextRoll_(system_clock::time_point::max())
+	, stampCount_(0)
+	, maxArchives_(DefaultMaxArchives)
+	, compress_(compressionAvailable())
+	, running_(false)
+{
+}
+
+RollingFileOutputter::~RollingFileOutputter()
+{
+	close();
+}
+
+void RollingFileOutputter::setFilename(const std::string &filename)
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	stopArchiver();
+	filename_ = filename;
+}
+
+std::string RollingFileOutputter::filename() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return filename_;
+}
+
+void RollingFileOutputter::setAppend(bool append)
+{
+	lock_guard<mutex> lock(mutex_);
+	append_ = append;
+}
+
+bool RollingFileOutputter::append() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return append_;
+}
+
+void RollingFileOutputter::setMaxFileSize(std::uint64_t bytes)
+{
+	lock_guard<mutex> lock(mutex_);
+	maxFileSize_ = bytes;
+}
+
+std::uint64_t RollingFileOutputter::maxFileSize() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return maxFileSize_;
+}
+
+void RollingFileOutputter::setRollInterval(RollInterval interval)
+{
+	lock_guard<mutex> lock(mutex_);
+	interval_ = interval;
+	nextRoll_ = nextRollTime(system_clock::now(), interval_);
+}
+
+RollingFileOutputter::RollInterval RollingFileOutputter::rollInterval() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return interval_;
+}
+
+void RollingFileOutputter::setMaxArchives(unsigned int count)
+{
+	lock_guard<mutex> lock(archiveMutex_);
+	maxArchives_ = count;
+	prune();
+}
+
+unsigned int RollingFileOutputter::maxArchives() const
+{
+	lock_guard<mutex> lock(archiveMutex_);
+	return maxArchives_;
+}
+
+void RollingFileOutputter::setCompress(bool compress)
+{
+	lock_guard<mutex> lock(archiveMutex_);
+	compress_ = compress && compressionAvailable();
+}
+
+bool RollingFileOutputter::compress() const
+{
+	lock_guard<mutex> lock(archiveMutex_);
+	return compress_;
+}
+
+bool RollingFileOutputter::compressionAvailable()
+{
+#if defined(SHARKLOG_HAVE_ZLIB)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool RollingFileOutputter::open()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	stopArchiver();
+
+	written_ = 0;
+	if (append_)
+	{
+		ifstream existing(filename_, ios::binary | ios::ate);
+		if (existing.is_open())
+			written_ = existing.tellg();
+		file_.open(filename_, std::ofstream::out | std::ofstream::app);
+	}
+	else
+		file_.open(filename_, std::ofstream::out | std::ofstream::trunc);
+
+	if (!file_.is_open())
+		return false;
+
+	nextRoll_ = nextRollTime(system_clock::now(), interval_);
+
+	{
+		lock_guard<mutex> archiveLock(archiveMutex_);
+		findArchives();
+		prune();
+		running_ = true;
+	}
+	archiver_ = thread(&RollingFileOutputter::run, this);
+
+	open_ = true;
+	return true;
+}
+
+void RollingFileOutputter::writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc)
+{
+	if (!isOpen() || !isValid())
+		return;
+
+	auto &record = formatBuffer();
+	record.clear();
+	layout()->formatRecord(record, lev, loggerName, logMessage, loc);
+	countFormatted(record.size());
+
+	lock_guard<mutex> lock(mutex_);
+	if (!file_.is_open())
+		return;
+
+	if ((maxFileSize_ && written_ && written_ + record.size() > maxFileSize_)
+		|| (interval_ != Never && system_clock::now() >= nextRoll_))
+	{
+		roll();
+		if (!file_.is_open())
+		{
+			countWriteError();
+			return;
+		}
+	}
+
+	if (!file_.write(record.data(), record.size()))
+	{
+		countWriteError();
+		return;
+	}
+	written_ += record.size();
+	countWritten(record.size());
+}
+
+void RollingFileOutputter::close()
+{
+	lock_guard<mutex> lock(mutex_);
+	closeFile();
+	stopArchiver();
+}
+
+bool RollingFileOutputter::isOpen() const
+{
+	return open_;
+}
+
+void RollingFileOutputter::rollOver()
+{
+	lock_guard<mutex> lock(mutex_);
+	if (file_.is_open())
+		roll();
+}
+
+std::vector<std::string> RollingFileOutputter::archives() const
+{
+	lock_guard<mutex> lock(archiveMutex_);
+	return std::vector<std::string>(archives_.begin(), archives_.end());
+}
+
+std::chrono::system_clock::time_point RollingFileOutputter::nextRollTime(std::chrono::system_clock::time_point now, RollInterval interval)
+{
+	if (interval == Never)
+		return system_clock::time_point::max();
+
+	auto current = system_clock::to_time_t(now);
+	tm t;
+	localtime_r(&current, &t);
+
+	t.tm_sec = 0;
+	t.tm_min = 0;
+	if (interval == Hourly)
+		t.tm_hour += 1;
+	else
+	{
+		t.tm_hour = 0;
+		t.tm_mday += 1;
+	}
+
+	// let mktime work out daylight savings for the new time
+	t.tm_isdst = -1;
+	return system_clock::from_time_t(mktime(&t));
+}
+
+void RollingFileOutputter::roll()
+{
+	// called with mutex_ held
+	file_.close();
+
+	auto archive = archiveName();
+	auto renamed = std::rename(filename_.c_str(), archive.c_str()) == 0;
+	file_.open(filename_, std::ofstream::out | (renamed ? std::ofstream::trunc : std::ofstream::app));
+
+	written_ = 0;
+	nextRoll_ = nextRollTime(system_clock::now(), interval_);
+	open_ = file_.is_open();
+
+	if (renamed)
+	{
+		lock_guard<mutex> lock(archiveMutex_);
+		pending_.push_back(archive);
+		wake_.notify_one();
+	}
+}
+
+std::string RollingFileOutputter::archiveName()
+{
+	auto current = system_clock::to_time_t(system_clock::now());
+	tm t;
+	localtime_r(&current, &t);
+
+	char stamp[32];
+	strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &t);
+
+	// more than one roll over in a second gets the next number
+	if (lastStamp_ == stamp)
+		++stampCount_;
+	else
+	{
+		lastStamp_ = stamp;
+		stampCount_ = 0;
+	}
+
+	char count[16];
+	snprintf(count, sizeof(count), "-%03u", stampCount_);
+	return filename_ + "." + stamp + count;
+}
+
+void RollingFileOutputter::closeFile()
+{
+	// called with mutex_ held
+	open_ = false;
+	if (file_.is_open())
+		file_.close();
+}
+
+void RollingFileOutputter::stopArchiver()
+{
+	{
+		lock_guard<mutex> lock(archiveMutex_);
+		running_ = false;
+	}
+	wake_.notify_one();
+
+	if (archiver_.joinable())
+		archiver_.join();
+}
+
+void RollingFileOutputter::findArchives()
+{
+	// called with archiveMutex_ held
+	archives_.clear();
+
+#if defined(SHARKLOG_HAVE_DIRENT)
+	auto slash = filename_.find_last_of('/');
+	auto dir = slash == string::npos ? string(".") : filename_.substr(0, slash + 1);
+	auto prefix = (slash == string::npos ? filename_ : filename_.substr(slash + 1)) + ".";
+
+	DIR *d = opendir(dir.c_str());
+	if (!d)
+		return;
+
+	vector<string> found;
+	while (auto entry = readdir(d))
+	{
+		string name = entry->d_name;
+		if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0
+			&& isArchiveStamp(name, prefix.size()))
+		{
+			found.push_back(slash == string::npos ? name : dir + name);
+		}
+	}
+	closedir(d);
+
+	// the time stamps sort oldest first
+	sort(found.begin(), found.end());
+	archives_.assign(found.begin(), found.end());
+#endif
+}
+
+void RollingFileOutputter::prune()
+{
+	// called with archiveMutex_ held
+	while (maxArchives_ && archives_.size() > maxArchives_)
+	{
+		remove(archives_.front().c_str());
+		archives_.pop_front();
+	}
+}
+
+void RollingFileOutputter::run()
+{
+	unique_lock<mutex> lock(archiveMutex_);
+	while (true)
+	{
+		while (pending_.empty() && running_)
+			wake_.wait_for(lock, milliseconds(100));
+
+		if (pending_.empty())
+			break;
+
+		auto name = pending_.front();
+		pending_.pop_front();
+		auto compress = compress_;
+
+		// compress without the lock so archives() and the setters don't wait
+		lock.unlock();
+#if defined(SHARKLOG_HAVE_ZLIB)
+		if (compress && gzipFile(name, name + ".gz"))
+		{
+			remove(name.c_str());
+			name += ".gz";
+		}
+#else
+		(void)compress;
+#endif
+		lock.lock();
+
+		archives_.push_back(name);
+		prune();
+	}
+}
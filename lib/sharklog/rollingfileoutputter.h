@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __rollingfileoutputter_H
+#define __rollingfileoutputter_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/outputter.h>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sharklog
+{
+
+/*!
+ * \brief File outputter that rolls the file over by size and time
+ *
+ * RollingFileOutputter writes to \ref filename() like \ref FileOutputter and
+ * starts a new file once the current one would grow past \ref maxFileSize() or
+ * a \ref rollInterval() boundary (the top of the hour or local midnight) goes
+ * by.  Rolling over renames the file to an archive named after the time,
+ * i.e. app.log.20170412-153000-000, and opens a new app.log, one rename and
+ * one open while holding the lock so no record goes to the wrong file.
+ *
+ * Archives are handed to a background thread which gzips them (when sharklog
+ * is built with zlib, see \ref compressionAvailable()) and removes the oldest
+ * ones past \ref maxArchives().  Archives left by earlier runs are found when
+ * the file is opened and count towards the limit (not on Windows), other
+ * files next to it are left alone even if their names start the same.
+ *
+ * \code
+ * auto fop = std::make_shared<RollingFileOutputter>("/var/log/app.log");
+ * fop->setMaxFileSize(50 * 1024 * 1024);
+ * fop->setRollInterval(RollingFileOutputter::Daily);
+ * fop->setMaxArchives(7);
+ * fop->setLayout(std::make_shared<StandardLayout>());
+ * if (!fop->open())
+ *    return 1; // fail
+ * Logger::rootLogger()->addOutputter(fop);
+ * \endcode
+ */
+class SHARKLOGAPI RollingFileOutputter : public Outputter
+{
+public:
+	//! Default size a file can grow to before it is rolled over
+	static const std::uint64_t DefaultMaxFileSize = 10 * 1024 * 1024;
+
+	//! Default number of archives kept
+	static const unsigned int DefaultMaxArchives = 5;
+
+	//! When to roll over the file besides \ref maxFileSize()
+	enum RollInterval
+	{
+		Never //!< only roll over by size
+		, Hourly //!< at the top of every hour
+		, Daily //!< at local midnight
+	};
+
+	/*!
+	 * \brief Constructor
+	 *
+	 * \param filename the file path to the file you want to write
+	 * \sa setFilename()
+	 */
+	RollingFileOutputter(const std::string &filename = std::string());
+
+	//! Destructor, closes the file
+	virtual ~RollingFileOutputter();
+
+	/*!
+	 * \brief Sets the file name/path
+	 *
+	 * Archives are written next to it.  Closes the file if it is open, see
+	 * \ref close().
+	 */
+	void setFilename(const std::string &filename);
+
+	//! Gets the file name and path for the log file
+	std::string filename() const;
+
+	/*!
+	 * \brief Set append file mode
+	 *
+	 * True to keep writing an existing file, false (the default) to truncate
+	 * it.  Only used when opening the file.
+	 */
+	void setAppend(bool append);
+
+	//! Get append mode
+	bool append() const;
+
+	//! Rolls the file over before it grows past \a bytes bytes, 0 to only roll by time
+	void setMaxFileSize(std::uint64_t bytes);
+
+	//! Gets the size a file can grow to
+	std::uint64_t maxFileSize() const;
+
+	//! Sets when the file is rolled over besides \ref maxFileSize()
+	void setRollInterval(RollInterval interval);
+
+	//! Gets the roll interval
+	RollInterval rollInterval() const;
+
+	//! Sets the number of archives to keep, 0 keeps all of them
+	void setMaxArchives(unsigned int count);
+
+	//! Gets the number of archives kept
+	unsigned int maxArchives() const;
+
+	/*!
+	 * \brief Turns gzip compression of archives on or off
+	 *
+	 * On by default when \ref compressionAvailable() is true, ignored when it
+	 * is false.
+	 */
+	void setCompress(bool compress);
+
+	//! True if archives are compressed
+	bool compress() const;
+
+	//! True if sharklog was built with zlib and can compress archives
+	static bool compressionAvailable();
+
+	/*!
+	 * \brief Open the log file
+	 *
+	 * Starts the archive thread and looks for archives from earlier runs.
+	 *
+	 * \return true if opened, false if failed
+	 */
+	virtual bool open() override;
+
+	//! Writes a record, rolling the file over first if it's time
+	virtual void writeLog(const Level &lev, const std::string &loggerName, const std::string &logMessage, const Location &loc) override;
+
+	//! Closes the file and waits for archives still being compressed
+	virtual void close() override;
+
+	//! Checks to see if the file is open
+	virtual bool isOpen() const override;
+
+	//! Rolls the file over now
+	void rollOver();
+
+	//! Archives kept so far, oldest first.  Ones still being compressed are not listed
+	std::vector<std::string> archives() const;
+
+	//! The first roll over time after \a now for \a interval, time_point::max() for \ref Never
+	static std::chrono::system_clock::time_point nextRollTime(std::chrono::system_clock::time_point now, RollInterval interval);
+
+private:
+	RollingFileOutputter(const RollingFileOutputter &);
+	RollingFileOutputter &operator=(const RollingFileOutputter &);
+
+	void roll();
+	std::string archiveName();
+	void closeFile();
+	void stopArchiver();
+	void findArchives();
+	void prune();
+	void run();
+
+private:
+	std::ofstream file_;
+	std::string filename_;
+	bool append_;
+	std::atomic<bool> open_;
+	std::uint64_t written_;
+	std::uint64_t maxFileSize_;
+	RollInterval interval_;
+	std::chrono::system_clock::time_point nextRoll_;
+	std::string lastStamp_;
+	unsigned int stampCount_;
+	mutable std::mutex mutex_;
+
+	// archive thread, guarded by archiveMutex_
+	unsigned int maxArchives_;
+	bool compress_;
+	bool running_;
+	std::deque<std::string> pending_;
+	std::deque<std::string> archives_;
+	std::thread archiver_;
+	mutable std::mutex archiveMutex_;
+	std::condition_variable wake_;
+};
+
+} // sharklog
+
+#endif // rollingfileoutputter_H
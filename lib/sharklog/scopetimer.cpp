@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "scopetimer.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	mutex &scopesMutex()
+	{
+		static mutex m;
+		return m;
+	}
+
+	// scopes are only added, so the pointers handed out stay valid
+	map<string, unique_ptr<ScopeStats>> &scopes()
+	{
+		static map<string, unique_ptr<ScopeStats>> s;
+		return s;
+	}
+
+	string durationText(std::uint64_t nanos)
+	{
+		ostringstream out;
+		out << fixed << setprecision(1);
+		if (nanos < 1000)
+			out << nanos << "ns";
+		else if (nanos < 1000000)
+			out << nanos / 1e3 << "us";
+		else if (nanos < 1000000000)
+			out << nanos / 1e6 << "ms";
+		else
+			out << nanos / 1e9 << "s";
+		return out.str();
+	}
+}
+
+ScopeStats::ScopeStats(const std::string &name)
+	: name_(name)
+	, max_(0)
+	, threshold_(0)
+{
+}
+
+ScopeStats *ScopeStats::scope(const std::string &name)
+{
+	lock_guard<mutex> lock(scopesMutex());
+	auto &it = scopes()[name];
+	if (!it)
+		it.reset(new ScopeStats(name));
+	return it.get();
+}
+
+std::vector<ScopeStats *> ScopeStats::all()
+{
+	lock_guard<mutex> lock(scopesMutex());
+	vector<ScopeStats *> all;
+	for (auto &it : scopes())
+		all.push_back(it.second.get());
+	return all;
+}
+
+std::vector<ScopeStats::Summary> ScopeStats::top(std::size_t count, Order order)
+{
+	vector<Summary> top;
+	for (auto scope : all())
+	{
+		auto summary = scope->summary();
+		if (summary.count)
+			top.push_back(std::move(summary));
+	}
+
+	auto key = [order](const Summary &s) {
+		return order == ByMax ? s.maxNanos : (order == ByPercentile99 ? s.p99Nanos : s.totalNanos);
+	};
+	stable_sort(top.begin(), top.end(), [&](const Summary &a, const Summary &b) { return key(a) > key(b); });
+
+	if (count && top.size() > count)
+		top.resize(count);
+	return top;
+}
+
+void ScopeStats::writeTop(std::ostream &out, std::size_t count, Order order)
+{
+	auto flags = out.flags();
+	for (auto &it : top(count, order))
+	{
+		out << left << setw(40) << it.name << right << " count " << setw(12) << it.count
+			<< " total " << setw(10) << durationText(it.totalNanos)
+			<< " mean " << setw(10) << durationText(it.totalNanos / it.count)
+			<< " p50 " << setw(10) << durationText(it.p50Nanos)
+			<< " p99 " << setw(10) << durationText(it.p99Nanos)
+			<< " max " << setw(10) << durationText(it.maxNanos) << "\n";
+	}
+	out.flags(flags);
+	out.flush();
+}
+
+void ScopeStats::resetAll()
+{
+	for (auto scope : all())
+		scope->reset();
+}
+
+ScopeStats::Summary ScopeStats::summary() const
+{
+	Summary summary;
+	summary.name = name_;
+	summary.count = counters_.total(Count);
+	summary.totalNanos = counters_.total(TotalNanos);
+	summary.maxNanos = max_.load(memory_order_relaxed);
+
+	if (summary.count)
+	{
+		auto counts = histogram_.counts();
+		// the top of a bucket can be past the longest time seen
+		summary.p50Nanos = std::min(ShardedHistogram::percentile(counts, 50), summary.maxNanos);
+		summary.p99Nanos = std::min(ShardedHistogram::percentile(counts, 99), summary.maxNanos);
+	}
+	return summary;
+}
+
+void ScopeStats::reset()
+{
+	counters_.reset();
+	histogram_.reset();
+	max_.store(0, memory_order_relaxed);
+}
+
+void ScopeStats::setLogThreshold(std::uint64_t nanos)
+{
+	threshold_.store(nanos, memory_order_relaxed);
+}
+
+void ScopeTimer::finish()
+{
+	auto nanos = (std::uint64_t)duration_cast<nanoseconds>(steady_clock::now() - start_).count();
+	scope_->record(ShardedCounters::threadSlot(), nanos);
+
+	auto threshold = scope_->logThreshold();
+	if (threshold && nanos > threshold)
+		logger_->log(Level::debug(), scope_->name() + " took " + durationText(nanos) + ", over " + durationText(threshold), *loc_);
+}
@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __scopetimer_H
+#define __scopetimer_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/logger.h>
+#include <sharklog/level.h>
+#include <sharklog/location.h>
+#include <sharklog/stats.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*!
+ * \file scopetimer.h
+ */
+
+namespace sharklog
+{
+
+/*!
+ * \brief Timings of every scope with one name
+ *
+ * Each \ref SHARKLOG_SCOPE_TIMER adds the nanoseconds its scope took to the
+ * ScopeStats of its name: a count, the total, the longest and a
+ * \ref ShardedHistogram for percentiles.  Timings are counted per thread like
+ * \ref ShardedCounters so timed scopes on different threads don't share cache
+ * lines.
+ *
+ * Scopes are registered the first time they are timed and never removed,
+ * the pointers stay valid until the program exits.  \ref top() reports the
+ * slowest ones.
+ *
+ * \code
+ * ScopeStats::writeTop(std::cout, 10);
+ * \endcode
+ */
+class SHARKLOGAPI ScopeStats
+{
+public:
+	//! What \ref top() sorts by
+	enum Order
+	{
+		ByTotal //!< total time spent in the scope
+		, ByPercentile99 //!< 99th percentile of one pass through the scope
+		, ByMax //!< longest pass through the scope
+	};
+
+	//! One scope in \ref top()
+	struct Summary
+	{
+		std::string name;
+		std::uint64_t count = 0;
+		std::uint64_t totalNanos = 0;
+		std::uint64_t maxNanos = 0;
+		std::uint64_t p50Nanos = 0;
+		std::uint64_t p99Nanos = 0;
+	};
+
+	/*!
+	 * \brief Gets the scope named \a name
+	 *
+	 * Adds it the first time a name is used.
+	 *
+	 * \param name the scope name
+	 * \return the scope, valid until the program exits
+	 */
+	static ScopeStats *scope(const std::string &name);
+
+	//! Every scope registered so far
+	static std::vector<ScopeStats *> all();
+
+	/*!
+	 * \brief The slowest scopes
+	 *
+	 * \param count the most scopes to return, 0 for all of them
+	 * \param order what slowest means
+	 * \return the scopes that were timed at least once, slowest first
+	 */
+	static std::vector<Summary> top(std::size_t count, Order order = ByTotal);
+
+	/*!
+	 * \brief Writes the slowest scopes
+	 *
+	 * Writes one line per scope from \ref top() with its count, total, mean,
+	 * p50, p99 and longest time.
+	 */
+	static void writeTop(std::ostream &out, std::size_t count, Order order = ByTotal);
+
+	//! Sets the timings of every scope to 0
+	static void resetAll();
+
+	//! The scope name
+	const std::string &name() const { return name_; }
+
+	//! Adds one pass through the scope that took \a nanos
+	void record(const ShardedCounters::ThreadSlot &slot, std::uint64_t nanos)
+	{
+		counters_.add(slot, Count);
+		counters_.add(slot, TotalNanos, nanos);
+		histogram_.record(slot, nanos);
+
+		auto max = max_.load(std::memory_order_relaxed);
+		while (nanos > max && !max_.compare_exchange_weak(max, nanos, std::memory_order_relaxed))
+			;
+	}
+
+	//! The counts of the scope now
+	Summary summary() const;
+
+	//! Sets the timings of the scope to 0, see \ref ShardedCounters::reset()
+	void reset();
+
+	/*!
+	 * \brief Sets the log threshold
+	 *
+	 * When a pass through the scope takes longer than \a nanos, the
+	 * \ref ScopeTimer logs how long it took to its logger at
+	 * \ref Level::debug().  0, the default, logs nothing.
+	 *
+	 * \param nanos the threshold in nanoseconds
+	 */
+	void setLogThreshold(std::uint64_t nanos);
+
+	//! Gets the log threshold in nanoseconds
+	std::uint64_t logThreshold() const { return threshold_.load(std::memory_order_relaxed); }
+
+private:
+	enum Counter
+	{
+		Count,
+		TotalNanos,
+	};
+
+	ScopeStats(const std::string &name);
+	ScopeStats(const ScopeStats &);
+	ScopeStats &operator=(const ScopeStats &);
+
+	std::string name_;
+	ShardedCounters counters_;
+	ShardedHistogram histogram_;
+	std::atomic<std::uint64_t> max_;
+	std::atomic<std::uint64_t> threshold_;
+};
+
+/*!
+ * \brief Times a scope
+ *
+ * Adds the time from its construction to its destruction to a
+ * \ref ScopeStats, and logs it when it is over the scope's
+ * \ref ScopeStats::logThreshold().  Use \ref SHARKLOG_SCOPE_TIMER instead of
+ * making one directly.
+ *
+ * Scopes are only timed when the logger has \ref Level::debug() enabled,
+ * otherwise the timer costs one \ref Logger::isEnabled() check.
+ */
+class SHARKLOGAPI ScopeTimer
+{
+public:
+	/*!
+	 * \brief Constructor
+	 *
+	 * Starts timing if \a logger has debug enabled.  \a site is called then,
+	 * and only then, for the scope to add the time to.
+	 *
+	 * \param logger the logger to check and to log slow scopes to
+	 * \param loc where the scope is, for the log record
+	 * \param site returns the \ref ScopeStats to add to
+	 */
+	template <class Site>
+	ScopeTimer(const LoggerPtr &logger, const Location &loc, Site site)
+		: scope_(nullptr)
+		, loc_(nullptr)
+	{
+		if (!logger->isEnabled(Level::DEBUG))
+			return;
+
+		logger_ = logger;
+		scope_ = site();
+		loc_ = &loc;
+		start_ = std::chrono::steady_clock::now();
+	}
+
+	//! Destructor, adds the time taken
+	~ScopeTimer()
+	{
+		if (scope_)
+			finish();
+	}
+
+private:
+	ScopeTimer(const ScopeTimer &);
+	ScopeTimer &operator=(const ScopeTimer &);
+
+	void finish();
+
+	ScopeStats *scope_;
+	const Location *loc_;
+	LoggerPtr logger_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+} // sharklog
+
+#define SHARKLOG_SCOPE_CONCAT_(a, b) a##b
+#define SHARKLOG_SCOPE_CONCAT(a, b) SHARKLOG_SCOPE_CONCAT_(a, b)
+
+/*!
+ * \brief Scope timer macro
+ *
+ * Times the rest of the enclosing scope into the \ref sharklog::ScopeStats
+ * named \a name when \a logger has debug enabled.  When it doesn't, the
+ * timer costs one level check, \a name is not even looked up.  The name is
+ * looked up once per call site, so it should be the same every time the
+ * site runs, normally it is a literal.
+ *
+ * It compiles to nothing if SHARKLOG_COMPILE_MIN_LEVEL is below
+ * SHARKLOG_LEVEL_DEBUG, see \ref CompileLevels.
+ *
+ * \code
+ * void match(Order &order)
+ * {
+ *    SHARKLOG_SCOPE_TIMER(Logger::logger("engine"), "engine.match");
+ *    ...
+ * }
+ *
+ * // log the passes through match() over 1ms
+ * ScopeStats::scope("engine.match")->setLogThreshold(1000000);
+ * \endcode
+ */
+#if SHARKLOG_COMPILE_MIN_LEVEL >= SHARKLOG_LEVEL_DEBUG
+#define SHARKLOG_SCOPE_TIMER(logger, name) \
+    SHARKLOG_STATIC_LOCATION(SHARKLOG_SCOPE_CONCAT(sharklog_scope_location_, __LINE__)); \
+    sharklog::ScopeTimer SHARKLOG_SCOPE_CONCAT(sharklog_scope_timer_, __LINE__)(logger, \
+        SHARKLOG_SCOPE_CONCAT(sharklog_scope_location_, __LINE__), [&]() { \
+            static sharklog::ScopeStats *sharklog_scope_ = sharklog::ScopeStats::scope(name); \
+            return sharklog_scope_; })
+#else
+#define SHARKLOG_SCOPE_TIMER(logger, name)
+#endif
+
+#endif // scopetimer_H
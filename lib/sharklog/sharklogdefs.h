@@ -86,4 +86,43 @@
 
 #endif // _WIN32 || _WIN64
 
+////////////////////////////////////////////////////////////
+//
+// Compile time level stripping
+//
+////////////////////////////////////////////////////////////
+
+/*!
+ * \defgroup CompileLevels Compile time levels
+ *
+ * Numeric values of \ref Level::LogLevel for use in the preprocessor.
+ *
+ * SHARKLOG_COMPILE_MIN_LEVEL is the most detailed level the logging macros,
+ * i.e. \ref SHARKLOG_DEBUG and \ref SHARKLOG_FUNCTRACE, are compiled for.
+ * Macros for more detailed levels compile to nothing, their arguments are not
+ * even evaluated.  It defaults to SHARKLOG_LEVEL_ALL so nothing is stripped.
+ *
+ * For example, to strip TRACE, DEBUG and FUNCTRACE from a release build:
+ * \code
+ * cmake -DSHARKLOG_COMPILE_MIN_LEVEL=INFO ..
+ * \endcode
+ * or define SHARKLOG_COMPILE_MIN_LEVEL=SHARKLOG_LEVEL_INFO when building your
+ * own code.  Calling \ref Logger::log() directly is never stripped.
+ * @{
+ */
+#define SHARKLOG_LEVEL_NONE 0
+#define SHARKLOG_LEVEL_FATAL 1
+#define SHARKLOG_LEVEL_ERROR 2
+#define SHARKLOG_LEVEL_WARN 3
+#define SHARKLOG_LEVEL_INFO 4
+#define SHARKLOG_LEVEL_TRACE 5
+#define SHARKLOG_LEVEL_DEBUG 6
+#define SHARKLOG_LEVEL_FUNCTRACE 7
+#define SHARKLOG_LEVEL_ALL 8
+
+#if !defined(SHARKLOG_COMPILE_MIN_LEVEL)
+	#define SHARKLOG_COMPILE_MIN_LEVEL SHARKLOG_LEVEL_ALL
+#endif
+/*! @} */
+
 #endif // sharklogdef_H
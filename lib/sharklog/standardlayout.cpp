@@ -24,16 +24,29 @@
 
 #include "standardlayout.h"
 #include "level.h"
-#include "utilfunctions.h"
 #include <sstream>
 #include <chrono>
 #include <thread>
 #include <iomanip>
+#include <ctime>
 
 using namespace sharklog;
 using namespace std;
 using namespace std::chrono;
 
+namespace
+{
+	// "[MM/DD/YYYY][HH:MM:SS.mmm]", only the milliseconds change within a second
+	struct TimestampCache
+	{
+		long long second = -1;
+		size_t size = 0;
+		char text[64];
+	};
+
+	thread_local TimestampCache timestampCache_;
+}
+
 StandardLayout::~StandardLayout()
 {
 }
@@ -41,55 +54,67 @@ StandardLayout::~StandardLayout()
 void StandardLayout::formatMessage(std::string &result, const Level &level, const std::string &loggerName,
                                    const std::string &logMessage)
 {
-    stringstream ss;
-    
     // add name
     if (!loggerName.empty())
-		ss << "[" << loggerName << "]";
+    {
+        result += '[';
+        result += loggerName;
+        result += ']';
+    }
     
     // add level
-    ss << "[" << level.name() << "]";
+    result += '[';
+    result += Level::levelName(level.level());
+    result += ']';
     
     // add message
-    ss << " " << logMessage << endl;
-    
-    result.append(ss.str());
+    result += ' ';
+    result += logMessage;
+    result += '\n';
 }
 
 void StandardLayout::appendHeader(std::string &result)
 {
-    setupDate(result);
-    setupTime(result);
-    setupThread(result);
+    // one context per record so date and time come from the same clock read
+    auto ctx = RecordContext::current();
+    
+    setupTimestamp(result, ctx);
+    setupThread(result, ctx);
 }
 
 void StandardLayout::appendFooter(std::string &result)
 {
 }
 
-void StandardLayout::setupDate(std::string &s)
+void StandardLayout::setupTimestamp(std::string &s, const RecordContext &ctx)
 {
-    stringstream ss;
-    UtilFunctions::Time t;
-
-    ss << "[" << formatTime("%m/%d/%Y", t.tmStruct()) << "]";
+    auto ms = duration_cast<milliseconds>(ctx.time().time_since_epoch()).count();
+    auto second = ms / 1000;
+    auto &cache = timestampCache_;
     
-    s.append(ss.str());
-}
-
-void StandardLayout::setupTime(std::string &s)
-{
-    stringstream ss;
-
-	UtilFunctions::Time t;
-
-    ss << "[" << formatTime("%H:%M:%S", t.tmStruct()) << "." << setfill('0') << setw(3) << t.ms() << "]";
-    s.append(ss.str());
+    // date and time only change once a second, rebuild them when they do
+    if (second != cache.second)
+    {
+        time_t current = (time_t)second;
+        tm t;
+        localtime_r(&current, &t);
+        cache.size = strftime(cache.text, sizeof(cache.text), "[%m/%d/%Y][%H:%M:%S.000]", &t);
+        cache.second = second;
+    }
+    
+    // the milliseconds are the 3 digits before the closing ]
+    auto millis = (int)(ms % 1000);
+    auto digits = cache.text + cache.size - 4;
+    digits[0] = (char)('0' + millis / 100);
+    digits[1] = (char)('0' + millis / 10 % 10);
+    digits[2] = (char)('0' + millis % 10);
+    
+    s.append(cache.text, cache.size);
 }
 
-void StandardLayout::setupThread(std::string &s)
+void StandardLayout::setupThread(std::string &s, const RecordContext &ctx)
 {
-    stringstream ss;
-    ss << "[0x" << hex << this_thread::get_id() << "]";
-    s.append(ss.str());
+    s += '[';
+    appendThreadId(s, ctx);
+    s += ']';
 }
@@ -27,6 +27,7 @@
 
 #include <sharklog/sharklogdefs.h>
 #include <sharklog/layout.h>
+#include <sharklog/recordcontext.h>
 #include <string>
 
 namespace sharklog
@@ -39,7 +40,7 @@ namespace sharklog
  * It has a format like so: 
  *  
  * \code 
- * // Date [MM/DD/YYYY] Time [HH:MM:SS.msec] Thread ID [0xff] Level [INFO] Log message
+ * // Date [MM/DD/YYYY] Time [HH:MM:SS.msec] Thread ID or name [0xff] Level [INFO] Log message
  * [01/20/2017][23:23:11.788][0x7f7a19143740][INFO] testing
  * \endcode 
  *  
@@ -47,6 +48,10 @@ namespace sharklog
  *  
  * When using a \ref BasicConfig or \ref BasicFileConfig this is the layout that 
  * is used. 
+ *  
+ * Everything is appended straight to the string passed in.  If the caller reuses 
+ * that string, formatting a record does not allocate once each thread has 
+ * formatted its first one. 
  */
 class SHARKLOGAPI StandardLayout : public Layout
 {
@@ -79,9 +84,8 @@ public:
     void appendFooter(std::string &result) override;
     
 private:
-    void setupDate(std::string &s);
-    void setupTime(std::string &s);
-    void setupThread(std::string &s);
+    void setupTimestamp(std::string &s, const RecordContext &ctx);
+    void setupThread(std::string &s, const RecordContext &ctx);
 };
     
 } // sharklog
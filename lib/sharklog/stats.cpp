@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "stats.h"
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <new>
+#include <cmath>
+
+using namespace sharklog;
+using namespace std;
+
+const std::size_t ShardedCounters::MaxCounters;
+const std::size_t ShardedHistogram::BucketCount;
+
+namespace
+{
+	const std::size_t CacheLine = 64;
+
+	// shards owned by one thread, one more is shared by the threads past them
+	std::size_t computeOwnedShards()
+	{
+		std::size_t hardware = thread::hardware_concurrency();
+		std::size_t count = 8;
+		while (count < hardware && count < 64)
+			count <<= 1;
+		return count;
+	}
+
+	// trivial so reading it needs no guard.  initial-exec makes it a fixed
+	// offset from the thread pointer instead of a __tls_get_addr() call per
+	// use, glibc keeps room for small variables like this in libraries that
+	// are dlopen()ed
+#if defined(__GNUC__) && !defined(_WIN32)
+	__attribute__((tls_model("initial-exec")))
+#endif
+	thread_local ShardedCounters::ThreadSlot shard_ = { 0, false, false, 0 };
+
+	std::mutex &shardMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	// shards given back by threads that exited, handed out again before new ones
+	std::vector<unsigned int> &freeShards()
+	{
+		static std::vector<unsigned int> shards;
+		return shards;
+	}
+
+	unsigned int nextShard_ = 0;
+
+	// gives the shard back when the thread exits
+	struct ShardOwner
+	{
+		~ShardOwner()
+		{
+			if (!shard_.owned)
+				return;
+
+			lock_guard<std::mutex> lock(shardMutex());
+			freeShards().push_back(shard_.index);
+
+			// anything counted after this goes to the shared shard
+			shard_.index = (unsigned int)ShardedCounters::shardCount() - 1;
+			shard_.owned = false;
+		}
+	};
+
+#if defined(_MSC_VER)
+	__declspec(noinline)
+#else
+	__attribute__((noinline))
+#endif
+	void assignShard(ShardedCounters::ThreadSlot &slot)
+	{
+		auto owned = (unsigned int)ShardedCounters::shardCount() - 1;
+		{
+			lock_guard<std::mutex> lock(shardMutex());
+			auto &free = freeShards();
+			if (!free.empty())
+			{
+				slot.index = free.back();
+				free.pop_back();
+			}
+			else if (nextShard_ < owned)
+				slot.index = nextShard_++;
+			else
+				slot.index = owned;
+		}
+
+		slot.owned = slot.index < owned;
+		slot.assigned = true;
+		if (slot.owned)
+		{
+			thread_local ShardOwner owner;
+			(void)owner;
+		}
+	}
+}
+
+ShardedCounters::ShardedCounters()
+	: shards_(nullptr)
+	, memory_(nullptr)
+{
+}
+
+ShardedCounters::~ShardedCounters()
+{
+	delete [] memory_;
+}
+
+ShardedCounters::ThreadSlot &ShardedCounters::threadSlot()
+{
+	// one thread local lookup, the slow path is kept out of line
+	auto slot = &shard_;
+	if (!slot->assigned)
+		assignShard(*slot);
+	return *slot;
+}
+
+void ShardedCounters::reserve()
+{
+	if (!shards_.load(memory_order_acquire))
+		allocate();
+}
+
+std::size_t ShardedCounters::shardCount()
+{
+	static const std::size_t count = computeOwnedShards() + 1;
+	return count;
+}
+
+ShardedCounters::Shard *ShardedCounters::allocate()
+{
+	// new[] doesn't align to a cache line before C++17 so line the shards up here
+	auto count = shardCount();
+	auto memory = new char[count * sizeof(Shard) + CacheLine];
+	auto aligned = reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(memory) + CacheLine - 1) & ~(std::uintptr_t)(CacheLine - 1));
+	auto created = reinterpret_cast<Shard *>(aligned);
+	for (std::size_t s=0;s<count;++s)
+	{
+		new (&created[s]) Shard;
+		for (auto &it : created[s].values)
+			it.store(0, memory_order_relaxed);
+	}
+
+	Shard *shards = nullptr;
+	if (!shards_.compare_exchange_strong(shards, created, memory_order_acq_rel))
+	{
+		// another thread got there first
+		delete [] memory;
+		return shards;
+	}
+
+	memory_ = memory;
+	return created;
+}
+
+std::uint64_t ShardedCounters::total(std::size_t counter) const
+{
+	auto shards = shards_.load(memory_order_acquire);
+	if (!shards)
+		return 0;
+
+	std::uint64_t total = 0;
+	for (std::size_t s=0;s<shardCount();++s)
+		total += shards[s].values[counter].load(memory_order_relaxed);
+	return total;
+}
+
+void ShardedCounters::reset()
+{
+	auto shards = shards_.load(memory_order_acquire);
+	if (!shards)
+		return;
+
+	for (std::size_t s=0;s<shardCount();++s)
+	{
+		for (auto &it : shards[s].values)
+			it.store(0, memory_order_relaxed);
+	}
+}
+
+ShardedHistogram::ShardedHistogram()
+	: reserved_(false)
+{
+}
+
+void ShardedHistogram::record(const ShardedCounters::ThreadSlot &slot, std::uint64_t value)
+{
+	if (!reserved_.load(memory_order_acquire))
+	{
+		for (auto &it : groups_)
+			it.reserve();
+		reserved_.store(true, memory_order_release);
+	}
+
+	auto b = bucket(value);
+	groups_[b / ShardedCounters::MaxCounters].add(slot, b % ShardedCounters::MaxCounters);
+}
+
+std::vector<std::uint64_t> ShardedHistogram::counts() const
+{
+	std::vector<std::uint64_t> counts(BucketCount);
+	for (std::size_t b=0;b<BucketCount;++b)
+		counts[b] = groups_[b / ShardedCounters::MaxCounters].total(b % ShardedCounters::MaxCounters);
+	return counts;
+}
+
+void ShardedHistogram::reset()
+{
+	for (auto &it : groups_)
+		it.reset();
+}
+
+std::uint64_t ShardedHistogram::bucketLimit(std::size_t bucket)
+{
+	if (bucket < 4)
+		return bucket;
+
+	auto top = bucket / 4 + 1;
+	return (((std::uint64_t)(bucket % 4) + 5) << (top - 2)) - 1;
+}
+
+std::uint64_t ShardedHistogram::percentile(const std::vector<std::uint64_t> &counts, double percentile)
+{
+	std::uint64_t total = 0;
+	for (auto it : counts)
+		total += it;
+	if (!total)
+		return 0;
+
+	// the rank of the record the percentile lands on, counting from 1
+	auto rank = (std::uint64_t)ceil(percentile / 100.0 * total);
+	if (rank < 1)
+		rank = 1;
+
+	std::uint64_t seen = 0;
+	for (std::size_t b=0;b<counts.size();++b)
+	{
+		seen += counts[b];
+		if (seen >= rank)
+			return bucketLimit(b);
+	}
+	return bucketLimit(counts.size() - 1);
+}
+
+LoggerStats &LoggerStats::operator+=(const LoggerStats &other)
+{
+	accepted += other.accepted;
+	filtered += other.filtered;
+	for (std::size_t l=0;l<Level::ALL;++l)
+		levels[l] += other.levels[l];
+	return *this;
+}
+
+LoggerStats &LoggerStats::operator-=(const LoggerStats &earlier)
+{
+	accepted -= earlier.accepted;
+	filtered -= earlier.filtered;
+	for (std::size_t l=0;l<Level::ALL;++l)
+		levels[l] -= earlier.levels[l];
+	return *this;
+}
+
+std::uint64_t OutputterStats::writeNanos() const
+{
+	if (!timedRecords)
+		return 0;
+	return (std::uint64_t)((double)timedNanos / timedRecords * records);
+}
+
+OutputterStats &OutputterStats::operator+=(const OutputterStats &other)
+{
+	records += other.records;
+	bytesFormatted += other.bytesFormatted;
+	bytesWritten += other.bytesWritten;
+	writeErrors += other.writeErrors;
+	dropped += other.dropped;
+	timedRecords += other.timedRecords;
+	timedNanos += other.timedNanos;
+
+	if (writeLatency.size() < other.writeLatency.size())
+		writeLatency.resize(other.writeLatency.size());
+	for (std::size_t b=0;b<other.writeLatency.size();++b)
+		writeLatency[b] += other.writeLatency[b];
+	return *this;
+}
+
+OutputterStats &OutputterStats::operator-=(const OutputterStats &earlier)
+{
+	records -= earlier.records;
+	bytesFormatted -= earlier.bytesFormatted;
+	bytesWritten -= earlier.bytesWritten;
+	writeErrors -= earlier.writeErrors;
+	dropped -= earlier.dropped;
+	timedRecords -= earlier.timedRecords;
+	timedNanos -= earlier.timedNanos;
+
+	for (std::size_t b=0;b<writeLatency.size() && b<earlier.writeLatency.size();++b)
+		writeLatency[b] -= earlier.writeLatency[b];
+	return *this;
+}
+
+std::uint64_t OutputterStats::writeLatencyPercentile(double percentile) const
+{
+	return ShardedHistogram::percentile(writeLatency, percentile);
+}
+
+void StatsSnapshot::write(std::ostream &out) const
+{
+	auto flags = out.flags();
+	auto writeLogger = [&](const string &name, const LoggerStats &stats) {
+		out << left << setw(40) << name << right << " accepted " << setw(12) << stats.accepted
+			<< " filtered " << setw(12) << stats.filtered << "\n";
+	};
+	auto writeOutputter = [&](const string &name, const OutputterStats &stats) {
+		out << left << setw(40) << name << right << " records " << setw(12) << stats.records
+			<< " formatted " << setw(14) << stats.bytesFormatted << " written " << setw(14) << stats.bytesWritten
+			<< " errors " << setw(6) << stats.writeErrors << " dropped " << setw(8) << stats.dropped << " write ns " << setw(14) << stats.writeNanos() << "\n";
+	};
+
+	for (auto &it : loggers)
+		writeLogger(it.name, it.stats);
+	writeLogger("total", loggerTotal);
+
+	for (auto &it : outputters)
+		writeOutputter(it.name, it.stats);
+	writeOutputter("total", outputterTotal);
+
+	out.flags(flags);
+	out.flush();
+}
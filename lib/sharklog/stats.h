@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __stats_H
+#define __stats_H
+
+#include <sharklog/sharklogdefs.h>
+#include <sharklog/level.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sharklog
+{
+
+class Outputter;
+
+/*!
+ * \brief Counters split into one cache line per thread shard
+ *
+ * Each thread is given a shard of its own the first time it counts
+ * something and gives it back when it exits, so the threads that count never
+ * write the same cache line and adding is a plain load and store, no locked
+ * instructions.  There are at least 8 owned shards, or one per hardware
+ * thread up to 64.  Threads past that share one more shard and add to it
+ * atomically.  Reading adds up all the shards.
+ *
+ * The shards are allocated the first time something is counted, an object
+ * that never counts anything only costs two pointers.
+ */
+class SHARKLOGAPI ShardedCounters
+{
+public:
+	//! Counters per object, one shard is one 64 byte cache line
+	static const std::size_t MaxCounters = 8;
+
+	/*!
+	 * \brief Where the calling thread counts
+	 *
+	 * Look it up once with \ref threadSlot() to count several things, it is
+	 * thread local.
+	 */
+	struct ThreadSlot
+	{
+		//! the thread's shard
+		unsigned int index;
+		//! true once the thread has a shard
+		bool assigned;
+		//! true when no other thread counts on the shard
+		bool owned;
+		//! free running count for the thread to sample with, i.e. time every 64th record
+		unsigned int ticks;
+	};
+
+	//! Constructor
+	ShardedCounters();
+
+	//! Destructor
+	~ShardedCounters();
+
+	//! The calling thread's slot, handing it a shard the first time
+	static ThreadSlot &threadSlot();
+
+	//! Adds \a value to \a counter on the calling thread's shard
+	void add(std::size_t counter, std::uint64_t value = 1)
+	{
+		add(threadSlot(), counter, value);
+	}
+
+	//! Adds \a value to \a counter on the shard of \a slot
+	void add(const ThreadSlot &slot, std::size_t counter, std::uint64_t value = 1)
+	{
+		auto shards = shards_.load(std::memory_order_acquire);
+		if (!shards)
+			shards = allocate();
+
+		auto &it = shards[slot.index].values[counter];
+		if (slot.owned)
+			it.store(it.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		else
+			it.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	//! The sum of \a counter over all the shards
+	std::uint64_t total(std::size_t counter) const;
+
+	/*!
+	 * \brief Sets every counter to 0
+	 *
+	 * Only exact while no thread is counting, a thread adding at the same
+	 * time can put back what it had.  Take the difference of two
+	 * \ref total() calls to count over an interval instead.
+	 */
+	void reset();
+
+	//! Allocates the shards now instead of when something is first counted
+	void reserve();
+
+	//! The number of shards each object has, including the shared one
+	static std::size_t shardCount();
+
+private:
+	struct Shard
+	{
+		std::atomic<std::uint64_t> values[MaxCounters];
+	};
+
+	ShardedCounters(const ShardedCounters &);
+	ShardedCounters &operator=(const ShardedCounters &);
+
+	Shard *allocate();
+
+	std::atomic<Shard *> shards_;
+	char *memory_;
+};
+
+/*!
+ * \brief A histogram of nanoseconds kept in \ref ShardedCounters
+ *
+ * Each power of 2 is split into 4 buckets so a percentile read from it is
+ * the top of a bucket at most 25% wider than the real value.  It covers 0 to
+ * 2^36 nanoseconds, about 69 seconds, longer times count in the last bucket.
+ * Recording is one add to a thread's own shard like \ref ShardedCounters.
+ */
+class SHARKLOGAPI ShardedHistogram
+{
+public:
+	//! Number of buckets
+	static const std::size_t BucketCount = 144;
+
+	//! Constructor
+	ShardedHistogram();
+
+	/*!
+	 * \brief Counts \a value on the shard of \a slot
+	 *
+	 * The first value allocates the shards of every bucket so values that
+	 * land in a new bucket later never allocate.
+	 */
+	void record(const ShardedCounters::ThreadSlot &slot, std::uint64_t value);
+
+	//! The count in each bucket, summed over the shards
+	std::vector<std::uint64_t> counts() const;
+
+	//! Sets every bucket to 0, see \ref ShardedCounters::reset()
+	void reset();
+
+	//! The bucket \a value is counted in
+	static std::size_t bucket(std::uint64_t value)
+	{
+		if (value < 4)
+			return (std::size_t)value;
+
+#if defined(__GNUC__)
+		std::size_t top = 63 - (std::size_t)__builtin_clzll(value);
+#else
+		std::size_t top = 63;
+		while (!(value >> top))
+			--top;
+#endif
+		if (top > 36)
+			return BucketCount - 1;
+		return (top - 1) * 4 + (std::size_t)((value >> (top - 2)) & 3);
+	}
+
+	//! The largest value counted in \a bucket
+	static std::uint64_t bucketLimit(std::size_t bucket);
+
+	/*!
+	 * \brief Reads a percentile from bucket counts
+	 *
+	 * \param counts bucket counts from \ref counts()
+	 * \param percentile 0 to 100, i.e. 99.9
+	 * \return the top of the bucket the percentile falls in, 0 when nothing was counted
+	 */
+	static std::uint64_t percentile(const std::vector<std::uint64_t> &counts, double percentile);
+
+private:
+	ShardedHistogram(const ShardedHistogram &);
+	ShardedHistogram &operator=(const ShardedHistogram &);
+
+	std::atomic<bool> reserved_;
+	ShardedCounters groups_[BucketCount / ShardedCounters::MaxCounters];
+};
+
+/*!
+ * \brief What a \ref Logger counted, see \ref Logger::stats()
+ */
+struct SHARKLOGAPI LoggerStats
+{
+	//! records that passed the level check and went to the outputters
+	std::uint64_t accepted = 0;
+
+	/*!
+	 * \ref accepted per \ref Level::LogLevel, FATAL to FUNCTRACE.  Records
+	 * logged at NONE or ALL count as FUNCTRACE
+	 */
+	std::uint64_t levels[Level::ALL] = {};
+
+	/*!
+	 * records \ref Logger::log() and \ref Logger::logDeferred() dropped for
+	 * their level.  The log macros and \ref LoggerStream check the level
+	 * before calling them so their disabled records are not counted, that
+	 * check stays a single inline compare
+	 */
+	std::uint64_t filtered = 0;
+
+	//! Adds \a other to these counts
+	LoggerStats &operator+=(const LoggerStats &other);
+
+	//! Takes away \a earlier counts of the same logger, leaving what was counted since
+	LoggerStats &operator-=(const LoggerStats &earlier);
+};
+
+/*!
+ * \brief What an \ref Outputter counted, see \ref Outputter::stats()
+ */
+struct SHARKLOGAPI OutputterStats
+{
+	//! records given to the outputter by its loggers or wrapping outputter
+	std::uint64_t records = 0;
+
+	//! bytes of text or binary records the outputter formatted
+	std::uint64_t bytesFormatted = 0;
+
+	//! bytes the outputter handed to the file, stream or mapping
+	std::uint64_t bytesWritten = 0;
+
+	//! writes that failed
+	std::uint64_t writeErrors = 0;
+
+	//! records dropped instead of written, i.e. by an AsyncOutputter with a full queue
+	std::uint64_t dropped = 0;
+
+	//! records whose writeLog() was timed, one in every 64 per thread
+	std::uint64_t timedRecords = 0;
+
+	//! nanoseconds spent in the timed writeLog() calls
+	std::uint64_t timedNanos = 0;
+
+	//! \ref ShardedHistogram buckets of the timed writeLog() calls, empty when none were timed
+	std::vector<std::uint64_t> writeLatency;
+
+	//! Estimated nanoseconds spent in writeLog() for all the records
+	std::uint64_t writeNanos() const;
+
+	//! Nanoseconds \a percentile of the timed writeLog() calls took at most, see \ref ShardedHistogram::percentile()
+	std::uint64_t writeLatencyPercentile(double percentile) const;
+
+	//! Adds \a other to these counts
+	OutputterStats &operator+=(const OutputterStats &other);
+
+	//! Takes away \a earlier counts of the same outputter, leaving what was counted since
+	OutputterStats &operator-=(const OutputterStats &earlier);
+};
+
+/*!
+ * \brief The counters of every logger and outputter at one time
+ *
+ * See \ref Logger::allStats().
+ */
+struct SHARKLOGAPI StatsSnapshot
+{
+	//! A logger's counts
+	struct LoggerEntry
+	{
+		std::string name;
+		LoggerStats stats;
+	};
+
+	//! An outputter's counts
+	struct OutputterEntry
+	{
+		//! the owning logger's name and the outputter's index in it, i.e. app.net#0
+		std::string name;
+		std::shared_ptr<Outputter> outputter;
+		OutputterStats stats;
+	};
+
+	//! every logger, root first and then by name
+	std::vector<LoggerEntry> loggers;
+
+	//! every outputter added to a logger, and the ones they wrap
+	std::vector<OutputterEntry> outputters;
+
+	//! sum of \ref loggers
+	LoggerStats loggerTotal;
+
+	//! sum of \ref outputters, records going through an AsyncOutputter count for both it and its outputter
+	OutputterStats outputterTotal;
+
+	//! Writes one line per logger and outputter, then the totals
+	void write(std::ostream &out) const;
+};
+
+} // sharklog
+
+#endif // stats_H
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "threadinfo.h"
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	long currentSystemId()
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		return (long)GetCurrentThreadId();
+#elif defined(__linux__)
+		return (long)syscall(SYS_gettid);
+#else
+		return (long)hash<std::thread::id>()(this_thread::get_id());
+#endif
+	}
+
+	// trivial so reading it skips the thread_local init check
+	thread_local ThreadInfo *current_ = nullptr;
+}
+
+ThreadInfo::ThreadInfo()
+	: id_(this_thread::get_id())
+	, systemId_(currentSystemId())
+{
+	// formatted with a stream once, copied for every record after
+	stringstream ss;
+	ss << "0x" << hex << id_;
+	auto text = ss.str();
+	idSize_ = min(text.size(), sizeof(idText_));
+	memcpy(idText_, text.data(), idSize_);
+}
+
+const ThreadInfo &ThreadInfo::current()
+{
+	if (auto info = current_)
+		return *info;
+	return mutableCurrent();
+}
+
+ThreadInfo &ThreadInfo::mutableCurrent()
+{
+	thread_local ThreadInfo info;
+	current_ = &info;
+	return info;
+}
+
+void sharklog::setThreadName(const std::string &name)
+{
+	// records already logged keep the old name, they hold their own pointer
+	auto &info = ThreadInfo::mutableCurrent();
+	if (name.empty())
+		info.name_.reset();
+	else
+		info.name_ = make_shared<const std::string>(name);
+}
+
+std::string sharklog::threadName()
+{
+	auto &name = ThreadInfo::current().name();
+	return name ? *name : std::string();
+}
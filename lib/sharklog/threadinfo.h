@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __threadinfo_H
+#define __threadinfo_H
+
+#include <sharklog/sharklogdefs.h>
+#include <string>
+#include <memory>
+#include <thread>
+#include <cstddef>
+
+namespace sharklog
+{
+
+/*!
+ * \brief Names the current thread in log records
+ *
+ * Layouts print \a name instead of the thread id for records logged by this
+ * thread from now on, i.e. [io-worker-3] instead of [0x7f7a19143740].  An
+ * empty name goes back to the id.
+ *
+ * \code
+ * std::thread([]() {
+ *    sharklog::setThreadName("io-worker-3");
+ *    ...
+ * });
+ * \endcode
+ */
+SHARKLOGAPI void setThreadName(const std::string &name);
+
+//! The name of the current thread, empty if it doesn't have one
+SHARKLOGAPI std::string threadName();
+
+/*!
+ * \brief What the logs know about a thread
+ *
+ * Built once per thread, the first time it logs, so layouts can copy the
+ * thread id as text instead of formatting it for every record.
+ * \ref RecordContext captures the parts a record needs when it is logged.
+ */
+class SHARKLOGAPI ThreadInfo
+{
+public:
+	//! Info for the calling thread
+	static const ThreadInfo &current();
+
+	//! The thread id
+	std::thread::id id() const { return id_; }
+
+	//! The id as layouts print it, i.e. 0x7f7a19143740
+	const char *idText() const { return idText_; }
+
+	//! Length of \ref idText()
+	std::size_t idSize() const { return idSize_; }
+
+	/*!
+	 * \brief The thread id the operating system uses
+	 *
+	 * gettid() on Linux, the same number top and gdb show, GetCurrentThreadId()
+	 * on Windows.  Other systems get a number made from \ref id().
+	 */
+	long systemId() const { return systemId_; }
+
+	//! The thread name, null if it doesn't have one, see \ref setThreadName()
+	const std::shared_ptr<const std::string> &name() const { return name_; }
+
+private:
+	friend void setThreadName(const std::string &name);
+
+	ThreadInfo();
+	ThreadInfo(const ThreadInfo &);
+	ThreadInfo &operator=(const ThreadInfo &);
+
+	static ThreadInfo &mutableCurrent();
+
+	std::thread::id id_;
+	char idText_[40];
+	std::size_t idSize_;
+	long systemId_;
+	std::shared_ptr<const std::string> name_;
+};
+
+} // sharklog
+
+#endif // threadinfo_H
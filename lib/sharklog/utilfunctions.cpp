@@ -66,6 +66,12 @@ UtilFunctions::Time::Time() :
 	getCurrentTime();
 }
 
+UtilFunctions::Time::Time(const system_clock::time_point &tp) :
+	ms_(0)
+{
+	setTime(tp);
+}
+
 void UtilFunctions::Time::getCurrentTime()
 {
 #if defined(_MSC_VER)
@@ -81,3 +87,11 @@ void UtilFunctions::Time::getCurrentTime()
 	ms_ = ms.count() % 1000;
 #endif
 }
+
+void UtilFunctions::Time::setTime(const system_clock::time_point &tp)
+{
+	auto ms = duration_cast<milliseconds>(tp.time_since_epoch());
+	time_t current = duration_cast<seconds>(ms).count();
+	localtime_r(&current, &tms_);
+	ms_ = ms.count() % 1000;
+}
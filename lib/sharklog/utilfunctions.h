@@ -28,6 +28,8 @@
 #include <sharklog/sharklogdefs.h>
 #include <vector>
 #include <string>
+#include <ctime>
+#include <chrono>
 
 namespace sharklog
 {
@@ -94,6 +96,17 @@ public:
 		//! Constructor
 		Time();
 
+		/*!
+		 * \brief Constructor from a time point
+		 *
+		 * Builds the local time for \a tp instead of the current time.  This
+		 * is used to format records that were logged earlier, see
+		 * \ref RecordContext.
+		 *
+		 * \param tp the time to use
+		 */
+		Time(const std::chrono::system_clock::time_point &tp);
+
 		/*!
 		 * \brief Loads current time
 		 *
@@ -106,6 +119,15 @@ public:
 		 */
 		void getCurrentTime();
 
+		/*!
+		 * \brief Loads a time point
+		 *
+		 * Sets this time to the local time of \a tp.
+		 *
+		 * \param tp the time to load
+		 */
+		void setTime(const std::chrono::system_clock::time_point &tp);
+
 		/*!
 		 * \brief Gets the tm struct
 		 *
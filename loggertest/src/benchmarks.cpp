@@ -0,0 +1,535 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "benchmarks.h"
+#include <sharklog/logger.h>
+#include <sharklog/outputter.h>
+#include <sharklog/fileoutputter.h>
+#include <sharklog/rawfileoutputter.h>
+#include <sharklog/mappedfileoutputter.h>
+#include <sharklog/binaryfileoutputter.h>
+#include <sharklog/consoleoutputter.h>
+#include <sharklog/asyncoutputter.h>
+#include <sharklog/loggerstream.h>
+#include <sharklog/standardlayout.h>
+#include <sharklog/patternlayout.h>
+#include <sharklog/recordcontext.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+using namespace sharklog;
+
+namespace
+{
+	// keeps the optimizer from throwing away the work we are timing
+	volatile std::size_t sink_ = 0;
+
+	// takes the message and does nothing with it so only dispatch is timed
+	class NullOutputter : public Outputter
+	{
+	public:
+		bool open() override { return true; }
+		void writeLog(const Level &, const std::string &loggerName, const std::string &logMessage, const Location &) override
+		{
+			sink_ = loggerName.size() + logMessage.size();
+		}
+		void close() override { }
+		bool isOpen() const override { return true; }
+		bool isValid() const override { return true; }
+	};
+
+	// write system calls made by this process so far, -1 if we can't tell
+	long long writeSyscalls()
+	{
+		ifstream io("/proc/self/io");
+		string key;
+		long long value;
+		while (io >> key >> value)
+		{
+			if (key == "syscw:")
+				return value;
+		}
+		return -1;
+	}
+}
+
+int lookupBenchmark()
+{
+	const unsigned int lookups = 1000000;
+	const unsigned int sizes[] = { 10, 100, 1000, 10000, 100000 };
+
+	cout << "Logger::logger() lookup, " << lookups << " lookups per size" << endl << endl;
+	cout << setw(10) << "loggers" << setw(14) << "ns/lookup" << endl;
+
+	for (auto size : sizes)
+	{
+		// two level names like the ones apps use, i.e. app.module123
+		vector<string> names;
+		for (unsigned int i=0;i<size;++i)
+			names.push_back("bench.Module" + to_string(i));
+
+		for (auto &it : names)
+			Logger::logger(it);
+
+		// look them up in random order with different case
+		vector<string> keys;
+		mt19937 rng(42);
+		uniform_int_distribution<unsigned int> dist(0, size - 1);
+		for (unsigned int i=0;i<4096;++i)
+			keys.push_back("BENCH.module" + to_string(dist(rng)));
+
+		auto start = steady_clock::now();
+		for (unsigned int i=0;i<lookups;++i)
+			sink_ += (std::size_t)Logger::logger(keys[i & 4095]).get();
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+		cout << setw(10) << size << setw(14) << fixed << setprecision(1) << (double)elapsed / lookups << endl;
+
+		Logger::closeRootLogger();
+	}
+
+	return 0;
+}
+
+int dispatchBenchmark()
+{
+	const unsigned int messages = 1000000;
+	const unsigned int threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+	auto log = Logger::logger("bench.dispatch");
+	log->addOutputter(make_shared<NullOutputter>());
+	log->addOutputter(make_shared<NullOutputter>());
+	const string msg = "dispatch benchmark message";
+
+	cout << "Logger::log() to 2 outputters, " << messages << " messages per thread" << endl;
+	cout << "hardware threads: " << thread::hardware_concurrency() << endl << endl;
+	cout << setw(10) << "threads" << setw(16) << "msgs/sec" << setw(14) << "ns/msg" << endl;
+
+	for (auto count : threadCounts)
+	{
+		atomic<unsigned int> ready(0);
+		atomic<bool> go(false);
+		vector<thread> threads;
+		for (unsigned int t=0;t<count;++t)
+		{
+			threads.push_back(thread([&]() {
+				++ready;
+				while (!go.load())
+					this_thread::yield();
+
+				for (unsigned int i=0;i<messages;++i)
+					log->log(Level::info(), msg);
+			}));
+		}
+
+		while (ready.load() < count)
+			this_thread::yield();
+
+		auto start = steady_clock::now();
+		go = true;
+		for (auto &it : threads)
+			it.join();
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+		double total = (double)messages * count;
+		cout << setw(10) << count << setw(16) << fixed << setprecision(0) << total * 1e9 / elapsed
+			<< setw(14) << setprecision(1) << (double)elapsed / total << endl;
+	}
+
+	Logger::closeRootLogger();
+	return 0;
+}
+
+int fileScalingBenchmark()
+{
+	const unsigned int records = 200000;
+	const unsigned int fileCounts[] = { 1, 2, 4, 8, 16, 32 };
+	const string msg = "file scaling benchmark message with some text in it";
+
+	cout << "FileOutputter, one thread and file per logger, " << records << " records per thread" << endl;
+	cout << "hardware threads: " << thread::hardware_concurrency() << endl << endl;
+	cout << setw(10) << "files" << setw(16) << "records/sec" << setw(14) << "MB/sec" << endl;
+
+	for (auto count : fileCounts)
+	{
+		vector<shared_ptr<Logger>> loggers;
+		vector<shared_ptr<FileOutputter>> files;
+		for (unsigned int f=0;f<count;++f)
+		{
+			auto fop = make_shared<FileOutputter>("file-scaling-" + to_string(f) + ".tmp");
+			fop->setLayout(make_shared<StandardLayout>());
+			if (!fop->open())
+			{
+				cout << "Failed to open file " << fop->filename() << endl;
+				return 1;
+			}
+
+			auto log = Logger::logger("bench.file" + to_string(f));
+			log->addOutputter(fop);
+			loggers.push_back(log);
+			files.push_back(fop);
+		}
+
+		atomic<unsigned int> ready(0);
+		atomic<bool> go(false);
+		vector<thread> threads;
+		for (unsigned int t=0;t<count;++t)
+		{
+			auto log = loggers[t];
+			threads.push_back(thread([&, log]() {
+				++ready;
+				while (!go.load())
+					this_thread::yield();
+
+				for (unsigned int i=0;i<records;++i)
+					log->log(Level::info(), msg);
+			}));
+		}
+
+		while (ready.load() < count)
+			this_thread::yield();
+
+		auto start = steady_clock::now();
+		go = true;
+		for (auto &it : threads)
+			it.join();
+
+		// closing flushes what is still buffered, that is part of the cost
+		for (auto &it : files)
+			it->close();
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+		std::size_t bytes = 0;
+		for (auto &it : files)
+		{
+			FILE *f = fopen(it->filename().c_str(), "rb");
+			if (f)
+			{
+				fseek(f, 0, SEEK_END);
+				bytes += ftell(f);
+				fclose(f);
+			}
+			remove(it->filename().c_str());
+		}
+
+		double total = (double)records * count;
+		cout << setw(10) << count << setw(16) << fixed << setprecision(0) << total * 1e9 / elapsed
+			<< setw(14) << setprecision(1) << (double)bytes * 1e3 / elapsed << endl;
+
+		Logger::closeRootLogger();
+	}
+
+	return 0;
+}
+
+int writeBenchmark()
+{
+	const unsigned int records = 1000000;
+	const string filename = "write-benchmark.tmp";
+	const string name = "bench.write";
+	const string msg = "write benchmark message with some text in it";
+
+	cout << "File writes, " << records << " records through StandardLayout" << endl << endl;
+	cout << setw(10) << "outputter" << setw(14) << "MB/sec" << setw(16) << "records/sec" << setw(18) << "syscalls/1M" << endl;
+
+	OutputterPtr outputters[] = { make_shared<FileOutputter>(filename), make_shared<RawFileOutputter>(filename),
+		make_shared<MappedFileOutputter>(filename) };
+	const char *names[] = { "ofstream", "writev", "mmap" };
+	for (int o=0;o<3;++o)
+	{
+		auto &op = outputters[o];
+		op->setLayout(make_shared<StandardLayout>());
+		if (!op->open())
+		{
+			cout << "Failed to open file " << filename << endl;
+			return 1;
+		}
+
+		auto calls = writeSyscalls();
+		auto start = steady_clock::now();
+		for (unsigned int i=0;i<records;++i)
+			op->writeLog(Level::info(), name, msg, Location());
+		op->close();
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+		if (calls >= 0)
+			calls = writeSyscalls() - calls;
+
+		ifstream f(filename, ios::binary | ios::ate);
+		double bytes = f.tellg();
+		f.close();
+		remove(filename.c_str());
+
+		cout << setw(10) << names[o] << setw(14) << fixed << setprecision(1) << bytes * 1e3 / elapsed
+			<< setw(16) << setprecision(0) << (double)records * 1e9 / elapsed << setw(18);
+		if (calls >= 0)
+			cout << (double)calls * 1000000 / records << endl;
+		else
+			cout << "n/a" << endl;
+	}
+
+	return 0;
+}
+
+int consoleBenchmark()
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	const unsigned int records = 1000000;
+	const string name = "bench.console";
+	const string msg = "console benchmark message with some text in it";
+
+	cout << "ConsoleOutputter to /dev/null, " << records << " records" << endl << endl;
+	cout << setw(10) << "mode" << setw(16) << "records/sec" << setw(14) << "ns/record" << endl;
+
+	const ConsoleOutputter::Mode modes[] = { ConsoleOutputter::Streams, ConsoleOutputter::Buffered };
+	const char *names[] = { "streams", "buffered" };
+	for (int m=0;m<2;++m)
+	{
+		ConsoleOutputter op;
+		op.setLayout(make_shared<StandardLayout>());
+		op.setMode(modes[m]);
+
+		// nothing is printed while stdout points at /dev/null
+		cout.flush();
+		int saved = dup(1);
+		int null = ::open("/dev/null", O_WRONLY);
+		dup2(null, 1);
+		::close(null);
+
+		auto start = steady_clock::now();
+		for (unsigned int i=0;i<records;++i)
+			op.writeLog(Level::info(), name, msg, Location());
+		op.close();
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+		dup2(saved, 1);
+		::close(saved);
+
+		cout << setw(10) << names[m] << setw(16) << fixed << setprecision(0) << (double)records * 1e9 / elapsed
+			<< setw(14) << setprecision(1) << (double)elapsed / records << endl;
+	}
+#else
+	cout << "The console benchmark needs POSIX dup2()" << endl;
+#endif
+	return 0;
+}
+
+int deferredBenchmark()
+{
+	// the queue holds every record so the callers never wait for the writer
+	const unsigned int records = 100000;
+	const string side = "buy";
+
+	cout << "Caller cost of 5 argument records to an AsyncOutputter, " << records << " records" << endl << endl;
+	cout << "the writer shares the cores with the caller, the median leaves out the calls it interrupted" << endl << endl;
+	cout << setw(10) << "api" << setw(14) << "mean ns" << setw(14) << "median ns" << setw(14) << "p99 ns" << endl;
+
+	const char *names[] = { "stream", "deferred" };
+	vector<long long> times(records);
+	for (int a=0;a<2;++a)
+	{
+		auto log = Logger::logger("bench.deferred");
+		auto aop = make_shared<AsyncOutputter>(make_shared<NullOutputter>(), records * 2);
+		log->addOutputter(aop);
+
+		for (unsigned int i=0;i<records;++i)
+		{
+			auto start = steady_clock::now();
+			if (a == 0)
+				LoggerStream(log, Level::info()) << "order " << i << " " << side << " at " << 100.25 + i << SHARKLOG_END;
+			else
+				SHARKLOG_DEFER_INFO(log, "order ", i, " ", side, " at ", 100.25 + i);
+			times[i] = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+		}
+		aop->close();
+
+		double total = 0;
+		for (auto it : times)
+			total += it;
+		sort(times.begin(), times.end());
+
+		cout << setw(10) << names[a] << setw(14) << fixed << setprecision(1) << total / records
+			<< setw(14) << times[records / 2] << setw(14) << times[records * 99 / 100] << endl;
+		Logger::closeRootLogger();
+	}
+
+	return 0;
+}
+
+int binaryBenchmark()
+{
+	const unsigned int records = 200000;
+	const string filename = "binary-benchmark.tmp";
+	const string side = "buy";
+
+	cout << "Text vs binary file records, " << records << " 3 argument records written on the calling thread" << endl << endl;
+	cout << setw(10) << "format" << setw(16) << "bytes/record" << setw(14) << "mean ns" << setw(14) << "median ns"
+		<< setw(14) << "p99 ns" << endl;
+
+	const char *names[] = { "text", "binary" };
+	vector<long long> times(records);
+	for (int b=0;b<2;++b)
+	{
+		OutputterPtr op;
+		if (b == 0)
+		{
+			op = make_shared<FileOutputter>(filename);
+			op->setLayout(make_shared<StandardLayout>());
+		}
+		else
+			op = make_shared<BinaryFileOutputter>(filename);
+		if (!op->open())
+		{
+			cout << "Failed to open file " << filename << endl;
+			return 1;
+		}
+
+		auto log = Logger::logger("bench.binary");
+		log->addOutputter(op);
+		for (unsigned int i=0;i<records;++i)
+		{
+			auto start = steady_clock::now();
+			if (b == 0)
+			{
+				SHARKLOG_DEFER_INFO(log, "order ", i, " ", side, " at ", 100.25 + i);
+			}
+			else
+			{
+				SHARKLOG_BINARY_INFO(log, "order {} {} at {}", i, side, 100.25 + i);
+			}
+			times[i] = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+		}
+		Logger::closeRootLogger();
+
+		ifstream f(filename, ios::binary | ios::ate);
+		double bytes = f.tellg();
+		f.close();
+		remove(filename.c_str());
+
+		double total = 0;
+		for (auto it : times)
+			total += it;
+		sort(times.begin(), times.end());
+
+		cout << setw(10) << names[b] << setw(16) << fixed << setprecision(1) << bytes / records
+			<< setw(14) << total / records << setw(14) << times[records / 2] << setw(14) << times[records * 99 / 100] << endl;
+	}
+
+	return 0;
+}
+
+int layoutBenchmark()
+{
+	const unsigned int records = 1000000;
+	const string name = "bench.layout";
+	const string msg = "layout benchmark message with some text in it";
+
+	// the PatternLayout equivalent of StandardLayout
+	const string pattern = "[%d{%m/%d/%Y][%H:%M:%S.%f}][%t][%c][%p] %m%n";
+	StandardLayout standard;
+	PatternLayout patterned(pattern);
+
+	cout << "Layout formatting, " << records << " records" << endl;
+	cout << "pattern: " << pattern << endl << endl;
+	cout << setw(10) << "layout" << setw(14) << "ns/record" << endl;
+
+	Layout *layouts[] = { &standard, &patterned };
+	const char *names[] = { "standard", "pattern" };
+	string outputs[2];
+	RecordContext ctx;
+	for (int l=0;l<2;++l)
+	{
+		string result;
+		auto start = steady_clock::now();
+		for (unsigned int i=0;i<records;++i)
+		{
+			result.clear();
+			layouts[l]->formatRecord(result, Level::info(), name, msg, Location());
+			sink_ += result.size();
+		}
+		auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+		// same record for both so the output can be compared
+		RecordContext::Scope pin(ctx);
+		layouts[l]->formatRecord(outputs[l], Level::info(), name, msg, Location());
+
+		cout << setw(10) << names[l] << setw(14) << fixed << setprecision(1) << (double)elapsed / records << endl;
+	}
+
+	cout << endl << "same output: " << (outputs[0] == outputs[1] ? "yes" : "no") << endl;
+	return 0;
+}
+
+unsigned int runtimeLoop(unsigned int iterations)
+{
+	auto log = Logger::logger("bench.strip");
+	unsigned int sum = 0;
+	for (unsigned int i=0;i<iterations;++i)
+	{
+		sum += i * 7;
+		SHARKLOG_DEBUG(log, "value " + to_string(sum));
+		SHARKLOG_TRACE(log, "iteration " + to_string(i));
+	}
+
+	return sum;
+}
+
+int stripBenchmark()
+{
+	const unsigned int iterations = 10000000;
+
+	// debug and trace are turned off at runtime so both loops log nothing
+	Logger::rootLogger()->setLevel(Level::info());
+
+	cout << "2 disabled SHARKLOG_* calls per iteration, " << iterations << " iterations" << endl << endl;
+	cout << setw(24) << "" << setw(14) << "ns/iter" << endl;
+
+	auto start = steady_clock::now();
+	sink_ += runtimeLoop(iterations);
+	auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+	cout << setw(24) << "runtime level check" << setw(14) << fixed << setprecision(2) << (double)elapsed / iterations << endl;
+
+	start = steady_clock::now();
+	sink_ += strippedLoop(iterations);
+	elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+	cout << setw(24) << "compiled out" << setw(14) << fixed << setprecision(2) << (double)elapsed / iterations << endl;
+
+	Logger::closeRootLogger();
+	return 0;
+}
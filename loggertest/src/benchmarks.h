@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __benchmarks_H
+#define __benchmarks_H
+
+/*!
+ * \file benchmarks.h
+ *
+ * Micro benchmarks run by loggertest.  Each one prints its results as a
+ * table to stdout and returns the exit code for loggertest.
+ */
+
+//! Logger::logger() lookup cost for 10 to 100k registered loggers
+int lookupBenchmark();
+
+//! Logger::log() throughput to no-op outputters with 1 to 32 logging threads
+int dispatchBenchmark();
+
+/*!
+ * FileOutputter throughput with 1 to 32 threads, each logging to its own file,
+ * shows how well writes to different files scale when nothing is shared.
+ */
+int fileScalingBenchmark();
+
+/*!
+ * FileOutputter (std::ofstream) vs RawFileOutputter (writev) vs
+ * MappedFileOutputter (mmap) throughput in
+ * MB/s and write system calls per 1M records.  The system calls come from
+ * /proc/self/io so they are only shown on Linux.
+ */
+int writeBenchmark();
+
+/*!
+ * ConsoleOutputter through std::cout vs \ref ConsoleOutputter::Buffered
+ * mode, with stdout sent to /dev/null while it runs.
+ */
+int consoleBenchmark();
+
+/*!
+ * Caller side cost of a five argument record logged to an AsyncOutputter,
+ * formatted with LoggerStream vs captured with SHARKLOG_DEFER_INFO.
+ */
+int deferredBenchmark();
+
+/*!
+ * File size per record and caller cost of the same record written as text
+ * (FileOutputter and StandardLayout) vs BinaryFileOutputter records from
+ * SHARKLOG_BINARY_INFO.
+ */
+int binaryBenchmark();
+
+//! StandardLayout vs the equivalent PatternLayout formatting cost per record
+int layoutBenchmark();
+
+/*!
+ * Cost of disabled SHARKLOG_DEBUG calls in a hot loop, checked at runtime vs
+ * compiled out with SHARKLOG_COMPILE_MIN_LEVEL.  The binary size difference
+ * shows up in `size` of a build configured with -DSHARKLOG_COMPILE_MIN_LEVEL=INFO.
+ */
+int stripBenchmark();
+
+//! the hot loop for stripBenchmark(), built with SHARKLOG_COMPILE_MIN_LEVEL=INFO
+unsigned int strippedLoop(unsigned int iterations);
+
+//! the hot loop for stripBenchmark(), built with the configured level
+unsigned int runtimeLoop(unsigned int iterations);
+
+#endif // benchmarks_H
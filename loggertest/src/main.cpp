@@ -29,6 +29,7 @@
 #include <thread>
 #include <sstream>
 #include <map>
+#include <mutex>
 #include <sharklog/logger.h>
 #include <sharklog/consoleoutputter.h>
 #include <sharklog/standardlayout.h>
@@ -36,11 +37,13 @@
 #include <sharklog/functrace.h>
 #include <sharklog/basicconfig.h>
 #include <sharklog/loggerstream.h>
+#include "benchmarks.h"
 
 using namespace std;
 using namespace sharklog;
 
 std::map<int, std::string> threadResults_;
+std::mutex threadResultsMutex_;
 
 void usage();
 int threadTest(const std::string &filename="");
@@ -73,13 +76,58 @@ int main(int ac, char **av)
 
         if (find(params.begin(), params.end(), "-ft") != params.end())
         {
-			return threadTest("file-thread-test.tmp");
+			auto res = threadTest("file-thread-test.tmp");
+			if (res)
+				return res;
+
+			cout << endl;
+			return fileScalingBenchmark();
         }
         
         if (find(params.begin(), params.end(), "-b") != params.end())
         {
             return basicTest();
         }
+        
+        if (find(params.begin(), params.end(), "-lb") != params.end())
+        {
+            return lookupBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-db") != params.end())
+        {
+            return dispatchBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-wb") != params.end())
+        {
+            return writeBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-cb") != params.end())
+        {
+            return consoleBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-ab") != params.end())
+        {
+            return deferredBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-bb") != params.end())
+        {
+            return binaryBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-fb") != params.end())
+        {
+            return layoutBenchmark();
+        }
+        
+        if (find(params.begin(), params.end(), "-sb") != params.end())
+        {
+            return stripBenchmark();
+        }
     }
 
 	return 0;
@@ -148,8 +196,18 @@ void usage()
     cout << endl;
     cout << "Tests:" << endl;
     cout << "   -t                     Run threading test" << endl;
-	cout << "   -ft                    Run threading test with files" << endl;
+	cout << "   -ft                    Run threading test with files, then multi-file scaling" << endl;
     cout << "   -b                     Basic logger test" << endl;
+    cout << endl;
+    cout << "Benchmarks:" << endl;
+    cout << "   -lb                    Logger lookup cost vs number of loggers" << endl;
+    cout << "   -db                    Logger::log() dispatch scaling, 1 to 32 threads" << endl;
+    cout << "   -wb                    File writes with std::ofstream, writev and mmap, MB/s and syscalls" << endl;
+    cout << "   -cb                    Console output through std::cout vs buffered write()" << endl;
+    cout << "   -ab                    Async caller cost, LoggerStream vs SHARKLOG_DEFER_INFO" << endl;
+    cout << "   -bb                    Text vs binary file records, bytes per record and caller cost" << endl;
+    cout << "   -fb                    StandardLayout vs PatternLayout cost per record" << endl;
+    cout << "   -sb                    Disabled log macros, runtime check vs compiled out" << endl;
     
     cout << endl;
 }
@@ -173,6 +231,7 @@ void run(int tnum)
     if (logs.size() != count)
     {
         result << "=======> FAILED VERIFY OF THREAD " << tnum << " expected " << count << " and logged " << logs.size() << endl;
+        lock_guard<mutex> lock(threadResultsMutex_);
         threadResults_[tnum] = result.str();
         return;
     }
@@ -185,13 +244,15 @@ void run(int tnum)
         if (it != ss.str())
         {
             result << "=======> FAILED VERIFY OF THREAD " << tnum << " item [" << it << "] and it should be [" << ss.str() << "]" << endl;
+            lock_guard<mutex> lock(threadResultsMutex_);
             threadResults_[tnum] = result.str();
             return;
         }
     }
     
     result << "=======> THREAD " << tnum << " OK" << endl;
-    threadResults_[tnum ] = result.str();
+    lock_guard<mutex> lock(threadResultsMutex_);
+    threadResults_[tnum] = result.str();
 }
 
 int threadTest(const std::string &filename)
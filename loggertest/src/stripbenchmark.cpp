@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// built as if configured with SHARKLOG_COMPILE_MIN_LEVEL=INFO so the
+// debug and trace macros below are compiled out
+#include <sharklog/sharklogdefs.h>
+#undef SHARKLOG_COMPILE_MIN_LEVEL
+#define SHARKLOG_COMPILE_MIN_LEVEL SHARKLOG_LEVEL_INFO
+
+#include "benchmarks.h"
+#include <sharklog/logger.h>
+#include <string>
+
+using namespace std;
+using namespace sharklog;
+
+unsigned int strippedLoop(unsigned int iterations)
+{
+	auto log = Logger::logger("bench.strip");
+	unsigned int sum = 0;
+	for (unsigned int i=0;i<iterations;++i)
+	{
+		sum += i * 7;
+		SHARKLOG_DEBUG(log, "value " + to_string(sum));
+		SHARKLOG_TRACE(log, "iteration " + to_string(i));
+	}
+
+	return sum;
+}
@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "standardlayout.h"
+#include "recordcontext.h"
+#include "deferredmessage.h"
+#include "loggerstream.h"
+#include "logger.h"
+#include "outputter.h"
+#include "level.h"
+#include <string>
+#include <new>
+#include <cstdlib>
+
+using namespace sharklog;
+using namespace std;
+
+// counts allocations made by the current thread while counting_ is set
+namespace
+{
+	thread_local bool counting_ = false;
+	thread_local unsigned int allocations_ = 0;
+}
+
+void *operator new(std::size_t size)
+{
+	if (counting_)
+		++allocations_;
+
+	if (void *p = malloc(size ? size : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	// keeps the size of the last message, nothing else
+	class SizeOutputter : public Outputter
+	{
+	public:
+		bool open() override { return true; }
+		void writeLog(const Level &, const std::string &, const std::string &msg, const Location &) override { size_ = msg.size(); }
+		void close() override { }
+		bool isOpen() const override { return true; }
+		bool isValid() const override { return true; }
+
+		std::size_t size_ = 0;
+	};
+
+	class AllocationTest : public ::testing::Test
+	{
+	protected:
+		void startCounting()
+		{
+			allocations_ = 0;
+			counting_ = true;
+		}
+
+		unsigned int stopCounting()
+		{
+			counting_ = false;
+			return allocations_;
+		}
+
+		void format(StandardLayout &layout, string &result, const Level &lev, const string &name, const string &msg)
+		{
+			result.clear();
+			layout.appendHeader(result);
+			layout.formatMessage(result, lev, name, msg);
+			layout.appendFooter(result);
+		}
+	};
+}
+
+TEST_F(AllocationTest, CountingWorks)
+{
+	startCounting();
+	auto p = new int(5);
+	delete p;
+	ASSERT_EQ(1, stopCounting());
+}
+
+TEST_F(AllocationTest, StandardLayoutDoesNotAllocateAfterWarmUp)
+{
+	StandardLayout layout;
+	string result;
+	const string name = "com.sharklog.allocation";
+	const string msg = "a message that is longer than any small string buffer";
+	format(layout, result, Level::info(), name, msg);
+
+	startCounting();
+	for (int i=0;i<1000;++i)
+		format(layout, result, Level::info(), name, msg);
+	ASSERT_EQ(0, stopCounting());
+}
+
+TEST_F(AllocationTest, StandardLayoutDoesNotAllocateForPinnedRecords)
+{
+	StandardLayout layout;
+	string result;
+	const string name = "com.sharklog.allocation";
+	const string msg = "a message that is longer than any small string buffer";
+	RecordContext first;
+	{
+		RecordContext::Scope pin(first);
+		format(layout, result, Level::debug(), name, msg);
+	}
+
+	// records from another second and level, formatted the way AsyncOutputter does
+	RecordContext later(first.time() + std::chrono::seconds(5), first.threadId());
+	startCounting();
+	for (int i=0;i<1000;++i)
+	{
+		RecordContext::Scope pin(i % 2 ? first : later);
+		format(layout, result, i % 2 ? Level::warn() : Level::fatal(), name, msg);
+	}
+	ASSERT_EQ(0, stopCounting());
+}
+
+TEST_F(AllocationTest, DeferredMessageCaptureDoesNotAllocate)
+{
+	const string name = "a std::string longer than any small string buffer";
+	DeferredMessage copy;
+
+	startCounting();
+	for (int i=0;i<1000;++i)
+	{
+		DeferredMessage msg;
+		msg.capture("order ", i, " filled ", 2.5 * i, " for ", name);
+		copy = msg;
+	}
+	ASSERT_EQ(0, stopCounting());
+}
+
+TEST_F(AllocationTest, LoggerStreamDoesNotAllocateAfterWarmUp)
+{
+	auto log = Logger::logger("allocation.stream");
+	auto op = make_shared<SizeOutputter>();
+	log->addOutputter(op);
+	const string name = "a std::string longer than any small string buffer";
+
+	// one record in 64 is timed, warm that up too
+	for (int i=0;i<64;++i)
+		LoggerStream(log, Level::info()) << "order " << 1000 << " filled " << 2500.5 << " for " << name << SHARKLOG_END;
+
+	startCounting();
+	for (int i=0;i<1000;++i)
+		LoggerStream(log, Level::info()) << "order " << i << " filled " << 2.5 * i << " for " << name << SHARKLOG_END;
+	auto allocations = stopCounting();
+
+	Logger::closeRootLogger();
+	EXPECT_LT(50u, op->size_);
+	ASSERT_EQ(0, allocations);
+}
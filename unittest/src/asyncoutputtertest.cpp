@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "logger.h"
+#include "standardlayout.h"
+#include "asyncoutputter.h"
+#include "asyncoutputtertest.h"
+#include <sstream>
+
+using namespace sharklog;
+using namespace std;
+
+TEST_F(AsyncOutputterTest, CapacityIsRoundedToPowerOfTwo)
+{
+    AsyncOutputter aop(recorder_, 1000);
+    ASSERT_EQ(1024, aop.capacity());
+}
+
+TEST_F(AsyncOutputterTest, DefaultCapacity)
+{
+    AsyncOutputter aop(recorder_);
+    ASSERT_EQ(AsyncOutputter::DefaultCapacity, aop.capacity());
+}
+
+TEST_F(AsyncOutputterTest, ValidityComesFromWrappedOutputter)
+{
+    AsyncOutputter aop(recorder_);
+    EXPECT_TRUE(aop.isValid());
+
+    recorder_->setLayout(LayoutPtr());
+    ASSERT_FALSE(aop.isValid());
+}
+
+TEST_F(AsyncOutputterTest, IsOpenAfterConstruction)
+{
+    AsyncOutputter aop(recorder_);
+    ASSERT_TRUE(aop.isOpen());
+}
+
+TEST_F(AsyncOutputterTest, FlushWritesEverything)
+{
+    AsyncOutputter aop(recorder_, 64);
+    for (int i=0;i<1000;++i)
+        aop.writeLog(Level::info(), "test", to_string(i), Location());
+    aop.flush();
+
+    ASSERT_EQ(1000, recorder_->count());
+    for (int i=0;i<1000;++i)
+        ASSERT_EQ(to_string(i), recorder_->messages_[i]);
+}
+
+TEST_F(AsyncOutputterTest, WritesOnWriterThread)
+{
+    AsyncOutputter aop(recorder_);
+    aop.writeLog(Level::info(), "test", "x", Location());
+    aop.flush();
+
+    ASSERT_EQ(1, recorder_->count());
+    ASSERT_NE(this_thread::get_id(), recorder_->writers_.front());
+}
+
+TEST_F(AsyncOutputterTest, RecordKeepsLoggingThreadAndTime)
+{
+    AsyncOutputter aop(recorder_);
+    recorder_->delay_ = 20;
+
+    auto before = RecordContext::Clock::now();
+    aop.writeLog(Level::info(), "test", "x", Location());
+    aop.flush();
+
+    ASSERT_EQ(1, recorder_->count());
+    EXPECT_EQ(this_thread::get_id(), recorder_->contexts_.front().threadId());
+    ASSERT_LT(recorder_->contexts_.front().time() - before, chrono::milliseconds(20));
+}
+
+TEST_F(AsyncOutputterTest, CloseDrainsQueue)
+{
+    AsyncOutputter aop(recorder_);
+    recorder_->delay_ = 1;
+    for (int i=0;i<50;++i)
+        aop.writeLog(Level::info(), "test", "x", Location());
+    aop.close();
+
+    EXPECT_EQ(50, recorder_->count());
+    EXPECT_FALSE(aop.isOpen());
+    ASSERT_FALSE(recorder_->isOpen());
+}
+
+TEST_F(AsyncOutputterTest, WritesDirectlyWhenClosed)
+{
+    AsyncOutputter aop(recorder_);
+    aop.close();
+    aop.writeLog(Level::info(), "test", "x", Location());
+
+    ASSERT_EQ(1, recorder_->count());
+    ASSERT_EQ(this_thread::get_id(), recorder_->writers_.front());
+}
+
+TEST_F(AsyncOutputterTest, ReopenRestartsWriter)
+{
+    AsyncOutputter aop(recorder_);
+    aop.close();
+    EXPECT_TRUE(aop.open());
+    EXPECT_TRUE(aop.isOpen());
+
+    aop.writeLog(Level::info(), "test", "x", Location());
+    aop.flush();
+    ASSERT_NE(this_thread::get_id(), recorder_->writers_.front());
+}
+
+TEST_F(AsyncOutputterTest, ManyThreadsLoseNothing)
+{
+    AsyncOutputter aop(recorder_, 128);
+
+    vector<thread> threads;
+    for (int t=0;t<8;++t)
+    {
+        threads.push_back(thread([&aop, t] {
+            for (int i=0;i<1000;++i)
+            {
+                stringstream ss;
+                ss << t << ":" << i;
+                aop.writeLog(Level::info(), "test", ss.str(), Location());
+            }
+        }));
+    }
+
+    for (auto &it : threads)
+        it.join();
+    aop.flush();
+
+    ASSERT_EQ(8000, recorder_->count());
+
+    // each thread's messages stay in order
+    vector<int> next(8, 0);
+    for (auto &msg : recorder_->messages_)
+    {
+        auto pos = msg.find(':');
+        auto t = stoi(msg.substr(0, pos));
+        ASSERT_EQ(next[t]++, stoi(msg.substr(pos + 1)));
+    }
+}
+
+TEST_F(AsyncOutputterTest, CloseWhileLoggingLosesNothing)
+{
+    AsyncOutputter aop(recorder_, 16);
+
+    // records pushed as close() stops the writer are written by close(), the
+    // ones after it by the logging thread
+    atomic<int> started(0);
+    vector<thread> threads;
+    for (int t=0;t<4;++t)
+    {
+        threads.push_back(thread([&aop, &started] {
+            ++started;
+            for (int i=0;i<2000;++i)
+                aop.writeLog(Level::info(), "test", "x", Location());
+        }));
+    }
+
+    while (started < 4)
+        this_thread::yield();
+    aop.close();
+
+    for (auto &it : threads)
+        it.join();
+    ASSERT_EQ(8000, recorder_->count());
+}
+
+TEST_F(AsyncOutputterTest, LoggerWritesThroughAsync)
+{
+    auto aop = make_shared<AsyncOutputter>(recorder_);
+    Logger::rootLogger()->addOutputter(aop);
+    EXPECT_TRUE(Logger::rootLogger()->isValid());
+
+    SHARKLOG_INFO(Logger::rootLogger(), "hello");
+    aop->flush();
+
+    ASSERT_EQ(1, recorder_->count());
+    ASSERT_EQ("hello", recorder_->messages_.front());
+}
+
+TEST_F(AsyncOutputterTest, CloseRootLoggerClosesAsync)
+{
+    auto aop = make_shared<AsyncOutputter>(recorder_);
+    Logger::rootLogger()->addOutputter(aop);
+    recorder_->delay_ = 1;
+    for (int i=0;i<20;++i)
+        Logger::rootLogger()->log(Level::info(), "x");
+
+    Logger::closeRootLogger();
+
+    EXPECT_FALSE(aop->isOpen());
+    ASSERT_EQ(20, recorder_->count());
+}
+
+TEST_F(AsyncOutputterTest, DefaultPolicyIsBlock)
+{
+    AsyncOutputter aop(recorder_);
+    ASSERT_EQ(AsyncOutputter::Block, aop.overflowPolicy());
+}
+
+TEST_F(AsyncOutputterTest, SetOverflowPolicyWorks)
+{
+    AsyncOutputter aop(recorder_);
+    aop.setOverflowPolicy(AsyncOutputter::DropBelowLevel, Level::info());
+    EXPECT_EQ(AsyncOutputter::DropBelowLevel, aop.overflowPolicy());
+    ASSERT_TRUE(aop.dropThreshold() == Level::info());
+}
+
+TEST_F(AsyncOutputterTest, BlockLosesNothing)
+{
+    AsyncOutputter aop(recorder_, 4);
+    recorder_->delay_ = 1;
+    for (int i=0;i<50;++i)
+        aop.writeLog(Level::debug(), "test", to_string(i), Location());
+    aop.flush();
+
+    EXPECT_EQ(0, aop.droppedCount());
+    ASSERT_EQ(50, recorder_->count());
+}
+
+TEST_F(AsyncOutputterTest, DropNewestKeepsOldest)
+{
+    AsyncOutputter aop(recorder_, 4);
+    aop.setOverflowPolicy(AsyncOutputter::DropNewest);
+    aop.setDropReportInterval(0);
+
+    stallWriter(aop);
+    for (int i=0;i<20;++i)
+        aop.writeLog(Level::info(), "test", to_string(i), Location());
+    releaseWriter(aop);
+
+    EXPECT_GT(aop.droppedCount(Level::info()), 0);
+    EXPECT_EQ(aop.droppedCount(), aop.droppedCount(Level::info()));
+    ASSERT_EQ(21 - aop.droppedCount(), recorder_->count());
+
+    // the first messages made it
+    for (std::size_t i=1;i<recorder_->count();++i)
+        ASSERT_EQ(to_string(i - 1), recorder_->messages_[i]);
+}
+
+TEST_F(AsyncOutputterTest, DropOldestKeepsNewest)
+{
+    AsyncOutputter aop(recorder_, 4);
+    aop.setOverflowPolicy(AsyncOutputter::DropOldest);
+    aop.setDropReportInterval(0);
+
+    stallWriter(aop);
+    for (int i=0;i<20;++i)
+        aop.writeLog(Level::info(), "test", to_string(i), Location());
+    releaseWriter(aop);
+
+    EXPECT_GT(aop.droppedCount(Level::info()), 0);
+    ASSERT_EQ(21 - aop.droppedCount(), recorder_->count());
+    ASSERT_EQ("19", recorder_->messages_.back());
+}
+
+TEST_F(AsyncOutputterTest, DropBelowLevelKeepsSevereMessages)
+{
+    AsyncOutputter aop(recorder_, 4);
+    aop.setOverflowPolicy(AsyncOutputter::DropBelowLevel, Level::warn());
+    aop.setDropReportInterval(0);
+
+    stallWriter(aop);
+    for (int i=0;i<20;++i)
+        aop.writeLog(Level::debug(), "test", "debug", Location());
+
+    // the queue is full so these wait on the writer
+    thread severe([&aop] {
+        aop.writeLog(Level::warn(), "test", "warn", Location());
+        aop.writeLog(Level::error(), "test", "error", Location());
+    });
+    releaseWriter(aop);
+    severe.join();
+    aop.flush();
+
+    EXPECT_GT(aop.droppedCount(Level::debug()), 0);
+    EXPECT_EQ(0, aop.droppedCount(Level::warn()));
+    EXPECT_EQ(0, aop.droppedCount(Level::error()));
+    EXPECT_EQ("warn", recorder_->messages_[recorder_->count() - 2]);
+    ASSERT_EQ("error", recorder_->messages_.back());
+}
+
+TEST_F(AsyncOutputterTest, DropBelowLevelNeverDropsErrors)
+{
+    AsyncOutputter aop(recorder_, 4);
+    aop.setOverflowPolicy(AsyncOutputter::DropBelowLevel, Level::fatal());
+    aop.setDropReportInterval(0);
+
+    stallWriter(aop);
+    for (int i=0;i<3;++i)
+        aop.writeLog(Level::info(), "test", "info", Location());
+
+    thread severe([&aop] {
+        aop.writeLog(Level::error(), "test", "error", Location());
+    });
+    releaseWriter(aop);
+    severe.join();
+    aop.flush();
+
+    EXPECT_EQ(0, aop.droppedCount(Level::error()));
+    ASSERT_EQ("error", recorder_->messages_.back());
+}
+
+TEST_F(AsyncOutputterTest, DroppedMessagesAreReported)
+{
+    AsyncOutputter aop(recorder_, 4);
+    aop.setOverflowPolicy(AsyncOutputter::DropNewest);
+    aop.setDropReportInterval(10);
+
+    stallWriter(aop);
+    for (int i=0;i<20;++i)
+        aop.writeLog(Level::debug(), "test", "x", Location());
+    releaseWriter(aop);
+
+    auto dropped = aop.droppedCount();
+    EXPECT_GT(dropped, 0);
+
+    // give the writer a chance to report
+    for (int i=0;i<100;++i)
+    {
+        if (recorder_->count() == 22 - dropped)
+            break;
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+
+    lock_guard<mutex> lock(recorder_->mutex_);
+    ASSERT_EQ(22 - dropped, recorder_->messages_.size());
+    EXPECT_TRUE(recorder_->levels_.back() == Level::warn());
+    ASSERT_NE(string::npos, recorder_->messages_.back().find("dropped " + to_string(dropped)));
+    ASSERT_NE(string::npos, recorder_->messages_.back().find("DEBUG=" + to_string(dropped)));
+}
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __asyncoutputtertest_H
+#define __asyncoutputtertest_H
+
+#include <gtest/gtest.h>
+#include <sharklog/outputter.h>
+#include <sharklog/location.h>
+#include <sharklog/level.h>
+#include <sharklog/recordcontext.h>
+#include <sharklog/standardlayout.h>
+#include <sharklog/logger.h>
+#include <sharklog/asyncoutputter.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+// keeps every message it is sent along with where/when it was logged
+class RecordingOutputter : public sharklog::Outputter
+{
+public:
+    RecordingOutputter() : open_(true), delay_(0), arrived_(0) { }
+
+    bool open() final { open_ = true; return true; }
+    void close() final { open_ = false; }
+    bool isOpen() const final { return open_; }
+
+    void writeLog(const sharklog::Level &lev, const std::string &logName, const std::string &logMessage, const sharklog::Location &loc) final
+    {
+        // tests hold the gate to stall the writer
+        ++arrived_;
+        std::lock_guard<std::mutex> gate(gate_);
+
+        if (delay_)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        messages_.push_back(logMessage);
+        levels_.push_back(lev);
+        contexts_.push_back(sharklog::RecordContext::current());
+        writers_.push_back(std::this_thread::get_id());
+    }
+
+    std::size_t count()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return messages_.size();
+    }
+
+    bool open_;
+    int delay_;
+    std::atomic<int> arrived_;
+    std::mutex gate_;
+    std::mutex mutex_;
+    std::vector<std::string> messages_;
+    std::vector<sharklog::Level> levels_;
+    std::vector<sharklog::RecordContext> contexts_;
+    std::vector<std::thread::id> writers_;
+};
+
+class AsyncOutputterTest : public ::testing::Test
+{
+protected:
+    AsyncOutputterTest()
+    {
+    }
+
+    virtual ~AsyncOutputterTest()
+    {
+    }
+
+    void SetUp()
+    {
+        recorder_ = std::make_shared<RecordingOutputter>();
+        recorder_->setLayout(std::make_shared<sharklog::StandardLayout>());
+    }
+
+    void TearDown()
+    {
+        sharklog::Logger::closeRootLogger();
+    }
+
+    // stalls the writer inside writeLog with its first message
+    void stallWriter(sharklog::AsyncOutputter &aop)
+    {
+        recorder_->gate_.lock();
+        aop.writeLog(sharklog::Level::info(), "test", "stalled", sharklog::Location());
+        while (!recorder_->arrived_)
+            std::this_thread::yield();
+    }
+
+    void releaseWriter(sharklog::AsyncOutputter &aop)
+    {
+        recorder_->gate_.unlock();
+        aop.flush();
+    }
+
+    std::shared_ptr<RecordingOutputter> recorder_;
+};
+
+#endif // asyncoutputtertest_H
@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "fileoutputtertest.h"
+#include "binaryfileoutputter.h"
+#include "binarylogreader.h"
+#include "asyncoutputter.h"
+#include "patternlayout.h"
+#include "standardlayout.h"
+#include "logger.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+class BinaryFileOutputterTest : public OutputFileTest
+{
+protected:
+	BinaryFileOutputterTest() : OutputFileTest("test-binaryfile-82714.tmp") { }
+
+	void TearDown() override
+	{
+		Logger::closeRootLogger();
+		OutputFileTest::TearDown();
+	}
+
+	std::vector<BinaryLogReader::Record> readAll()
+	{
+		std::vector<BinaryLogReader::Record> records;
+		BinaryLogReader::Record rec;
+		EXPECT_TRUE(reader_.open()) << reader_.error();
+		while (reader_.next(rec))
+			records.push_back(rec);
+		EXPECT_EQ("", reader_.error());
+		return records;
+	}
+
+	// formats rec the way the decoder does
+	std::string decoded(const BinaryLogReader::Record &rec, Layout &layout)
+	{
+		string text;
+		RecordContext::Scope pin(rec.context);
+		layout.formatRecord(text, rec.level, rec.loggerName, rec.message, rec.location);
+		return text;
+	}
+
+	LoggerPtr setup(const std::string &name)
+	{
+		bop_ = make_shared<BinaryFileOutputter>(filename_);
+		EXPECT_TRUE(bop_->open());
+		auto log = Logger::logger(name);
+		log->addOutputter(bop_);
+		return log;
+	}
+
+	std::shared_ptr<BinaryFileOutputter> bop_;
+	BinaryLogReader reader_ { filename_ };
+};
+
+TEST_F(BinaryFileOutputterTest, Defaults)
+{
+	BinaryFileOutputter bop("test");
+	EXPECT_EQ("test", bop.filename());
+	EXPECT_FALSE(bop.isOpen());
+	EXPECT_TRUE(bop.isValid());
+	ASSERT_EQ(Level::ERROR, bop.flushLevel().level());
+}
+
+TEST_F(BinaryFileOutputterTest, OpenWritesTheHeader)
+{
+	BinaryFileOutputter bop(filename_);
+	EXPECT_TRUE(bop.open());
+	EXPECT_TRUE(bop.isOpen());
+	bop.close();
+	EXPECT_FALSE(bop.isOpen());
+
+	auto data = contents();
+	ASSERT_EQ(sizeof(BinaryFileOutputter::Magic) + 7, data.size());
+	EXPECT_EQ(string(BinaryFileOutputter::Magic, sizeof(BinaryFileOutputter::Magic)), data.substr(0, 8));
+	ASSERT_TRUE(readAll().empty());
+}
+
+TEST_F(BinaryFileOutputterTest, OpenFailsForBadPath)
+{
+	BinaryFileOutputter bop("/nonexistent-dir-3345/file.slb");
+	EXPECT_FALSE(bop.open());
+	ASSERT_FALSE(bop.isOpen());
+}
+
+TEST_F(BinaryFileOutputterTest, RecordsReadBack)
+{
+	auto log = setup("binary.read");
+	const string text = "string";
+	const char *cstr = "cstring";
+
+	auto before = RecordContext::Clock::now();
+	SHARKLOG_BINARY_INFO(log, "order {} filled {} at {}", 42, text, 1.5); auto line = __LINE__;
+	SHARKLOG_BINARY_WARN(log, "no arguments");
+	SHARKLOG_BINARY_ERROR(log, "{} and {}", cstr, 'c');
+	SHARKLOG_INFO(log, "plain " + text);
+	SHARKLOG_DEFER_DEBUG(log, "deferred ", -7, " ", true);
+	auto after = RecordContext::Clock::now();
+	bop_->close();
+
+	auto records = readAll();
+	ASSERT_EQ(5, records.size());
+	EXPECT_EQ("order 42 filled string at 1.5", records[0].message);
+	EXPECT_EQ("no arguments", records[1].message);
+	EXPECT_EQ("cstring and c", records[2].message);
+	EXPECT_EQ("plain string", records[3].message);
+	EXPECT_EQ("deferred -7 1", records[4].message);
+
+	EXPECT_EQ(Level::INFO, records[0].level.level());
+	EXPECT_EQ(Level::WARN, records[1].level.level());
+	EXPECT_EQ(Level::ERROR, records[2].level.level());
+	EXPECT_EQ(Level::INFO, records[3].level.level());
+	EXPECT_EQ(Level::DEBUG, records[4].level.level());
+
+	ostringstream thread;
+	thread << "0x" << hex << this_thread::get_id();
+	for (auto &rec : records)
+	{
+		EXPECT_EQ("binary.read", rec.loggerName);
+		EXPECT_EQ(thread.str(), rec.context.threadLabel());
+		EXPECT_LE(before, rec.context.time());
+		EXPECT_GE(after, rec.context.time());
+		EXPECT_NE(string::npos, string(rec.location.file()).find("binaryfileoutputtertest.cpp"));
+	}
+	EXPECT_EQ(line, records[0].location.line());
+	ASSERT_EQ(line + 3, records[3].location.line());
+}
+
+TEST_F(BinaryFileOutputterTest, DecodesToTheSameText)
+{
+	auto log = setup("binary.text");
+	RecordContext ctx;
+	{
+		RecordContext::Scope pin(ctx);
+		SHARKLOG_BINARY_INFO(log, "value {} of {}", 42, "x");
+	}
+	bop_->close();
+
+	auto records = readAll();
+	ASSERT_EQ(1, records.size());
+	auto &rec = records[0];
+
+	// what the text path gives for the same record and context
+	PatternLayout pattern("%d{%H:%M:%S.%f} %-5p [%t] %c %F:%L %M - %m%n");
+	StandardLayout standard;
+	for (auto layout : { (Layout *)&pattern, (Layout *)&standard })
+	{
+		string expected;
+		{
+			RecordContext::Scope pin(ctx);
+			layout->formatRecord(expected, Level::info(), log->name(), "value 42 of x", rec.location);
+		}
+		EXPECT_EQ(expected, decoded(rec, *layout));
+	}
+}
+
+TEST_F(BinaryFileOutputterTest, DefinitionsAreWrittenOnce)
+{
+	auto log = setup("binary.once");
+	vector<size_t> sizes;
+	for (int i=0;i<3;++i)
+	{
+		SHARKLOG_BINARY_INFO(log, "a fairly long format string so the definition shows {}", i);
+		bop_->flush();
+		sizes.push_back(contents().size());
+	}
+	bop_->close();
+
+	// the second and third records are the same size, smaller than the first
+	EXPECT_EQ(sizes[2] - sizes[1], sizes[1] - sizes[0]);
+	EXPECT_GT(sizes[0], 2 * (sizes[1] - sizes[0]));
+	ASSERT_EQ(3, readAll().size());
+}
+
+TEST_F(BinaryFileOutputterTest, ThreadsAreKept)
+{
+	auto log = setup("binary.threads");
+	vector<string> ids(4);
+	vector<thread> threads;
+	for (size_t t=0;t<ids.size();++t)
+	{
+		threads.emplace_back([&, t]() {
+			ostringstream ss;
+			ss << "0x" << hex << this_thread::get_id();
+			ids[t] = ss.str();
+			for (int i=0;i<100;++i)
+				SHARKLOG_BINARY_INFO(log, "thread {} record {}", t, i);
+		});
+	}
+	for (auto &t : threads)
+		t.join();
+	bop_->close();
+
+	auto records = readAll();
+	ASSERT_EQ(400, records.size());
+	vector<int> next(ids.size(), 0);
+	for (auto &rec : records)
+	{
+		auto t = rec.message[7] - '0';
+		ASSERT_EQ("thread " + to_string(t) + " record " + to_string(next[t]), rec.message);
+		ASSERT_EQ(ids[t], rec.context.threadLabel());
+		++next[t];
+	}
+}
+
+TEST_F(BinaryFileOutputterTest, AsyncKeepsTheArguments)
+{
+	bop_ = make_shared<BinaryFileOutputter>(filename_);
+	auto aop = make_shared<AsyncOutputter>(bop_);
+	ASSERT_TRUE(aop->open());
+	auto log = Logger::logger("binary.async");
+	log->addOutputter(aop);
+
+	ostringstream thread;
+	thread << "0x" << hex << this_thread::get_id();
+	for (int i=0;i<10;++i)
+		SHARKLOG_BINARY_INFO(log, "async {}", i);
+	aop->close();
+
+	auto records = readAll();
+	ASSERT_EQ(10, records.size());
+	for (int i=0;i<10;++i)
+	{
+		EXPECT_EQ("async " + to_string(i), records[i].message);
+		EXPECT_EQ(thread.str(), records[i].context.threadLabel());
+	}
+}
+
+TEST_F(BinaryFileOutputterTest, ReaderRejectsOtherFiles)
+{
+	{
+		ofstream f(filename_);
+		f << "this is a text log" << endl;
+	}
+	EXPECT_FALSE(reader_.open());
+	EXPECT_EQ("not a binary log file", reader_.error());
+
+	BinaryLogReader missing("/nonexistent-dir-3345/file.slb");
+	EXPECT_FALSE(missing.open());
+	ASSERT_FALSE(missing.error().empty());
+}
+
+TEST_F(BinaryFileOutputterTest, ReaderStopsAtDamage)
+{
+	auto log = setup("binary.damage");
+	SHARKLOG_BINARY_INFO(log, "first {}", 1);
+	SHARKLOG_BINARY_INFO(log, "second {}", 2);
+	bop_->close();
+
+	// cut the last record short
+	auto data = contents();
+	{
+		ofstream f(filename_, ios::binary | ios::trunc);
+		f.write(data.data(), data.size() - 3);
+	}
+
+	BinaryLogReader::Record rec;
+	ASSERT_TRUE(reader_.open());
+	EXPECT_TRUE(reader_.next(rec));
+	EXPECT_EQ("first 1", rec.message);
+	EXPECT_FALSE(reader_.next(rec));
+	ASSERT_EQ("a record is cut short", reader_.error());
+}
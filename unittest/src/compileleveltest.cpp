@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// everything in this file is built as if the library was configured with
+// SHARKLOG_COMPILE_MIN_LEVEL=WARN, the rest of the tests use the default
+#include <sharklog/sharklogdefs.h>
+#undef SHARKLOG_COMPILE_MIN_LEVEL
+#define SHARKLOG_COMPILE_MIN_LEVEL SHARKLOG_LEVEL_WARN
+
+#include <gtest/gtest.h>
+#include "logger.h"
+#include "functrace.h"
+#include "scopetimer.h"
+#include "loggertest.h"
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	class CompileLevelTest : public LoggerTest
+	{
+	protected:
+		void SetUp() override
+		{
+			op_ = make_shared<CountingOutputter>();
+			Logger::rootLogger()->addOutputter(op_);
+		}
+
+		// counts how many times a macro argument was evaluated
+		string message()
+		{
+			++evaluated_;
+			return "test";
+		}
+
+		LoggerPtr logger()
+		{
+			++evaluated_;
+			return Logger::rootLogger();
+		}
+
+		void trace()
+		{
+			SHARKLOG_FUNCTRACE(logger());
+		}
+
+		void traceRoot()
+		{
+			SHARKLOG_FUNCTRACE_ROOT;
+		}
+
+		shared_ptr<CountingOutputter> op_;
+		int evaluated_ = 0;
+	};
+}
+
+TEST_F(CompileLevelTest, StrippedMacrosDoNotLog)
+{
+	SHARKLOG_INFO(Logger::rootLogger(), "test");
+	SHARKLOG_TRACE(Logger::rootLogger(), "test");
+	SHARKLOG_DEBUG(Logger::rootLogger(), "test");
+	ASSERT_EQ(0, op_->count_.load());
+}
+
+TEST_F(CompileLevelTest, StrippedMacrosDoNotEvaluateArguments)
+{
+	SHARKLOG_INFO(logger(), message());
+	SHARKLOG_TRACE(logger(), message());
+	SHARKLOG_DEBUG(logger(), message());
+	ASSERT_EQ(0, evaluated_);
+}
+
+TEST_F(CompileLevelTest, StrippedFuncTraceDoesNotLog)
+{
+	trace();
+	traceRoot();
+	EXPECT_EQ(0, evaluated_);
+	ASSERT_EQ(0, op_->count_.load());
+}
+
+TEST_F(CompileLevelTest, StrippedScopeTimerIsNotRegistered)
+{
+	Logger::rootLogger()->setLevel(Level::all());
+	{
+		SHARKLOG_SCOPE_TIMER(logger(), "compilelevel.stripped");
+	}
+	EXPECT_EQ(0, evaluated_);
+	for (auto scope : ScopeStats::all())
+		EXPECT_NE("compilelevel.stripped", scope->name());
+}
+
+TEST_F(CompileLevelTest, MacrosAtMinLevelStillLog)
+{
+	SHARKLOG_WARN(Logger::rootLogger(), message());
+	SHARKLOG_ERROR(Logger::rootLogger(), message());
+	SHARKLOG_FATAL(Logger::rootLogger(), message());
+	EXPECT_EQ(3, evaluated_);
+	ASSERT_EQ(3, op_->count_.load());
+}
+
+TEST_F(CompileLevelTest, LogCallsAreNotStripped)
+{
+	EXPECT_TRUE(Logger::rootLogger()->log(Level::debug(), "test"));
+	ASSERT_EQ(1, op_->count_.load());
+}
+
+TEST_F(CompileLevelTest, StrippedMacroIsAStatement)
+{
+	if (op_)
+		SHARKLOG_DEBUG(logger(), message())
+	else
+		SHARKLOG_DEBUG(logger(), message())
+
+	ASSERT_EQ(0, evaluated_);
+}
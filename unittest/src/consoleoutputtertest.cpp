@@ -24,8 +24,53 @@
 
 #include "consoleoutputtertest.h"
 #include "consoleoutputter.h"
+#include "fileoutputtertest.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 using namespace sharklog;
+using namespace std;
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+void ConsoleOutputterTest::capture(int fd)
+{
+	cout.flush();
+	cerr.flush();
+	fflush(nullptr);
+
+	fd_ = fd;
+	saved_ = dup(fd);
+	int file = open(filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	dup2(file, fd);
+	close(file);
+}
+
+void ConsoleOutputterTest::restore()
+{
+	if (saved_ < 0)
+		return;
+
+	dup2(saved_, fd_);
+	close(saved_);
+	saved_ = -1;
+}
+
+std::string ConsoleOutputterTest::captured()
+{
+	ifstream f(filename_, ios::binary);
+	return string(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+}
+
+#endif
 
 TEST_F(ConsoleOutputterTest, OpenIsTrue)
 {
@@ -54,3 +99,170 @@ TEST_F(ConsoleOutputterTest, SetUseStdErrWorks)
     co.setUseStdErr(true);
     ASSERT_TRUE(co.useStdErr());
 }
+
+TEST_F(ConsoleOutputterTest, BufferedDefaults)
+{
+    ConsoleOutputter co;
+    EXPECT_EQ(ConsoleOutputter::Streams, co.mode());
+    EXPECT_EQ(ConsoleOutputter::AutoBuffering, co.buffering());
+    EXPECT_EQ(ConsoleOutputter::DefaultBufferSize, co.bufferSize());
+    EXPECT_EQ(ConsoleOutputter::DefaultFlushInterval, co.flushInterval());
+    ASSERT_EQ(Level::ERROR, co.flushLevel().level());
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+TEST_F(ConsoleOutputterTest, BufferedWaitsForFlush)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+    co.setFlushInterval(0);
+
+    co.writeLog(Level::info(), "", "one\n", Location());
+    co.writeLog(Level::info(), "", "two\n", Location());
+    EXPECT_EQ("", captured());
+
+    co.flush();
+    EXPECT_EQ("one\ntwo\n", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, BufferedWritesWhenFull)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+    co.setBufferSize(10);
+
+    for (int i=0;i<3;++i)
+        co.writeLog(Level::info(), "", "abcd\n", Location());
+    EXPECT_EQ("abcd\nabcd\n", captured());
+
+    co.close();
+    EXPECT_EQ("abcd\nabcd\nabcd\n", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, LineBufferingWritesEachRecord)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::LineBuffering);
+
+    co.writeLog(Level::info(), "", "one\n", Location());
+    EXPECT_EQ("one\n", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, AutoBufferingBlocksWhenNotATerminal)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+
+    co.writeLog(Level::info(), "", "one\n", Location());
+    EXPECT_EQ("", captured());
+    co.flush();
+    EXPECT_EQ("one\n", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, BufferedErrorsWriteImmediately)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+
+    co.writeLog(Level::warn(), "", "w", Location());
+    EXPECT_EQ("", captured());
+    co.writeLog(Level::error(), "", "e", Location());
+    EXPECT_EQ("we", captured());
+
+    co.setFlushLevel(Level());
+    co.writeLog(Level::fatal(), "", "f", Location());
+    EXPECT_EQ("we", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, BufferedFlushIntervalWorks)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+    co.setFlushInterval(20);
+    co.flush();
+
+    co.writeLog(Level::info(), "", "a", Location());
+    EXPECT_EQ("", captured());
+    this_thread::sleep_for(chrono::milliseconds(30));
+    co.writeLog(Level::info(), "", "b", Location());
+    EXPECT_EQ("ab", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, BufferedFlushIntervalIsCheckedOnWrite)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+    co.setFlushInterval(10);
+    co.flush();
+
+    // no timer, a quiet outputter keeps its records until the next one
+    co.writeLog(Level::info(), "", "a", Location());
+    this_thread::sleep_for(chrono::milliseconds(30));
+    EXPECT_EQ("", captured());
+
+    co.writeLog(Level::info(), "", "b", Location());
+    EXPECT_EQ("ab", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, BufferedStdErrWritesFd2)
+{
+    capture(2);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+    co.setUseStdOut(false);
+    co.setUseStdErr(true);
+
+    co.writeLog(Level::info(), "", "err", Location());
+    co.flush();
+    EXPECT_EQ("err", captured());
+    restore();
+}
+
+TEST_F(ConsoleOutputterTest, LeavingBufferedModeFlushes)
+{
+    capture(1);
+    ConsoleOutputter co;
+    co.setLayout(make_shared<FOTestLayout>());
+    co.setMode(ConsoleOutputter::Buffered);
+    co.setBuffering(ConsoleOutputter::BlockBuffering);
+
+    co.writeLog(Level::info(), "", "one", Location());
+    co.setMode(ConsoleOutputter::Streams);
+    EXPECT_EQ("one", captured());
+
+    co.writeLog(Level::info(), "", "two", Location());
+    EXPECT_EQ("onetwo", captured());
+    restore();
+}
+
+#endif
@@ -26,11 +26,14 @@
 #define __consoleoutputtertest_H
 
 #include <gtest/gtest.h>
+#include <string>
 
 class ConsoleOutputterTest : public ::testing::Test
 {
 protected:
     ConsoleOutputterTest()
+        : fd_(-1)
+        , saved_(-1)
     {
     }
     
@@ -44,7 +47,18 @@ protected:
     
     void TearDown()
     {
+        restore();
+        remove(filename_.c_str());
     }
+
+    // sends file descriptor fd to filename_ until restore()
+    void capture(int fd);
+    void restore();
+    std::string captured();
+
+    int fd_;
+    int saved_;
+    const std::string filename_ = "test-console-41988.tmp";
 };
 
 #endif // consoleoutputtertest_H
@@ -0,0 +1,417 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "deferredmessage.h"
+#include "logsite.h"
+#include "asyncoutputtertest.h"
+#include "loggertest.h"
+#include "fileoutputtertest.h"
+#include <sstream>
+#include <string>
+#include <climits>
+#include <cstring>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	enum Color { Red, Green = 7 };
+
+	struct Point
+	{
+		int x;
+		int y;
+	};
+
+	ostream &operator<<(ostream &os, const Point &p)
+	{
+		return os << "(" << p.x << "," << p.y << ")";
+	}
+
+	// what streaming the same values gives
+	template <class... Args>
+	string streamed(const Args &... args)
+	{
+		ostringstream ss;
+		int expand[] = { 0, ((ss << args), 0)... };
+		(void)expand;
+		return ss.str();
+	}
+
+	template <class... Args>
+	string deferred(const Args &... args)
+	{
+		DeferredMessage msg;
+		msg.capture(args...);
+		return msg.str();
+	}
+
+	int evaluated_ = 0;
+
+	int evaluate()
+	{
+		++evaluated_;
+		return 1;
+	}
+}
+
+TEST(DeferredMessageTest, EmptyByDefault)
+{
+	DeferredMessage msg;
+	EXPECT_TRUE(msg.empty());
+	ASSERT_EQ("", msg.str());
+}
+
+TEST(DeferredMessageTest, FormatsLikeStreams)
+{
+	const string s = "string";
+	const char *cstr = "cstring";
+	short sh = -12;
+	unsigned short ush = 65535;
+	long long big = LLONG_MIN;
+	unsigned long long ubig = ULLONG_MAX;
+
+	EXPECT_EQ(streamed("literal ", 42, ' ', -7, " ", 3.25), deferred("literal ", 42, ' ', -7, " ", 3.25));
+	EXPECT_EQ(streamed(s, cstr, sh, ush), deferred(s, cstr, sh, ush));
+	EXPECT_EQ(streamed(big, ubig, 42u, 42l), deferred(big, ubig, 42u, 42l));
+	EXPECT_EQ(streamed(1.0 / 3, 1e20, 1e-20, 0.1f, 100.0), deferred(1.0 / 3, 1e20, 1e-20, 0.1f, 100.0));
+	EXPECT_EQ(streamed(true, false), deferred(true, false));
+	EXPECT_EQ(streamed('a', (signed char)'b', (unsigned char)'c'), deferred('a', (signed char)'b', (unsigned char)'c'));
+	ASSERT_EQ(streamed(Red, Green), deferred(Red, Green));
+}
+
+TEST(DeferredMessageTest, FormatsPointers)
+{
+	int x = 0;
+	int *p = &x;
+	void *nothing = nullptr;
+	EXPECT_EQ(streamed(p), deferred(p));
+	EXPECT_EQ(streamed(nothing), deferred(nothing));
+
+	const char *null = nullptr;
+	ASSERT_EQ("0", deferred(null));
+}
+
+TEST(DeferredMessageTest, OtherTypesUseOperatorStream)
+{
+	Point p = { 3, 4 };
+	ASSERT_EQ("at (3,4)", deferred("at ", p));
+}
+
+TEST(DeferredMessageTest, CharArraysAreCopied)
+{
+	char buffer[16] = "first";
+	const char *pointer = buffer;
+
+	DeferredMessage msg;
+	msg.capture("v=", buffer, " ", pointer);
+	strcpy(buffer, "CHANGED");
+	EXPECT_EQ("v=first first", msg.str());
+
+	// a full buffer without a terminator stops at its end
+	char unterminated[4] = { 'a', 'b', 'c', 'd' };
+	msg.clear();
+	msg.capture(unterminated, '|');
+	EXPECT_EQ("abcd|", msg.str());
+
+	// const arrays too, they can go out of scope before the record is written
+	msg.clear();
+	{
+		const char name[] = { 'x', 'y', 0 };
+		msg.capture(name);
+	}
+	{
+		const char other[] = { 'X', 'Y', 0 };
+		msg.capture(other);
+	}
+	ASSERT_EQ("xyXY", msg.str());
+}
+
+TEST(DeferredMessageTest, DeferredLiteralsAreKeptByPointer)
+{
+	char text[] = "first";
+
+	DeferredMessage msg;
+	msg.capture(DeferredLiteral(text), 1);
+	strcpy(text, "later");
+	ASSERT_EQ("later1", msg.str());
+}
+
+TEST(DeferredMessageTest, CaptureAppends)
+{
+	DeferredMessage msg;
+	msg.capture("a", 1);
+	msg.capture();
+	msg.capture("b", 2);
+	ASSERT_EQ("a1b2", msg.str());
+}
+
+TEST(DeferredMessageTest, TooBigMovesToTheHeap)
+{
+	const string big(DeferredMessage::Capacity, 'x');
+	EXPECT_EQ(streamed("start ", 1, big, 2.5, 'c', big), deferred("start ", 1, big, 2.5, 'c', big));
+
+	// lots of small arguments
+	DeferredMessage msg;
+	string expected;
+	for (int i=0;i<100;++i)
+	{
+		msg.capture(i, ",");
+		expected += to_string(i) + ",";
+	}
+	ASSERT_EQ(expected, msg.str());
+}
+
+TEST(DeferredMessageTest, CopiesAreIndependent)
+{
+	DeferredMessage msg;
+	msg.capture("one ", 1);
+
+	DeferredMessage copy(msg);
+	msg.capture(" more");
+	EXPECT_EQ("one 1", copy.str());
+
+	DeferredMessage big;
+	big.capture(string(DeferredMessage::Capacity * 2, 'x'));
+	copy = big;
+	EXPECT_EQ(big.str(), copy.str());
+
+	copy = msg;
+	EXPECT_EQ("one 1 more", copy.str());
+
+	copy.clear();
+	ASSERT_TRUE(copy.empty());
+}
+
+TEST(DeferredMessageTest, FormatsWithAPattern)
+{
+	DeferredMessage msg;
+	msg.capture(1, "two", 3.5);
+
+	string result;
+	msg.format(result, "{} then {} then {}");
+	EXPECT_EQ("1 then two then 3.5", result);
+
+	// missing arguments leave the {}, extra ones go at the end
+	result.clear();
+	msg.format(result, "{} {{}");
+	EXPECT_EQ("1 {two3.5", result);
+
+	DeferredMessage few;
+	few.capture(1);
+	result.clear();
+	few.format(result, "a {} b {} c");
+	EXPECT_EQ("a 1 b {} c", result);
+
+	result.clear();
+	DeferredMessage().format(result, "no arguments");
+	ASSERT_EQ("no arguments", result);
+}
+
+TEST(DeferredMessageTest, SitesFormatTheirPattern)
+{
+	static const auto site = LogSite::add("x={} y={}", Level::INFO, Location("file.cpp", "f", 3));
+	EXPECT_LT(0u, site->id());
+	EXPECT_LE(site->id(), LogSite::count());
+	EXPECT_STREQ("x={} y={}", site->format());
+	EXPECT_EQ(Level::INFO, site->level());
+	EXPECT_EQ(3, site->location().line());
+
+	DeferredMessage msg(site);
+	msg.capture(1, 2);
+	EXPECT_EQ(site, msg.site());
+	EXPECT_EQ("x=1 y=2", msg.str());
+
+	DeferredMessage copy(msg);
+	EXPECT_EQ("x=1 y=2", copy.str());
+	copy.setSite(nullptr);
+	ASSERT_EQ("12", copy.str());
+}
+
+TEST(DeferredMessageTest, EncodeAndDecode)
+{
+	char literal[] = "literal";
+	const string big(DeferredMessage::Capacity, 'x');
+	DeferredMessage msg;
+	msg.capture(DeferredLiteral(literal), -1, 2u, 3.5, true, 'c', string("text"), (void *)nullptr, big);
+
+	string bytes;
+	msg.encode(bytes);
+
+	// literals are copied so the bytes don't point into this process
+	literal[0] = 'L';
+	DeferredMessage decoded;
+	EXPECT_TRUE(decoded.decode(bytes.data(), bytes.size()));
+	EXPECT_EQ("literal-123.51ctext0" + big, decoded.str());
+
+	string again;
+	decoded.encode(again);
+	EXPECT_EQ(bytes, again);
+
+	EXPECT_TRUE(decoded.decode("", 0));
+	ASSERT_TRUE(decoded.empty());
+}
+
+TEST(DeferredMessageTest, DecodeRejectsDamagedBytes)
+{
+	DeferredMessage msg;
+	msg.capture(42, string("text"));
+	string bytes;
+	msg.encode(bytes);
+
+	// anything but a whole number of values
+	const size_t first = 1 + sizeof(long long);
+	DeferredMessage decoded;
+	for (size_t size=1;size<bytes.size();++size)
+		EXPECT_EQ(size == first, decoded.decode(bytes.data(), size)) << size;
+	EXPECT_TRUE(decoded.decode(bytes.data(), first));
+	EXPECT_EQ("42", decoded.str());
+	EXPECT_FALSE(decoded.decode(bytes.data(), first + 1));
+	EXPECT_TRUE(decoded.empty());
+
+	const char unknown[] = { 99, 0 };
+	EXPECT_FALSE(decoded.decode(unknown, sizeof(unknown)));
+
+	// a literal pointer only means something in the process that captured it
+	string literal(1 + sizeof(const char *), '\0');
+	literal[0] = 6; // the literal tag
+	ASSERT_FALSE(decoded.decode(literal.data(), literal.size()));
+}
+
+TEST(DeferredMessageTest, LoggerFormatsForPlainOutputters)
+{
+	auto log = Logger::logger("deferred.plain");
+	auto op = make_shared<StringOutputter>();
+	op->setLayout(make_shared<FOTestLayout>());
+	log->addOutputter(op);
+
+	EXPECT_TRUE(log->logDeferred(Level::info(), DeferredMessage()));
+	SHARKLOG_DEFER_INFO(log, "value ", 42, " of ", 1.5);
+	EXPECT_EQ("value 42 of 1.5", op->output_);
+
+	Logger::closeRootLogger();
+}
+
+TEST(DeferredMessageTest, BinaryMacrosFormatForPlainOutputters)
+{
+	auto log = Logger::logger("deferred.binary");
+	auto op = make_shared<StringOutputter>();
+	op->setLayout(make_shared<FOTestLayout>());
+	log->addOutputter(op);
+
+	SHARKLOG_BINARY_INFO(log, "{} + {} = {}", 1, 2, 3);
+	EXPECT_EQ("1 + 2 = 3", op->output_);
+	SHARKLOG_BINARY_WARN(log, "no arguments");
+	EXPECT_EQ("no arguments", op->output_);
+
+	log->setLevel(Level::warn());
+	evaluated_ = 0;
+	SHARKLOG_BINARY_INFO(log, "{}", evaluate());
+	EXPECT_EQ(0, evaluated_);
+	SHARKLOG_BINARY_FATAL(log, "fatal {}", evaluate());
+	EXPECT_EQ("fatal 1", op->output_);
+	ASSERT_EQ(1, evaluated_);
+
+	Logger::closeRootLogger();
+}
+
+TEST(DeferredMessageTest, MacrosCheckTheLevelFirst)
+{
+	auto log = Logger::logger("deferred.level");
+	auto op = make_shared<StringOutputter>();
+	op->setLayout(make_shared<FOTestLayout>());
+	log->addOutputter(op);
+	log->setLevel(Level::warn());
+	evaluated_ = 0;
+
+	SHARKLOG_DEFER_DEBUG(log, "x", evaluate());
+	SHARKLOG_DEFER_TRACE(log, "x", evaluate());
+	SHARKLOG_DEFER_INFO(log, "x", evaluate());
+	EXPECT_EQ(0, evaluated_);
+	EXPECT_EQ("", op->output_);
+
+	SHARKLOG_DEFER_WARN(log, "warn");
+	EXPECT_EQ("warn", op->output_);
+	SHARKLOG_DEFER_ERROR(log, "error");
+	EXPECT_EQ("error", op->output_);
+	SHARKLOG_DEFER_FATAL(log, "fatal", evaluate());
+	EXPECT_EQ("fatal1", op->output_);
+	ASSERT_EQ(1, evaluated_);
+
+	Logger::closeRootLogger();
+}
+
+TEST_F(AsyncOutputterTest, DeferredMessagesAreFormattedByTheWriter)
+{
+	auto aop = make_shared<AsyncOutputter>(recorder_);
+	auto log = Logger::logger("deferred.async");
+	log->addOutputter(aop);
+
+	// the string goes out of scope before the writer formats it
+	{
+		string temp = "temporary";
+		SHARKLOG_DEFER_INFO(log, "order ", 17, " ", temp, " at ", 99.5);
+	}
+	aop->flush();
+
+	ASSERT_EQ(1, recorder_->count());
+	EXPECT_EQ("order 17 temporary at 99.5", recorder_->messages_[0]);
+	EXPECT_EQ(Level::INFO, recorder_->levels_[0].level());
+	ASSERT_NE(this_thread::get_id(), recorder_->writers_[0]);
+}
+
+TEST_F(AsyncOutputterTest, DeferredAndPlainMessagesStayInOrder)
+{
+	AsyncOutputter aop(recorder_, 64);
+	for (int i=0;i<500;++i)
+	{
+		if (i % 2)
+		{
+			DeferredMessage msg;
+			msg.capture(i);
+			aop.writeDeferred(Level::info(), "test", msg, Location());
+		}
+		else
+			aop.writeLog(Level::info(), "test", to_string(i), Location());
+	}
+	aop.flush();
+
+	ASSERT_EQ(500, recorder_->count());
+	for (int i=0;i<500;++i)
+		ASSERT_EQ(to_string(i), recorder_->messages_[i]);
+}
+
+TEST_F(AsyncOutputterTest, DeferredMessagesAreFormattedWhenClosed)
+{
+	AsyncOutputter aop(recorder_);
+	aop.close();
+
+	DeferredMessage msg;
+	msg.capture("direct ", 1);
+	aop.writeDeferred(Level::info(), "test", msg, Location());
+	ASSERT_EQ(1, recorder_->count());
+	ASSERT_EQ("direct 1", recorder_->messages_[0]);
+}
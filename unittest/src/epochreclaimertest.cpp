@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "epochreclaimer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	// counts its own destruction
+	struct Tracked
+	{
+		explicit Tracked(atomic<int> &freed) : freed_(freed) { }
+		~Tracked() { ++freed_; }
+
+		atomic<int> &freed_;
+	};
+
+	void retireTracked(atomic<int> &freed)
+	{
+		EpochReclaimer::retire(unique_ptr<Tracked>(new Tracked(freed)));
+	}
+}
+
+TEST(EpochReclaimerTest, FreedStraightAwayWithoutReaders)
+{
+	atomic<int> freed(0);
+	retireTracked(freed);
+	ASSERT_EQ(1, freed.load());
+}
+
+TEST(EpochReclaimerTest, ReaderKeepsWhatItCouldSee)
+{
+	atomic<int> freed(0);
+	{
+		EpochReclaimer::Reader reader;
+		retireTracked(freed);
+		EpochReclaimer::reclaim();
+		EXPECT_EQ(0, freed.load());
+	}
+
+	// the reader never frees, the next reclaim does
+	EXPECT_EQ(0, freed.load());
+	EpochReclaimer::reclaim();
+	ASSERT_EQ(1, freed.load());
+}
+
+TEST(EpochReclaimerTest, NestedReadersKeepTheOuterEpoch)
+{
+	atomic<int> freed(0);
+	{
+		EpochReclaimer::Reader outer;
+		{
+			EpochReclaimer::Reader inner;
+		}
+		retireTracked(freed);
+		EXPECT_EQ(0, freed.load());
+	}
+
+	EpochReclaimer::reclaim();
+	ASSERT_EQ(1, freed.load());
+}
+
+TEST(EpochReclaimerTest, WaitsForReadersOnOtherThreads)
+{
+	atomic<int> freed(0);
+	atomic<bool> reading(false);
+	atomic<bool> done(false);
+	thread reader([&] {
+		EpochReclaimer::Reader reader;
+		reading = true;
+		while (!done)
+			this_thread::yield();
+	});
+	while (!reading)
+		this_thread::yield();
+
+	retireTracked(freed);
+	EXPECT_EQ(0, freed.load());
+
+	done = true;
+	reader.join();
+	EpochReclaimer::reclaim();
+	ASSERT_EQ(1, freed.load());
+}
+
+TEST(EpochReclaimerTest, LaterReadersDontHoldBackFrees)
+{
+	atomic<int> freed(0);
+	atomic<bool> reading(false);
+	atomic<bool> done(false);
+	thread later;
+	{
+		EpochReclaimer::Reader reader;
+		retireTracked(freed);
+
+		// starts reading after the object was retired, it can't see it
+		later = thread([&] {
+			EpochReclaimer::Reader reader;
+			reading = true;
+			while (!done)
+				this_thread::yield();
+		});
+		while (!reading)
+			this_thread::yield();
+	}
+
+	EpochReclaimer::reclaim();
+	EXPECT_EQ(1, freed.load());
+
+	done = true;
+	later.join();
+}
+
+TEST(EpochReclaimerTest, SlotsHaveTheirOwnCacheLine)
+{
+	auto slot = reinterpret_cast<std::uintptr_t>(&EpochReclaimer::threadSlot());
+	ASSERT_EQ(0u, slot % 64);
+}
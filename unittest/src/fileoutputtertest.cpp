@@ -26,6 +26,9 @@
 #include "fileoutputtertest.h"
 #include "fileoutputter.h"
 #include "logger.h"
+#include <thread>
+#include <vector>
+#include <atomic>
 
 using namespace sharklog;
 using namespace std;
@@ -152,3 +155,83 @@ TEST_F(FileOutputterTest, WriteLogWorks)
 	ASSERT_STREQ("test", line.c_str());
 	file.close();
 }
+
+TEST_F(FileOutputterTest, ConcurrentWritesKeepRecordsWhole)
+{
+	const int threads = 4;
+	const int records = 2000;
+	const string msg(100, 'x');
+
+	FileOutputter fo(filename_);
+    fo.setLayout(make_shared<FOTestLayout>());
+	EXPECT_TRUE(fo.open());
+
+	vector<thread> writers;
+	for (int t=0;t<threads;++t)
+	{
+		writers.push_back(thread([&, t]() {
+			auto line = to_string(t) + msg + "\n";
+			for (int i=0;i<records;++i)
+				fo.writeLog(Level::trace(), "", line, Location());
+		}));
+	}
+	for (auto &it : writers)
+		it.join();
+	fo.close();
+
+	ifstream file(filename_);
+	string line;
+	int count = 0;
+	while (getline(file, line))
+	{
+		EXPECT_EQ(msg.size() + 1, line.size());
+		EXPECT_EQ(string::npos, line.find_first_not_of('x', 1));
+		++count;
+	}
+	ASSERT_EQ(threads * records, count);
+}
+
+TEST_F(FileOutputterTest, OutputtersWriteTheirOwnFiles)
+{
+	FileOutputter one(filename_);
+	FileOutputter two(otherFilename_);
+	one.setLayout(make_shared<FOTestLayout>());
+	two.setLayout(make_shared<FOTestLayout>());
+	EXPECT_TRUE(one.open());
+	EXPECT_TRUE(two.open());
+
+	thread a([&]() { for (int i=0;i<1000;++i) one.writeLog(Level::trace(), "", "a", Location()); });
+	thread b([&]() { for (int i=0;i<500;++i) two.writeLog(Level::trace(), "", "bb", Location()); });
+	a.join();
+	b.join();
+	one.close();
+	two.close();
+
+	EXPECT_EQ(1000, getFileSize(filename_));
+	ASSERT_EQ(1000, getFileSize(otherFilename_));
+}
+
+TEST_F(FileOutputterTest, ReopenWhileWritingIsSafe)
+{
+	FileOutputter fo(filename_);
+    fo.setLayout(make_shared<FOTestLayout>());
+	fo.setAppend(true);
+	EXPECT_TRUE(fo.open());
+
+	atomic<bool> done(false);
+	thread writer([&]() {
+		while (!done)
+			fo.writeLog(Level::trace(), "", "test\n", Location());
+	});
+
+	for (int i=0;i<50;++i)
+	{
+		EXPECT_TRUE(fo.open());
+		fo.close();
+	}
+	done = true;
+	writer.join();
+
+	EXPECT_FALSE(fo.isOpen());
+	ASSERT_EQ(0, getFileSize(filename_) % 5);
+}
@@ -27,6 +27,9 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <fstream>
+#include <iterator>
+#include <memory>
 #include <cstdio>
 #include <sharklog/layout.h>
 #include <sharklog/level.h>
@@ -59,12 +62,53 @@ protected:
     void TearDown()
 	{
 		remove(filename_.c_str());
+		remove(otherFilename_.c_str());
 	}
 
 	unsigned int getFileSize(const std::string &filename);
 	void writeTest();
 
 	const std::string filename_ = "test-file-41983.tmp";
+	const std::string otherFilename_ = "test-file-41984.tmp";
+};
+
+/*!
+ * \brief Base for the tests of outputters that write one file
+ *
+ * Removes \ref filename_ after each test.
+ */
+class OutputFileTest : public ::testing::Test
+{
+protected:
+	explicit OutputFileTest(const std::string &filename) : filename_(filename) { }
+
+	void TearDown() override
+	{
+		remove(filename_.c_str());
+	}
+
+	//! What is in \a filename
+	static std::string contents(const std::string &filename)
+	{
+		std::ifstream f(filename, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+	}
+
+	//! What is in \ref filename_
+	std::string contents() const
+	{
+		return contents(filename_);
+	}
+
+	//! Gives \a fo a \ref FOTestLayout and opens it
+	template <class FO>
+	void setup(FO &fo)
+	{
+		fo.setLayout(std::make_shared<FOTestLayout>());
+		EXPECT_TRUE(fo.open());
+	}
+
+	const std::string filename_;
 };
 
 #endif // fileoutputtertest_H
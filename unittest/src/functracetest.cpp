@@ -38,4 +38,37 @@ TEST(FuncTraceTest, SetExitHeaderWorks)
 {
     FuncTrace::setExitHeader("exit");
     ASSERT_STREQ("exit", FuncTrace::exitHeader().c_str());
-}
\ No newline at end of file
+}
+
+TEST(FuncTraceTest, LogsEnterAndExitWhenEnabled)
+{
+    auto log = Logger::logger("functrace.enabled");
+    auto op = std::make_shared<CountingOutputter>();
+    log->addOutputter(op);
+    log->setLevel(Level::all());
+
+    {
+        SHARKLOG_FUNCTRACE(log);
+        ASSERT_EQ(1u, op->count_.load());
+    }
+    ASSERT_EQ(2u, op->count_.load());
+
+    Logger::closeRootLogger();
+}
+
+TEST(FuncTraceTest, DisabledLoggerIsNotCalled)
+{
+    auto log = Logger::logger("functrace.disabled");
+    auto op = std::make_shared<CountingOutputter>();
+    log->addOutputter(op);
+    log->setLevel(Level::debug());
+
+    {
+        SHARKLOG_FUNCTRACE(log);
+    }
+    ASSERT_EQ(0u, op->count_.load());
+    // the level was checked before log() so nothing was filtered either
+    ASSERT_EQ(0u, log->stats().filtered);
+
+    Logger::closeRootLogger();
+}
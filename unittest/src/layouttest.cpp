@@ -25,6 +25,7 @@
 #include <gtest/gtest.h>
 #include <utilfunctions.h>
 #include "layout.h"
+#include "level.h"
 
 using namespace sharklog;
 
@@ -118,3 +119,30 @@ TEST(LayoutTest, InvalidTimeFormatReturnsProperly)
 	auto res = lay.formatTime("%q");
 	ASSERT_STREQ("%q", res.c_str());
 }
+
+class WrappingLayout : public Layout
+{
+public:
+    void formatMessage(std::string &result, const Level &level, const std::string &loggerName, const std::string &logMessage) final
+    {
+        result += logMessage;
+    }
+
+    void appendHeader(std::string &result) final
+    {
+        result += "<";
+    }
+
+    void appendFooter(std::string &result) final
+    {
+        result += ">";
+    }
+};
+
+TEST(LayoutTest, BaseFormatRecordAppendsHeaderMessageAndFooter)
+{
+    WrappingLayout lay;
+    std::string res = "start ";
+    lay.formatRecord(res, Level::info(), "name", "message", Location("file", "func", 10));
+    ASSERT_STREQ("start <message>", res.c_str());
+}
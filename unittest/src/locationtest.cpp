@@ -32,16 +32,16 @@ using namespace std;
 TEST(LocationTest, ConstructorDefaultMakesEmpty)
 {
     Location loc;
-    ASSERT_TRUE(loc.file().empty());
-    ASSERT_TRUE(loc.function().empty());
+    ASSERT_STREQ("", loc.file());
+    ASSERT_STREQ("", loc.function());
     ASSERT_FALSE(loc.line());
 }
 
 TEST(LocationTest, FilledConstructorWorks)
 {
     Location loc("file", "function", 10);
-    ASSERT_STREQ("file", loc.file().c_str());
-    ASSERT_STREQ("function", loc.function().c_str());
+    ASSERT_STREQ("file", loc.file());
+    ASSERT_STREQ("function", loc.function());
     ASSERT_EQ(10, loc.line());
 }
 
@@ -50,10 +50,10 @@ TEST(LocationTest, TestLocationCreationMacro)
     auto loc = SHARKLOG_LOCATION;
     
     auto re = regex("^[a-z]* [a-z].*\\(.*\\)");
-    ASSERT_TRUE(regex_match(loc.function().c_str(), re)) << loc.function().c_str();
+    ASSERT_TRUE(regex_match(loc.function(), re)) << loc.function();
     
     re = regex("^.*(locationtest.cpp)");
-    ASSERT_TRUE(regex_match(loc.file().c_str(), re)) << loc.file().c_str();
+    ASSERT_TRUE(regex_match(loc.file(), re)) << loc.file();
     
     ASSERT_GT(loc.line(), 0);
 }
@@ -68,4 +68,38 @@ TEST(LocationTest, FormattedStringWorks)
 {
     Location loc("file", "func", 10);
     ASSERT_STREQ("File: file Function: func Line: 10", loc.formattedString().c_str());
-}
\ No newline at end of file
+}
+
+TEST(LocationTest, NullStringsAreEmpty)
+{
+    Location loc(nullptr, nullptr, 10);
+    EXPECT_STREQ("", loc.file());
+    EXPECT_STREQ("", loc.function());
+    ASSERT_TRUE(loc.empty());
+}
+
+TEST(LocationTest, LocationIsConstexpr)
+{
+    static constexpr Location loc("file", "function", 10);
+    static_assert(loc.line() == 10, "line should be known at compile time");
+    ASSERT_STREQ("file", loc.file());
+}
+
+TEST(LocationTest, StaticLocationIsBuiltOncePerCallSite)
+{
+    const Location *locs[2];
+    for (int i=0;i<2;++i)
+    {
+        SHARKLOG_STATIC_LOCATION(loc);
+        locs[i] = &loc;
+    }
+    EXPECT_EQ(locs[0], locs[1]);
+    ASSERT_FALSE(locs[0]->empty());
+}
+
+TEST(LocationTest, LocationDoesNotCopyStrings)
+{
+    const char *file = "file.cpp";
+    Location loc(file, "function", 10);
+    ASSERT_EQ(file, loc.file());
+}
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "loggerregistry.h"
+#include "logger.h"
+#include <sstream>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+    // loggers can't be made directly, borrow named ones and drop them from
+    // the logger's own registry
+    LoggerPtr makeLogger(const std::string &name)
+    {
+        auto logger = Logger::logger(name);
+        Logger::closeLogger(logger);
+        return logger;
+    }
+}
+
+TEST(LoggerRegistryTest, EmptyFindsNothing)
+{
+    LoggerRegistry reg;
+    EXPECT_EQ(0, reg.size());
+    ASSERT_EQ(nullptr, reg.find("test"));
+}
+
+TEST(LoggerRegistryTest, InsertAndFind)
+{
+    LoggerRegistry reg;
+    auto logger = makeLogger("test");
+    reg.insert("test", logger);
+
+    EXPECT_EQ(1, reg.size());
+    EXPECT_EQ(logger.get(), reg.find("test"));
+    ASSERT_EQ(logger, reg.get("test"));
+}
+
+TEST(LoggerRegistryTest, FindIsCaseInsensitive)
+{
+    LoggerRegistry reg;
+    auto logger = makeLogger("test");
+    reg.insert("Com.AmberShark", logger);
+
+    EXPECT_EQ(logger.get(), reg.find("com.ambershark"));
+    EXPECT_EQ(logger.get(), reg.find("COM.AMBERSHARK"));
+    ASSERT_EQ(nullptr, reg.find("com.ambershar"));
+}
+
+TEST(LoggerRegistryTest, EraseWorks)
+{
+    LoggerRegistry reg;
+    reg.insert("test", makeLogger("test"));
+    reg.erase("TEST");
+
+    EXPECT_EQ(0, reg.size());
+    ASSERT_EQ(nullptr, reg.find("test"));
+}
+
+TEST(LoggerRegistryTest, EraseAndInsertAgain)
+{
+    LoggerRegistry reg;
+    auto first = makeLogger("first");
+    auto second = makeLogger("second");
+    reg.insert("test", first);
+    reg.erase("test");
+    reg.insert("test", second);
+
+    EXPECT_EQ(1, reg.size());
+    ASSERT_EQ(second.get(), reg.find("test"));
+}
+
+TEST(LoggerRegistryTest, GrowsAndShrinks)
+{
+    LoggerRegistry reg;
+    auto logger = makeLogger("test");
+    for (int i=0;i<5000;++i)
+        reg.insert("logger" + to_string(i), logger);
+
+    EXPECT_EQ(5000, reg.size());
+    for (int i=0;i<5000;++i)
+        ASSERT_EQ(logger.get(), reg.find("LOGGER" + to_string(i))) << i;
+
+    for (int i=0;i<4990;++i)
+        reg.erase("logger" + to_string(i));
+
+    EXPECT_EQ(10, reg.size());
+    EXPECT_EQ(10, reg.loggers().size());
+    EXPECT_EQ(nullptr, reg.find("logger0"));
+    ASSERT_EQ(logger.get(), reg.find("logger4999"));
+}
+
+TEST(LoggerRegistryTest, EraseReleasesTheLogger)
+{
+    // the entry shares ownership with owner, so it shows when the registry
+    // lets go whatever else holds the logger
+    auto owner = make_shared<int>(0);
+    weak_ptr<int> released = owner;
+    LoggerRegistry reg;
+    reg.insert("test", LoggerPtr(owner, makeLogger("test").get()));
+    owner.reset();
+
+    EXPECT_FALSE(released.expired());
+    reg.erase("test");
+    ASSERT_TRUE(released.expired());
+}
+
+TEST(LoggerRegistryTest, RebuiltTablesReleaseTheirLoggers)
+{
+    auto owner = make_shared<int>(0);
+    weak_ptr<int> released = owner;
+    LoggerRegistry reg;
+    reg.insert("first", LoggerPtr(owner, makeLogger("first").get()));
+    owner.reset();
+
+    // growing copies the entry to new tables, only the current one may own it
+    auto other = makeLogger("other");
+    for (int i=0;i<100;++i)
+        reg.insert("logger" + to_string(i), other);
+
+    EXPECT_NE(nullptr, reg.get("first"));
+    reg.erase("first");
+    ASSERT_TRUE(released.expired());
+}
+
+TEST(LoggerRegistryTest, ClearWorks)
+{
+    LoggerRegistry reg;
+    reg.insert("test", makeLogger("test"));
+    reg.clear();
+
+    EXPECT_EQ(0, reg.size());
+    ASSERT_EQ(nullptr, reg.find("test"));
+}
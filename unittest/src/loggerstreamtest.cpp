@@ -25,10 +25,38 @@
 #include "loggerstreamtest.h"
 #include "loggerstream.h"
 #include <regex>
+#include <iomanip>
+#include <thread>
 
 using namespace sharklog;
 using namespace std;
 
+namespace
+{
+	// counts how many times it was formatted
+	struct Formatted
+	{
+		int *count;
+	};
+
+	ostream &operator<<(ostream &os, const Formatted &f)
+	{
+		++*f.count;
+		return os << "formatted";
+	}
+
+	// logs its own message with another stream while it is formatted
+	struct Nested
+	{
+	};
+
+	ostream &operator<<(ostream &os, const Nested &)
+	{
+		LoggerStream(Logger::rootLogger(), Level::info()) << "inner " << 2 << SHARKLOG_END;
+		return os << "nested";
+	}
+}
+
 TEST_F(LoggerStreamTest, ConstructorSetupWorks)
 {
     LoggerStream ls(Logger::rootLogger(), Level::fatal());
@@ -125,3 +153,89 @@ TEST_F(LoggerStreamTest, TestEndMacroAddsLocation)
     ls << "test" << SHARKLOG_END;
     ASSERT_FALSE(ls.location().empty());
 }
+
+TEST_F(LoggerStreamTest, StreamIsEnabledFollowsLoggerLevel)
+{
+    LoggerStream ls(Logger::rootLogger(), Level::debug());
+    EXPECT_TRUE(ls.isEnabled());
+    Logger::rootLogger()->setLevel(Level::info());
+    EXPECT_FALSE(ls.isEnabled());
+    ls << Level::warn();
+    ASSERT_TRUE(ls.isEnabled());
+}
+
+TEST_F(LoggerStreamTest, DisabledStreamDoesNotFormat)
+{
+    Logger::rootLogger()->setLevel(Level::info());
+    int count = 0;
+    LoggerStream ls(Logger::rootLogger(), Level::debug());
+    ls << Formatted{&count} << " and " << 10;
+    EXPECT_EQ(0, count);
+    EXPECT_TRUE(ls.data().empty());
+    
+    ls << Level::info() << Formatted{&count};
+    EXPECT_EQ(1, count);
+    ASSERT_STREQ("formatted", ls.data().c_str());
+}
+
+TEST_F(LoggerStreamTest, DisabledStreamDoesNotLog)
+{
+    Logger::rootLogger()->setLevel(Level::info());
+    auto sop = dynamic_cast<StringOutputter *>(Logger::rootLogger()->outputters().front().get());
+    LoggerStream ls(Logger::rootLogger(), Level::debug());
+    ls << "hello world" << LoggerStream::end;
+    ASSERT_TRUE(sop->output_.empty());
+}
+
+TEST_F(LoggerStreamTest, LongMessagesAreKept)
+{
+    const string part(100, 'x');
+    string expected;
+    LoggerStream ls;
+    for (int i=0;i<50;++i)
+    {
+        ls << part << i;
+        expected += part + to_string(i);
+    }
+    ASSERT_EQ(expected, ls.data());
+    
+    ls << LoggerStream::end;
+    auto sop = dynamic_cast<StringOutputter *>(Logger::rootLogger()->outputters().front().get());
+    ASSERT_NE(string::npos, sop->output_.find(expected + "\n"));
+}
+
+TEST_F(LoggerStreamTest, EachMessageStartsWithDefaultFormatting)
+{
+    LoggerStream ls;
+    ls << hex << showbase << setprecision(2) << setfill('*') << setw(6) << 255 << " " << 3.14159 << LoggerStream::end;
+    auto sop = dynamic_cast<StringOutputter *>(Logger::rootLogger()->outputters().front().get());
+    EXPECT_NE(string::npos, sop->output_.find("**0xff 3.1\n")) << sop->output_;
+    
+    ls << setw(4) << 255 << " " << 3.14159 << LoggerStream::end;
+    ASSERT_NE(string::npos, sop->output_.find("]  255 3.14159\n")) << sop->output_;
+}
+
+TEST_F(LoggerStreamTest, StreamsCanNest)
+{
+    auto sop = dynamic_cast<StringOutputter *>(Logger::rootLogger()->outputters().front().get());
+    LoggerStream ls(Logger::rootLogger(), Level::info());
+    ls << "outer " << 1 << " ";
+    ls << Nested() << " done";
+    EXPECT_NE(string::npos, sop->output_.find("inner 2\n")) << sop->output_;
+    
+    ls << LoggerStream::end;
+    ASSERT_NE(string::npos, sop->output_.find("outer 1 nested done\n")) << sop->output_;
+}
+
+TEST_F(LoggerStreamTest, StreamsCanMoveBetweenThreads)
+{
+    auto ls = new LoggerStream(Logger::rootLogger(), Level::info());
+    *ls << "started here";
+    thread([ls]() {
+        *ls << " ended there" << LoggerStream::end;
+        delete ls;
+    }).join();
+    
+    auto sop = dynamic_cast<StringOutputter *>(Logger::rootLogger()->outputters().front().get());
+    ASSERT_NE(string::npos, sop->output_.find("started here ended there\n")) << sop->output_;
+}
@@ -26,7 +26,10 @@
 #include "logger.h"
 #include "standardlayout.h"
 #include "consoleoutputter.h"
+#include "patternlayout.h"
 #include <regex>
+#include <thread>
+#include <vector>
 
 using namespace sharklog;
 using namespace std;
@@ -262,6 +265,41 @@ TEST_F(LoggerTest, LoggerNamesAreCaseInsensitive)
     ASSERT_EQ(logger, Logger::logger("mike is cool"));
 }
 
+TEST_F(LoggerTest, SiblingLoggersShareParent)
+{
+    auto z = Logger::logger("x.y.z");
+    auto w = Logger::logger("x.y.w");
+    EXPECT_EQ(5, Logger::count());
+    EXPECT_STREQ("x.y.w", w->name().c_str());
+    ASSERT_EQ(z->parent(), w->parent());
+}
+
+TEST_F(LoggerTest, ConcurrentCreateAndLookupGetsSameLoggers)
+{
+    const int numThreads = 8;
+    const int numLoggers = 200;
+    vector<vector<LoggerPtr>> results(numThreads);
+    
+    vector<thread> threads;
+    for (int t=0;t<numThreads;++t)
+    {
+        threads.push_back(thread([&results, t] {
+            for (int i=0;i<numLoggers;++i)
+                results[t].push_back(Logger::logger("con.current." + to_string(i)));
+        }));
+    }
+    
+    for (auto &it : threads)
+        it.join();
+    
+    EXPECT_EQ(numLoggers + 3, Logger::count());
+    for (int t=1;t<numThreads;++t)
+    {
+        for (int i=0;i<numLoggers;++i)
+            ASSERT_EQ(results[0][i], results[t][i]);
+    }
+}
+
 TEST_F(LoggerTest, SetLevelWorks)
 {
     auto logger = Logger::rootLogger();
@@ -269,6 +307,189 @@ TEST_F(LoggerTest, SetLevelWorks)
     ASSERT_TRUE(Level::info() == logger->level()) << logger->level().name();
 }
 
+TEST_F(LoggerTest, ChildInheritsParentLevel)
+{
+    Logger::rootLogger()->setLevel(Level::warn());
+    auto child = Logger::logger("parent.child");
+    ASSERT_EQ(Level::WARN, child->level().level());
+}
+
+TEST_F(LoggerTest, ChildLevelOverridesParent)
+{
+    Logger::rootLogger()->setLevel(Level::warn());
+    auto child = Logger::logger("parent.child");
+    child->setLevel(Level::debug());
+    EXPECT_EQ(Level::DEBUG, child->level().level());
+    ASSERT_EQ(Level::WARN, Logger::rootLogger()->level().level());
+}
+
+TEST_F(LoggerTest, ParentLevelChangeReachesGrandchildren)
+{
+    auto grandchild = Logger::logger("parent.child.grandchild");
+    Logger::logger("parent")->setLevel(Level::error());
+    EXPECT_EQ(Level::ERROR, grandchild->level().level());
+    EXPECT_EQ(Level::ERROR, Logger::logger("parent.child")->level().level());
+    ASSERT_EQ(Level::ALL, Logger::rootLogger()->level().level());
+}
+
+TEST_F(LoggerTest, ParentLevelChangeStopsAtChildWithLevel)
+{
+    auto child = Logger::logger("parent.child");
+    auto grandchild = Logger::logger("parent.child.grandchild");
+    child->setLevel(Level::info());
+    Logger::rootLogger()->setLevel(Level::fatal());
+    EXPECT_EQ(Level::FATAL, Logger::logger("parent")->level().level());
+    EXPECT_EQ(Level::INFO, child->level().level());
+    ASSERT_EQ(Level::INFO, grandchild->level().level());
+}
+
+TEST_F(LoggerTest, SettingNoneGoesBackToParentLevel)
+{
+    Logger::rootLogger()->setLevel(Level::warn());
+    auto child = Logger::logger("parent.child");
+    child->setLevel(Level::debug());
+    EXPECT_EQ(Level::DEBUG, child->level().level());
+    child->setLevel(Level(Level::NONE));
+    ASSERT_EQ(Level::WARN, child->level().level());
+}
+
+TEST_F(LoggerTest, IsEnabledFollowsLevel)
+{
+    auto root = Logger::rootLogger();
+    EXPECT_TRUE(root->isEnabled(Level::FUNCTRACE));
+    root->setLevel(Level::warn());
+    EXPECT_TRUE(root->isEnabled(Level::FATAL));
+    EXPECT_TRUE(root->isEnabled(Level::WARN));
+    EXPECT_FALSE(root->isEnabled(Level::INFO));
+    ASSERT_FALSE(root->isEnabled(Level::DEBUG));
+}
+
+TEST_F(LoggerTest, IsEnabledFollowsInheritedLevel)
+{
+    auto child = Logger::logger("parent.child");
+    Logger::logger("parent")->setLevel(Level::error());
+    EXPECT_TRUE(child->isEnabled(Level::ERROR));
+    EXPECT_FALSE(child->isEnabled(Level::WARN));
+    child->setLevel(Level::debug());
+    ASSERT_TRUE(child->isEnabled(Level::DEBUG));
+}
+
+TEST_F(LoggerTest, MacroEvaluatesLoggerOnce)
+{
+    auto op = make_shared<CountingOutputter>();
+    Logger::rootLogger()->addOutputter(op);
+    int evaluated = 0;
+    auto logger = [&]() { ++evaluated; return Logger::rootLogger(); };
+    SHARKLOG_INFO(logger(), "test");
+    EXPECT_EQ(1, evaluated);
+    ASSERT_EQ(1, op->count_.load());
+}
+
+TEST_F(LoggerTest, LevelCanChangeWhileLogging)
+{
+    auto logger = Logger::logger("parent.child");
+    auto op = make_shared<CountingOutputter>();
+    logger->addOutputter(op);
+    
+    atomic<bool> done(false);
+    unsigned int logged = 0;
+    thread writer([&]() {
+        while (!done.load())
+        {
+            if (logger->isEnabled(Level::DEBUG) && logger->log(Level::debug(), "test"))
+                ++logged;
+        }
+    });
+    
+    for (int i=0;i<2000;++i)
+        Logger::rootLogger()->setLevel(i % 2 ? Level::debug() : Level::info());
+    
+    done = true;
+    writer.join();
+    ASSERT_EQ(logged, op->count_.load());
+}
+
+TEST_F(LoggerTest, ChildLogsToParentOutputters)
+{
+    auto op = make_shared<CountingOutputter>();
+    op->setLayout(make_shared<StandardLayout>());
+    Logger::rootLogger()->addOutputter(op);
+    auto child = Logger::logger("parent.child");
+    EXPECT_TRUE(child->outputters().empty());
+    EXPECT_TRUE(child->isValid());
+    EXPECT_TRUE(child->log(Level::info(), "test"));
+    ASSERT_EQ(1, op->count_.load());
+}
+
+TEST_F(LoggerTest, ChildLogsToOwnAndParentOutputters)
+{
+    auto rootOp = make_shared<CountingOutputter>();
+    auto childOp = make_shared<CountingOutputter>();
+    auto child = Logger::logger("parent.child");
+    child->addOutputter(childOp);
+    Logger::rootLogger()->addOutputter(rootOp);
+    
+    EXPECT_TRUE(child->log(Level::info(), "test"));
+    EXPECT_TRUE(Logger::rootLogger()->log(Level::info(), "test"));
+    EXPECT_EQ(2, rootOp->count_.load());
+    ASSERT_EQ(1, childOp->count_.load());
+}
+
+TEST_F(LoggerTest, ChildLevelFiltersParentOutputters)
+{
+    auto op = make_shared<CountingOutputter>();
+    Logger::rootLogger()->addOutputter(op);
+    auto child = Logger::logger("parent.child");
+    child->setLevel(Level::error());
+    EXPECT_FALSE(child->log(Level::info(), "test"));
+    EXPECT_TRUE(child->log(Level::error(), "test"));
+    ASSERT_EQ(1, op->count_.load());
+}
+
+TEST_F(LoggerTest, AdditivityOffStopsParentOutputters)
+{
+    auto rootOp = make_shared<CountingOutputter>();
+    auto childOp = make_shared<CountingOutputter>();
+    Logger::rootLogger()->addOutputter(rootOp);
+    auto parent = Logger::logger("parent");
+    auto child = Logger::logger("parent.child");
+    parent->addOutputter(childOp);
+    EXPECT_TRUE(parent->additivity());
+    parent->setAdditivity(false);
+    EXPECT_FALSE(parent->additivity());
+    
+    EXPECT_TRUE(child->log(Level::info(), "test"));
+    EXPECT_EQ(0, rootOp->count_.load());
+    EXPECT_EQ(1, childOp->count_.load());
+    
+    parent->setAdditivity(true);
+    EXPECT_TRUE(child->log(Level::info(), "test"));
+    EXPECT_EQ(1, rootOp->count_.load());
+    ASSERT_EQ(2, childOp->count_.load());
+}
+
+TEST_F(LoggerTest, RemovedParentOutputterIsRemovedFromChildren)
+{
+    auto op = make_shared<CountingOutputter>();
+    op->setLayout(make_shared<StandardLayout>());
+    auto child = Logger::logger("parent.child");
+    Logger::rootLogger()->addOutputter(op);
+    EXPECT_TRUE(child->isValid());
+    Logger::rootLogger()->removeOutputter(op);
+    EXPECT_FALSE(child->isValid());
+    ASSERT_FALSE(child->log(Level::info(), "test"));
+}
+
+TEST_F(LoggerTest, SameOutputterOnParentAndChildWritesOnce)
+{
+    auto op = make_shared<CountingOutputter>();
+    Logger::rootLogger()->addOutputter(op);
+    auto child = Logger::logger("parent.child");
+    child->addOutputter(op);
+    EXPECT_TRUE(child->log(Level::info(), "test"));
+    ASSERT_EQ(1, op->count_.load());
+}
+
 TEST_F(LoggerTest, BaseLoggerNotValid)
 {
     ASSERT_FALSE(Logger::rootLogger()->isValid());
@@ -327,6 +548,87 @@ TEST_F(LoggerTest, RemoveSameOutputterFails)
     ASSERT_EQ(1, logger->outputters().size());
 }
 
+TEST_F(LoggerTest, OutputtersCanChangeWhileLogging)
+{
+    auto logger = Logger::rootLogger();
+    auto always = make_shared<CountingOutputter>();
+    auto sometimes = make_shared<CountingOutputter>();
+    logger->addOutputter(always);
+    
+    atomic<bool> done(false);
+    unsigned int logged = 0;
+    thread writer([&]() {
+        while (!done.load())
+        {
+            if (logger->log(Level::info(), "test"))
+                ++logged;
+        }
+    });
+    
+    for (int i=0;i<2000;++i)
+    {
+        logger->addOutputter(sometimes);
+        logger->removeOutputter(sometimes);
+    }
+    
+    done = true;
+    writer.join();
+    
+    EXPECT_EQ(1, logger->outputters().size());
+    EXPECT_EQ(logged, always->count_.load());
+    ASSERT_LE(sometimes->count_.load(), logged);
+}
+
+TEST_F(LoggerTest, RemovedOutputterIsReleased)
+{
+    auto parent = Logger::logger("release");
+    auto child = Logger::logger("release.child");
+    auto op = make_shared<CountingOutputter>();
+    weak_ptr<CountingOutputter> released = op;
+    
+    parent->addOutputter(op);
+    child->log(Level::info(), "test");
+    parent->removeOutputter(op);
+    parent->setLevel(Level::warn());
+    child->setAdditivity(false);
+    
+    EXPECT_EQ(1u, op->count_.load());
+    EXPECT_EQ(1, op.use_count());
+    op.reset();
+    ASSERT_TRUE(released.expired());
+}
+
+TEST_F(LoggerTest, RemovedOutputterIsReleasedAfterLogging)
+{
+    auto logger = Logger::rootLogger();
+    logger->addOutputter(make_shared<CountingOutputter>());
+    
+    atomic<bool> done(false);
+    thread writer([&]() {
+        while (!done.load())
+            logger->log(Level::info(), "test");
+    });
+    
+    vector<weak_ptr<CountingOutputter>> removed;
+    for (int i=0;i<200;++i)
+    {
+        auto op = make_shared<CountingOutputter>();
+        removed.push_back(op);
+        logger->addOutputter(op);
+        logger->removeOutputter(op);
+    }
+    
+    done = true;
+    writer.join();
+    
+    // logging never frees, what the writer held up goes with the next change
+    auto last = make_shared<CountingOutputter>();
+    logger->addOutputter(last);
+    logger->removeOutputter(last);
+    for (auto &it : removed)
+        EXPECT_TRUE(it.expired());
+}
+
 TEST_F(LoggerTest, RootDefaultsToMaxLevel)
 {
     ASSERT_TRUE(Logger::rootLogger()->level() == Level::all());
@@ -369,6 +671,17 @@ TEST_F(LoggerTest, DISABLED_LocationLoggingShowsLocation)
     // need support for custom/pattern logging in order to test it
 }
 
+TEST_F(LoggerTest, MacroPassesLocationToLayout)
+{
+    auto op = make_shared<StringOutputter>();
+    op->setLayout(make_shared<PatternLayout>("%F:%L %M"));
+    Logger::rootLogger()->addOutputter(op);
+    
+    SHARKLOG_INFO(Logger::rootLogger(), "test"); const int line = __LINE__;
+    auto re = regex("^.*loggertest\\.cpp:" + to_string(line) + " .*MacroPassesLocationToLayout.*");
+    ASSERT_TRUE(regex_match(op->output_.c_str(), re)) << op->output_.c_str();
+}
+
 TEST_F(LoggerTest, TestDEBUGMacro)
 {
     auto sop = setupMacroTest();
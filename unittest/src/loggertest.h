@@ -30,6 +30,7 @@
 #include <sharklog/location.h>
 #include <sharklog/level.h>
 #include <string>
+#include <atomic>
 
 class StringOutputter : public sharklog::Outputter
 {
@@ -42,9 +43,7 @@ public:
     void writeLog(const sharklog::Level &lev, const std::string &logName, const std::string &logMessage, const sharklog::Location &loc) final
     {
         std::string res;
-        layout()->appendHeader(res);
-        layout()->formatMessage(res, lev, logName, logMessage);
-        layout()->appendFooter(res);
+        layout()->formatRecord(res, lev, logName, logMessage, loc);
         output_ = res;
     }
     
@@ -55,6 +54,28 @@ public:
     std::string output_;
 };
 
+class CountingOutputter : public sharklog::Outputter
+{
+public:
+    CountingOutputter() : count_(0) { }
+    
+    bool open() final
+    {
+        return true;
+    }
+    
+    void writeLog(const sharklog::Level &, const std::string &, const std::string &, const sharklog::Location &) final
+    {
+        ++count_;
+    }
+    
+    void close() final { }
+    
+    bool isOpen() const final { return true; }
+    
+    std::atomic<unsigned int> count_;
+};
+
 class LoggerTest : public ::testing::Test
 {
 protected:
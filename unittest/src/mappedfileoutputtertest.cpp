@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "fileoutputtertest.h"
+#include "mappedfileoutputter.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+class MappedFileOutputterTest : public OutputFileTest
+{
+protected:
+	MappedFileOutputterTest() : OutputFileTest("test-mappedfile-41986.tmp") { }
+
+	void setup(MappedFileOutputter &fo)
+	{
+		fo.setChunkSize(4096);
+		OutputFileTest::setup(fo);
+	}
+};
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+TEST_F(MappedFileOutputterTest, Defaults)
+{
+	MappedFileOutputter fo("test");
+	EXPECT_EQ("test", fo.filename());
+	EXPECT_FALSE(fo.append());
+	EXPECT_FALSE(fo.isOpen());
+	ASSERT_EQ(MappedFileOutputter::DefaultChunkSize, fo.chunkSize());
+}
+
+TEST_F(MappedFileOutputterTest, OpenAndCloseWork)
+{
+	MappedFileOutputter fo(filename_);
+	EXPECT_TRUE(fo.open());
+	EXPECT_TRUE(fo.isOpen());
+	fo.close();
+	EXPECT_FALSE(fo.isOpen());
+	ASSERT_EQ("", contents());
+}
+
+TEST_F(MappedFileOutputterTest, OpenFailsForBadPath)
+{
+	MappedFileOutputter fo("no-such-dir-41986/test.log");
+	EXPECT_FALSE(fo.open());
+	ASSERT_FALSE(fo.isOpen());
+}
+
+TEST_F(MappedFileOutputterTest, CloseTruncatesToWrittenSize)
+{
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one\n", Location());
+	fo.writeLog(Level::info(), "", "two\n", Location());
+	EXPECT_EQ(8, fo.size());
+	fo.close();
+	ASSERT_EQ("one\ntwo\n", contents());
+}
+
+TEST_F(MappedFileOutputterTest, RecordsAreInFileBeforeClose)
+{
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one\n", Location());
+
+	// the rest of the chunk is preallocated zeros, like after a crash
+	auto text = contents();
+	EXPECT_EQ(4096, text.size());
+	ASSERT_EQ("one\n", string(text.c_str()));
+}
+
+TEST_F(MappedFileOutputterTest, GrowsAcrossChunks)
+{
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+
+	// 1000 byte records don't line up with the 4k chunks
+	string expected;
+	for (int i=0;i<20;++i)
+	{
+		auto record = string(999, 'a' + i) + "\n";
+		fo.writeLog(Level::info(), "", record, Location());
+		expected += record;
+	}
+
+	// one record bigger than a chunk
+	auto big = string(10000, 'z');
+	fo.writeLog(Level::info(), "", big, Location());
+	expected += big;
+	fo.close();
+
+	EXPECT_EQ(0, fo.droppedCount());
+	ASSERT_EQ(expected, contents());
+}
+
+TEST_F(MappedFileOutputterTest, AppendModeWorks)
+{
+	{
+		MappedFileOutputter fo(filename_);
+		setup(fo);
+		fo.writeLog(Level::info(), "", "one", Location());
+	}
+
+	MappedFileOutputter fo(filename_);
+	fo.setAppend(true);
+	setup(fo);
+	EXPECT_EQ(3, fo.size());
+	fo.writeLog(Level::info(), "", "two", Location());
+	fo.close();
+	ASSERT_EQ("onetwo", contents());
+}
+
+TEST_F(MappedFileOutputterTest, NonAppendTruncates)
+{
+	{
+		MappedFileOutputter fo(filename_);
+		setup(fo);
+		fo.writeLog(Level::info(), "", "one", Location());
+	}
+
+	MappedFileOutputter fo(filename_);
+	EXPECT_TRUE(fo.open());
+	fo.close();
+	ASSERT_EQ("", contents());
+}
+
+TEST_F(MappedFileOutputterTest, SetFilenameCloses)
+{
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one", Location());
+	fo.setFilename("xyz");
+	EXPECT_FALSE(fo.isOpen());
+	ASSERT_EQ("one", contents());
+}
+
+TEST_F(MappedFileOutputterTest, ConcurrentWritesKeepRecordsWhole)
+{
+	const int threads = 4;
+	const int records = 2000;
+	const string msg(100, 'x');
+
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+
+	vector<thread> writers;
+	for (int t=0;t<threads;++t)
+	{
+		writers.push_back(thread([&, t]() {
+			auto line = to_string(t) + msg + "\n";
+			for (int i=0;i<records;++i)
+				fo.writeLog(Level::info(), "", line, Location());
+		}));
+	}
+	for (auto &it : writers)
+		it.join();
+	fo.close();
+
+	ifstream file(filename_);
+	string line;
+	int count = 0;
+	while (getline(file, line))
+	{
+		EXPECT_EQ(msg.size() + 1, line.size());
+		EXPECT_EQ(string::npos, line.find_first_not_of('x', 1));
+		++count;
+	}
+	ASSERT_EQ(threads * records, count);
+}
+
+TEST_F(MappedFileOutputterTest, CloseWhileWritingIsSafe)
+{
+	MappedFileOutputter fo(filename_);
+	fo.setAppend(true);
+	setup(fo);
+
+	atomic<bool> done(false);
+	thread writer([&]() {
+		while (!done)
+			fo.writeLog(Level::info(), "", "test\n", Location());
+	});
+
+	for (int i=0;i<20;++i)
+	{
+		fo.close();
+		EXPECT_TRUE(fo.open());
+	}
+	done = true;
+	writer.join();
+	fo.close();
+
+	ASSERT_EQ(0, contents().size() % 5);
+}
+
+TEST_F(MappedFileOutputterTest, StopsWritingWhenTheFileIsFull)
+{
+	MappedFileOutputter fo(filename_);
+	setup(fo);
+
+	const string record(3000, 'x');
+	unsigned int records = 0;
+	while (fo.isOpen() && records < 100000)
+	{
+		fo.writeLog(Level::info(), "", record, Location());
+		++records;
+	}
+	EXPECT_FALSE(fo.isOpen());
+	EXPECT_EQ(1, fo.droppedCount());
+
+	// nothing after the dropped record is written
+	fo.writeLog(Level::info(), "", "late\n", Location());
+	fo.close();
+
+	// the file ends where the dropped record would have started
+	auto data = contents();
+	EXPECT_EQ((records - 1) * record.size(), data.size());
+	ASSERT_EQ(string::npos, data.find_first_not_of('x'));
+}
+
+#else
+
+TEST_F(MappedFileOutputterTest, OpenFailsOnWindows)
+{
+	MappedFileOutputter fo(filename_);
+	ASSERT_FALSE(fo.open());
+}
+
+#endif
@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "metricsreporter.h"
+#include "logger.h"
+#include "asyncoutputter.h"
+#include "standardlayout.h"
+#include "loggertest.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	string readFile(const string &filename)
+	{
+		ifstream f(filename);
+		stringstream text;
+		text << f.rdbuf();
+		return text.str();
+	}
+
+	// keeps every record, StringOutputter only keeps the last one
+	class RecordingOutputter : public Outputter
+	{
+	public:
+		bool open() final { return true; }
+
+		void writeLog(const Level &lev, const std::string &, const std::string &logMessage, const Location &) final
+		{
+			lock_guard<mutex> lock(mutex_);
+			records_.push_back(lev.name() + " " + logMessage);
+		}
+
+		void close() final { }
+
+		bool isOpen() const final { return true; }
+
+		vector<string> records() const
+		{
+			lock_guard<mutex> lock(mutex_);
+			return records_;
+		}
+
+	private:
+		mutable mutex mutex_;
+		vector<string> records_;
+	};
+}
+
+TEST(MetricsReporterTest, Defaults)
+{
+	MetricsReporter reporter;
+	EXPECT_EQ(MetricsReporter::DefaultInterval, reporter.interval());
+	EXPECT_EQ(string(MetricsReporter::LoggerName), reporter.logger()->name());
+	EXPECT_EQ(Level::INFO, reporter.level().level());
+	EXPECT_TRUE(reporter.prometheusFile().empty());
+	EXPECT_FALSE(reporter.isRunning());
+
+	reporter.setInterval(0);
+	EXPECT_EQ(1u, reporter.interval());
+
+	Logger::closeRootLogger();
+}
+
+TEST(MetricsReporterTest, ReportSumsUpTheInterval)
+{
+	auto metrics = make_shared<RecordingOutputter>();
+	auto log = Logger::logger("metrics.app");
+	auto counting = make_shared<CountingOutputter>();
+	log->addOutputter(counting);
+	log->setLevel(Level::info());
+
+	MetricsReporter reporter;
+	reporter.logger()->addOutputter(metrics);
+	reporter.logger()->setAdditivity(false);
+
+	for (int i=0;i<10;++i)
+		log->log(Level::info(), "counted");
+	log->log(Level::warn(), "counted");
+	log->log(Level::debug(), "filtered");
+
+	ASSERT_TRUE(reporter.report());
+	auto records = metrics->records();
+	ASSERT_EQ(1u, records.size());
+	auto &summary = records[0];
+	EXPECT_EQ(0u, summary.find("INFO metrics for "));
+	EXPECT_NE(string::npos, summary.find("warn "));
+	EXPECT_NE(string::npos, summary.find("info "));
+	EXPECT_NE(string::npos, summary.find("metrics.app#0 records/s "));
+	EXPECT_NE(string::npos, summary.find("filtered/s "));
+
+	// only what was counted since the last report
+	ASSERT_TRUE(reporter.report());
+	records = metrics->records();
+	ASSERT_EQ(2u, records.size());
+	EXPECT_EQ(string::npos, records[1].find("metrics.app#0"));
+
+	Logger::closeRootLogger();
+}
+
+TEST(MetricsReporterTest, SummaryUsesTheIntervalCounts)
+{
+	StatsSnapshot earlier;
+	StatsSnapshot::LoggerEntry logger;
+	logger.name = "app";
+	logger.stats.accepted = 100;
+	logger.stats.levels[Level::INFO] = 100;
+	earlier.loggers.push_back(logger);
+
+	auto now = earlier;
+	now.loggers[0].stats.accepted += 20;
+	now.loggers[0].stats.levels[Level::ERROR] = 20;
+
+	auto summary = MetricsReporter::summary(now, earlier, 2.0);
+	EXPECT_NE(string::npos, summary.find("metrics for 2.0s: records/s 10 ")) << summary;
+	EXPECT_NE(string::npos, summary.find("error 10 ")) << summary;
+	EXPECT_NE(string::npos, summary.find("info 0 ")) << summary;
+
+	// counters reset since the earlier snapshot count from 0
+	now.loggers[0].stats = LoggerStats();
+	now.loggers[0].stats.accepted = 4;
+	now.loggers[0].stats.levels[Level::INFO] = 4;
+	summary = MetricsReporter::summary(now, earlier, 2.0);
+	EXPECT_NE(string::npos, summary.find("records/s 2.0 ")) << summary;
+}
+
+TEST(MetricsReporterTest, WritesThePrometheusFile)
+{
+	const string filename = "metrics-test.prom";
+	remove(filename.c_str());
+
+	auto inner = make_shared<CountingOutputter>();
+	inner->setLayout(make_shared<StandardLayout>());
+	auto async = make_shared<AsyncOutputter>(inner, 64);
+	ASSERT_TRUE(async->open());
+	auto log = Logger::logger("metrics.\"quoted\"");
+	log->addOutputter(async);
+
+	MetricsReporter reporter;
+	reporter.setLogger(nullptr);
+	reporter.setPrometheusFile(filename);
+	EXPECT_EQ(filename, reporter.prometheusFile());
+
+	for (int i=0;i<3;++i)
+		log->log(Level::error(), "counted");
+	async->flush();
+
+	ASSERT_TRUE(reporter.report());
+	auto text = readFile(filename);
+	EXPECT_NE(string::npos, text.find("# TYPE sharklog_records_total counter\n"));
+	EXPECT_NE(string::npos, text.find("sharklog_records_total{logger=\"metrics.\\\"quoted\\\"\",level=\"error\"} 3\n")) << text;
+	EXPECT_NE(string::npos, text.find("sharklog_outputter_records_total{outputter=\"metrics.\\\"quoted\\\"#0.async\"} 3\n")) << text;
+	EXPECT_NE(string::npos, text.find("# TYPE sharklog_outputter_write_seconds summary\n"));
+	EXPECT_NE(string::npos, text.find("sharklog_queue_capacity{outputter=\"metrics.\\\"quoted\\\"#0\"} 64\n")) << text;
+	EXPECT_NE(string::npos, text.find("sharklog_queue_depth{"));
+	EXPECT_TRUE(readFile(filename + ".tmp").empty());
+
+	async->close();
+	Logger::closeRootLogger();
+	remove(filename.c_str());
+}
+
+TEST(MetricsReporterTest, FailedWritesAreReported)
+{
+	EXPECT_FALSE(MetricsReporter::writeFileAtomically("no-such-directory/metrics.prom", "text"));
+
+	auto metrics = make_shared<RecordingOutputter>();
+	MetricsReporter reporter;
+	reporter.logger()->addOutputter(metrics);
+	reporter.logger()->setAdditivity(false);
+	reporter.setPrometheusFile("no-such-directory/metrics.prom");
+
+	EXPECT_FALSE(reporter.report());
+	auto records = metrics->records();
+	ASSERT_EQ(2u, records.size());
+	EXPECT_EQ("ERROR could not write metrics to no-such-directory/metrics.prom", records[1]);
+
+	Logger::closeRootLogger();
+}
+
+TEST(MetricsReporterTest, ThreadReportsEveryInterval)
+{
+	auto metrics = make_shared<RecordingOutputter>();
+	MetricsReporter reporter;
+	reporter.logger()->addOutputter(metrics);
+	reporter.logger()->setAdditivity(false);
+	reporter.setInterval(10);
+
+	EXPECT_TRUE(reporter.start());
+	EXPECT_FALSE(reporter.start());
+	EXPECT_TRUE(reporter.isRunning());
+
+	for (int i=0;i<500 && metrics->records().size() < 3;++i)
+		this_thread::sleep_for(chrono::milliseconds(10));
+	reporter.stop();
+	EXPECT_FALSE(reporter.isRunning());
+	EXPECT_GE(metrics->records().size(), 3u);
+
+	// nothing after stop, and it can start again
+	auto reported = metrics->records().size();
+	this_thread::sleep_for(chrono::milliseconds(50));
+	EXPECT_EQ(reported, metrics->records().size());
+	EXPECT_TRUE(reporter.start());
+	reporter.stop();
+
+	Logger::closeRootLogger();
+}
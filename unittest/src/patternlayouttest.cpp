@@ -0,0 +1,226 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "patternlayout.h"
+#include "recordcontext.h"
+#include "level.h"
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <sstream>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	const long long RecordMs = 1500000000123LL;
+
+	// formats a record logged at RecordMs
+	string format(const string &pattern, const Level &lev=Level::info(), const string &name="com.sharklog.test",
+		const string &msg="message", const Location &loc=Location())
+	{
+		RecordContext ctx(RecordContext::Clock::time_point(milliseconds(RecordMs)), this_thread::get_id());
+		RecordContext::Scope pin(ctx);
+		PatternLayout layout(pattern);
+		string s;
+		layout.formatRecord(s, lev, name, msg, loc);
+		return s;
+	}
+
+	string localTime(const char *format)
+	{
+		time_t secs = (time_t)(RecordMs / 1000);
+		tm t;
+		localtime_r(&secs, &t);
+		char buf[100];
+		strftime(buf, sizeof(buf), format, &t);
+		return buf;
+	}
+
+	string threadId()
+	{
+		stringstream ss;
+		ss << "0x" << hex << this_thread::get_id();
+		return ss.str();
+	}
+}
+
+TEST(PatternLayoutTest, PatternIsKept)
+{
+	PatternLayout layout("%m%n");
+	ASSERT_STREQ("%m%n", layout.pattern().c_str());
+}
+
+TEST(PatternLayoutTest, DefaultPattern)
+{
+	auto s = format(PatternLayout::DefaultPattern);
+	auto expected = localTime("%Y-%m-%d %H:%M:%S") + ",123 INFO  [" + threadId() + "] com.sharklog.test - message\n";
+	ASSERT_EQ(expected, s);
+}
+
+TEST(PatternLayoutTest, LiteralTextIsCopied)
+{
+	ASSERT_EQ("just text", format("just text"));
+}
+
+TEST(PatternLayoutTest, PercentEscape)
+{
+	ASSERT_EQ("100% message", format("100%% %m"));
+}
+
+TEST(PatternLayoutTest, UnknownFieldIsCopied)
+{
+	ASSERT_EQ("%q message %", format("%q %m %"));
+}
+
+TEST(PatternLayoutTest, MessageAndNewLine)
+{
+	ASSERT_EQ("hello\n", format("%m%n", Level::info(), "", "hello"));
+}
+
+TEST(PatternLayoutTest, LevelName)
+{
+	EXPECT_EQ("FATAL", format("%p", Level::fatal()));
+	ASSERT_EQ("DEBUG", format("%p", Level::debug()));
+}
+
+TEST(PatternLayoutTest, LevelPadding)
+{
+	EXPECT_EQ("[WARN ]", format("[%-5p]", Level::warn()));
+	EXPECT_EQ("[ WARN]", format("[%5p]", Level::warn()));
+	ASSERT_EQ("[ERROR]", format("[%-5p]", Level::error()));
+}
+
+TEST(PatternLayoutTest, Truncating)
+{
+	ASSERT_EQ("test", format("%.4c"));
+}
+
+TEST(PatternLayoutTest, LoggerName)
+{
+	ASSERT_EQ("com.sharklog.test", format("%c"));
+}
+
+TEST(PatternLayoutTest, LoggerNameAbbreviation)
+{
+	EXPECT_EQ("test", format("%c{1}"));
+	EXPECT_EQ("sharklog.test", format("%c{2}"));
+	EXPECT_EQ("com.sharklog.test", format("%c{3}"));
+	EXPECT_EQ("com.sharklog.test", format("%c{10}"));
+	ASSERT_EQ("single", format("%c{1}", Level::info(), "single"));
+}
+
+TEST(PatternLayoutTest, LoggerNameAbbreviationWithoutDots)
+{
+	// the root logger has no name
+	EXPECT_EQ(" hello", format("%c{1} %m", Level::info(), "", "hello"));
+	EXPECT_EQ("", format("%c{2}", Level::info(), ""));
+	EXPECT_EQ("single", format("%c{3}", Level::info(), "single"));
+	ASSERT_EQ("", format("%c{1}", Level::info(), "trailing."));
+}
+
+TEST(PatternLayoutTest, ThreadId)
+{
+	ASSERT_EQ(threadId(), format("%t"));
+}
+
+TEST(PatternLayoutTest, SourceLocation)
+{
+	Location loc("main.cpp", "int main()", 42);
+	EXPECT_EQ("main.cpp:42 int main()", format("%F:%L %M", Level::info(), "", "", loc));
+	ASSERT_EQ("int main()(main.cpp:42)", format("%l", Level::info(), "", "", loc));
+}
+
+TEST(PatternLayoutTest, MissingLocationIsEmpty)
+{
+	ASSERT_EQ("[:] []", format("[%F:%L] [%l]"));
+}
+
+TEST(PatternLayoutTest, FormatMessageHasNoLocation)
+{
+	PatternLayout layout("%p %F%m");
+	string s;
+	layout.formatMessage(s, Level::trace(), "", "message");
+	ASSERT_EQ("TRACE message", s);
+}
+
+TEST(PatternLayoutTest, Iso8601Date)
+{
+	auto expected = localTime("%Y-%m-%d %H:%M:%S") + ",123";
+	EXPECT_EQ(expected, format("%d"));
+	ASSERT_EQ(expected, format("%d{ISO8601}"));
+}
+
+TEST(PatternLayoutTest, AbsoluteAndDateFormats)
+{
+	EXPECT_EQ(localTime("%H:%M:%S") + ",123", format("%d{ABSOLUTE}"));
+	ASSERT_EQ(localTime("%d %b %Y %H:%M:%S") + ",123", format("%d{DATE}"));
+}
+
+TEST(PatternLayoutTest, CustomDateFormat)
+{
+	EXPECT_EQ(localTime("%m/%d/%Y %H:%M:%S") + ".123", format("%d{%m/%d/%Y %H:%M:%S.%f}"));
+	ASSERT_EQ("123-" + localTime("%S") + "-123", format("%d{%f-%S-%f}"));
+}
+
+TEST(PatternLayoutTest, DateMillisecondsChangeWithinASecond)
+{
+	PatternLayout layout("%d{%S.%f}");
+	string first, second;
+	{
+		RecordContext ctx(RecordContext::Clock::time_point(milliseconds(RecordMs)), this_thread::get_id());
+		RecordContext::Scope pin(ctx);
+		layout.formatRecord(first, Level::info(), "", "", Location());
+	}
+	{
+		RecordContext ctx(RecordContext::Clock::time_point(milliseconds(RecordMs + 850)), this_thread::get_id());
+		RecordContext::Scope pin(ctx);
+		layout.formatRecord(second, Level::info(), "", "", Location());
+	}
+	EXPECT_EQ(localTime("%S") + ".123", first);
+	ASSERT_EQ(localTime("%S") + ".973", second);
+}
+
+TEST(PatternLayoutTest, ElapsedTime)
+{
+	PatternLayout layout("%r");
+	RecordContext ctx(RecordContext::Clock::now() + milliseconds(1500), this_thread::get_id());
+	RecordContext::Scope pin(ctx);
+	string s;
+	layout.formatRecord(s, Level::info(), "", "", Location());
+	auto elapsed = atoi(s.c_str());
+	EXPECT_GE(elapsed, 1500);
+	ASSERT_LT(elapsed, 2500);
+}
+
+TEST(PatternLayoutTest, FullPattern)
+{
+	Location loc("src/main.cpp", "int main()", 7);
+	auto s = format("%d{ISO8601} %-5p %c{1} [%t] %F:%L %m%n", Level::warn(), "com.sharklog.test", "hi", loc);
+	auto expected = localTime("%Y-%m-%d %H:%M:%S") + ",123 WARN  test [" + threadId() + "] src/main.cpp:7 hi\n";
+	ASSERT_EQ(expected, s);
+}
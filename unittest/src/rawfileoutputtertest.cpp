@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "fileoutputtertest.h"
+#include "rawfileoutputter.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+class RawFileOutputterTest : public OutputFileTest
+{
+protected:
+	RawFileOutputterTest() : OutputFileTest("test-rawfile-41985.tmp") { }
+
+	void setup(RawFileOutputter &fo)
+	{
+		fo.setFlushInterval(0);
+		OutputFileTest::setup(fo);
+	}
+};
+
+TEST_F(RawFileOutputterTest, Defaults)
+{
+	RawFileOutputter fo("test");
+	EXPECT_EQ("test", fo.filename());
+	EXPECT_FALSE(fo.append());
+	EXPECT_FALSE(fo.isOpen());
+	EXPECT_EQ(RawFileOutputter::DefaultFlushBytes, fo.flushBytes());
+	EXPECT_EQ(0, fo.flushRecords());
+	EXPECT_EQ(RawFileOutputter::DefaultFlushInterval, fo.flushInterval());
+	ASSERT_EQ(Level::ERROR, fo.flushLevel().level());
+}
+
+TEST_F(RawFileOutputterTest, OpenAndCloseWork)
+{
+	RawFileOutputter fo(filename_);
+	EXPECT_TRUE(fo.open());
+	EXPECT_TRUE(fo.isOpen());
+	fo.close();
+	ASSERT_FALSE(fo.isOpen());
+}
+
+TEST_F(RawFileOutputterTest, OpenFailsForBadPath)
+{
+	RawFileOutputter fo("no-such-dir-41985/test.log");
+	EXPECT_FALSE(fo.open());
+	ASSERT_FALSE(fo.isOpen());
+}
+
+TEST_F(RawFileOutputterTest, BuffersUntilClose)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one\n", Location());
+	fo.writeLog(Level::info(), "", "two\n", Location());
+	EXPECT_EQ("", contents());
+	EXPECT_EQ(0, fo.writeCount());
+
+	fo.close();
+	EXPECT_EQ("one\ntwo\n", contents());
+	ASSERT_EQ(1, fo.writeCount());
+}
+
+TEST_F(RawFileOutputterTest, FlushWritesBuffer)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one\n", Location());
+	fo.flush();
+	ASSERT_EQ("one\n", contents());
+}
+
+TEST_F(RawFileOutputterTest, FlushBytesCoalescesRecords)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.setFlushBytes(10);
+
+	// three fit, the fourth goes out with them in one call
+	for (int i=0;i<4;++i)
+		fo.writeLog(Level::info(), "", "abc", Location());
+	EXPECT_EQ("abcabcabcabc", contents());
+	EXPECT_EQ(1, fo.writeCount());
+
+	fo.writeLog(Level::info(), "", "0123456789abc", Location());
+	EXPECT_EQ(2, fo.writeCount());
+	ASSERT_EQ("abcabcabcabc0123456789abc", contents());
+}
+
+TEST_F(RawFileOutputterTest, FlushRecordsWorks)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.setFlushRecords(3);
+
+	fo.writeLog(Level::info(), "", "a", Location());
+	fo.writeLog(Level::info(), "", "b", Location());
+	EXPECT_EQ("", contents());
+	fo.writeLog(Level::info(), "", "c", Location());
+	EXPECT_EQ("abc", contents());
+	ASSERT_EQ(1, fo.writeCount());
+}
+
+TEST_F(RawFileOutputterTest, FlushIntervalWorks)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.setFlushInterval(20);
+
+	fo.writeLog(Level::info(), "", "a", Location());
+	EXPECT_EQ("", contents());
+	this_thread::sleep_for(chrono::milliseconds(30));
+	fo.writeLog(Level::info(), "", "b", Location());
+	ASSERT_EQ("ab", contents());
+}
+
+TEST_F(RawFileOutputterTest, ErrorsFlushImmediately)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+
+	fo.writeLog(Level::warn(), "", "w", Location());
+	EXPECT_EQ("", contents());
+	fo.writeLog(Level::error(), "", "e", Location());
+	EXPECT_EQ("we", contents());
+	fo.writeLog(Level::fatal(), "", "f", Location());
+	ASSERT_EQ("wef", contents());
+}
+
+TEST_F(RawFileOutputterTest, FlushLevelCanBeChanged)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+
+	fo.setFlushLevel(Level::warn());
+	fo.writeLog(Level::warn(), "", "w", Location());
+	EXPECT_EQ("w", contents());
+
+	fo.setFlushLevel(Level());
+	fo.writeLog(Level::fatal(), "", "f", Location());
+	ASSERT_EQ("w", contents());
+}
+
+TEST_F(RawFileOutputterTest, AppendModeWorks)
+{
+	{
+		RawFileOutputter fo(filename_);
+		setup(fo);
+		fo.writeLog(Level::info(), "", "one", Location());
+	}
+
+	RawFileOutputter fo(filename_);
+	fo.setAppend(true);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "two", Location());
+	fo.close();
+	EXPECT_EQ("onetwo", contents());
+
+	EXPECT_TRUE(fo.open());
+	ASSERT_EQ("onetwo", contents());
+}
+
+TEST_F(RawFileOutputterTest, NonAppendTruncates)
+{
+	{
+		RawFileOutputter fo(filename_);
+		setup(fo);
+		fo.writeLog(Level::info(), "", "one", Location());
+	}
+
+	RawFileOutputter fo(filename_);
+	EXPECT_TRUE(fo.open());
+	fo.close();
+	ASSERT_EQ("", contents());
+}
+
+TEST_F(RawFileOutputterTest, SetFilenameWritesAndCloses)
+{
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.writeLog(Level::info(), "", "one", Location());
+	fo.setFilename("xyz");
+	EXPECT_FALSE(fo.isOpen());
+	ASSERT_EQ("one", contents());
+}
+
+TEST_F(RawFileOutputterTest, ConcurrentWritesKeepRecordsWhole)
+{
+	const int threads = 4;
+	const int records = 2000;
+	const string msg(100, 'x');
+
+	RawFileOutputter fo(filename_);
+	setup(fo);
+	fo.setFlushBytes(1000);
+
+	vector<thread> writers;
+	for (int t=0;t<threads;++t)
+	{
+		writers.push_back(thread([&, t]() {
+			auto line = to_string(t) + msg + "\n";
+			for (int i=0;i<records;++i)
+				fo.writeLog(Level::info(), "", line, Location());
+		}));
+	}
+	for (auto &it : writers)
+		it.join();
+	fo.close();
+
+	ifstream file(filename_);
+	string line;
+	int count = 0;
+	while (getline(file, line))
+	{
+		EXPECT_EQ(msg.size() + 1, line.size());
+		EXPECT_EQ(string::npos, line.find_first_not_of('x', 1));
+		++count;
+	}
+	ASSERT_EQ(threads * records, count);
+}
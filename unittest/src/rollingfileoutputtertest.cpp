@@ -0,0 +1,325 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "fileoutputtertest.h"
+#include "rollingfileoutputter.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <ctime>
+
+using namespace sharklog;
+using namespace std;
+using namespace std::chrono;
+
+class RollingFileOutputterTest : public OutputFileTest
+{
+protected:
+	RollingFileOutputterTest() : OutputFileTest("test-rolling-41987.log") { }
+
+	void TearDown() override
+	{
+		for (auto &it : archives_)
+			remove(it.c_str());
+		OutputFileTest::TearDown();
+	}
+
+	bool exists(const std::string &filename)
+	{
+		return ifstream(filename).is_open();
+	}
+
+	void setup(RollingFileOutputter &fo, std::uint64_t maxSize, unsigned int maxArchives = 0)
+	{
+		fo.setMaxFileSize(maxSize);
+		fo.setMaxArchives(maxArchives);
+		fo.setCompress(false);
+		OutputFileTest::setup(fo);
+	}
+
+	// closes and remembers the archives so TearDown removes them
+	std::vector<std::string> finish(RollingFileOutputter &fo)
+	{
+		fo.close();
+		auto archives = fo.archives();
+		archives_.insert(archives_.end(), archives.begin(), archives.end());
+		return archives;
+	}
+
+	system_clock::time_point localTime(int year, int month, int day, int hour, int min, int sec)
+	{
+		tm t = tm();
+		t.tm_year = year - 1900;
+		t.tm_mon = month - 1;
+		t.tm_mday = day;
+		t.tm_hour = hour;
+		t.tm_min = min;
+		t.tm_sec = sec;
+		t.tm_isdst = -1;
+		return system_clock::from_time_t(mktime(&t));
+	}
+
+	std::vector<std::string> archives_;
+};
+
+TEST_F(RollingFileOutputterTest, Defaults)
+{
+	RollingFileOutputter fo("test");
+	EXPECT_EQ("test", fo.filename());
+	EXPECT_FALSE(fo.append());
+	EXPECT_FALSE(fo.isOpen());
+	EXPECT_EQ(RollingFileOutputter::DefaultMaxFileSize, fo.maxFileSize());
+	EXPECT_EQ(RollingFileOutputter::DefaultMaxArchives, fo.maxArchives());
+	EXPECT_EQ(RollingFileOutputter::Never, fo.rollInterval());
+	ASSERT_EQ(RollingFileOutputter::compressionAvailable(), fo.compress());
+}
+
+TEST_F(RollingFileOutputterTest, OpenFailsForBadPath)
+{
+	RollingFileOutputter fo("no-such-dir-41987/test.log");
+	EXPECT_FALSE(fo.open());
+	ASSERT_FALSE(fo.isOpen());
+}
+
+TEST_F(RollingFileOutputterTest, RollsOverBySize)
+{
+	RollingFileOutputter fo(filename_);
+	setup(fo, 10);
+	for (int i=0;i<5;++i)
+		fo.writeLog(Level::info(), "", "abcd\n", Location());
+
+	auto archives = finish(fo);
+	ASSERT_EQ(2, archives.size());
+	EXPECT_LT(archives[0], archives[1]);
+	EXPECT_EQ(0, archives[0].find(filename_ + "."));
+	EXPECT_EQ("abcd\nabcd\n", contents(archives[0]));
+	EXPECT_EQ("abcd\nabcd\n", contents(archives[1]));
+	ASSERT_EQ("abcd\n", contents(filename_));
+}
+
+TEST_F(RollingFileOutputterTest, BigRecordsStillGetWritten)
+{
+	RollingFileOutputter fo(filename_);
+	setup(fo, 4);
+	fo.writeLog(Level::info(), "", "0123456789", Location());
+	fo.writeLog(Level::info(), "", "abcdefghij", Location());
+
+	auto archives = finish(fo);
+	ASSERT_EQ(1, archives.size());
+	EXPECT_EQ("0123456789", contents(archives[0]));
+	ASSERT_EQ("abcdefghij", contents(filename_));
+}
+
+TEST_F(RollingFileOutputterTest, RollOverWorks)
+{
+	RollingFileOutputter fo(filename_);
+	setup(fo, 0);
+	fo.writeLog(Level::info(), "", "one", Location());
+	fo.rollOver();
+	fo.writeLog(Level::info(), "", "two", Location());
+
+	auto archives = finish(fo);
+	ASSERT_EQ(1, archives.size());
+	EXPECT_EQ("one", contents(archives[0]));
+	ASSERT_EQ("two", contents(filename_));
+}
+
+TEST_F(RollingFileOutputterTest, KeepsMaxArchives)
+{
+	RollingFileOutputter fo(filename_);
+	setup(fo, 0, 0);
+	vector<string> all;
+	for (int i=0;i<5;++i)
+	{
+		fo.writeLog(Level::info(), "", to_string(i), Location());
+		fo.rollOver();
+	}
+	fo.close();
+	all = fo.archives();
+	archives_ = all;
+	ASSERT_EQ(5, all.size());
+
+	fo.setMaxArchives(2);
+	auto archives = fo.archives();
+	ASSERT_EQ(2, archives.size());
+	EXPECT_EQ("3", contents(archives[0]));
+	EXPECT_EQ("4", contents(archives[1]));
+	for (int i=0;i<3;++i)
+		EXPECT_FALSE(exists(all[i])) << all[i];
+}
+
+TEST_F(RollingFileOutputterTest, FindsArchivesFromEarlierRuns)
+{
+	{
+		RollingFileOutputter fo(filename_);
+		setup(fo, 0);
+		for (int i=0;i<3;++i)
+		{
+			fo.writeLog(Level::info(), "", to_string(i), Location());
+			fo.rollOver();
+		}
+		finish(fo);
+	}
+
+	RollingFileOutputter fo(filename_);
+	setup(fo, 0, 0);
+	EXPECT_EQ(archives_, fo.archives());
+
+	fo.setMaxArchives(1);
+	auto archives = fo.archives();
+	ASSERT_EQ(1, archives.size());
+	ASSERT_EQ("2", contents(archives[0]));
+}
+
+TEST_F(RollingFileOutputterTest, OnlyPrunesItsOwnArchives)
+{
+	// files that only start like an archive belong to someone else
+	const vector<string> foreign = { filename_ + ".1", filename_ + ".20170101-000000", filename_ + ".20170101-000000-000.bak" };
+	for (auto &it : foreign)
+	{
+		ofstream(it) << "keep";
+		archives_.push_back(it);
+	}
+
+	RollingFileOutputter fo(filename_);
+	setup(fo, 0, 1);
+	for (int i=0;i<3;++i)
+	{
+		fo.writeLog(Level::info(), "", to_string(i), Location());
+		fo.rollOver();
+	}
+	auto archives = finish(fo);
+
+	ASSERT_EQ(1, archives.size());
+	EXPECT_EQ("2", contents(archives[0]));
+	for (auto &it : foreign)
+		EXPECT_EQ("keep", contents(it)) << it;
+}
+
+TEST_F(RollingFileOutputterTest, CompressesArchives)
+{
+	if (!RollingFileOutputter::compressionAvailable())
+		return;
+
+	RollingFileOutputter fo(filename_);
+	setup(fo, 0);
+	fo.setCompress(true);
+	fo.writeLog(Level::info(), "", string(1000, 'x'), Location());
+	fo.rollOver();
+
+	auto archives = finish(fo);
+	ASSERT_EQ(1, archives.size());
+	auto gz = archives[0];
+	EXPECT_EQ(gz.size() - 3, gz.rfind(".gz"));
+	EXPECT_FALSE(exists(gz.substr(0, gz.size() - 3)));
+
+	// gzip magic and smaller than what went in
+	auto data = contents(gz);
+	ASSERT_GT(data.size(), 2);
+	EXPECT_EQ('\x1f', data[0]);
+	EXPECT_EQ('\x8b', data[1]);
+	ASSERT_LT(data.size(), 1000);
+}
+
+TEST_F(RollingFileOutputterTest, AppendCountsExistingSize)
+{
+	{
+		RollingFileOutputter fo(filename_);
+		setup(fo, 0);
+		fo.writeLog(Level::info(), "", "12345678", Location());
+		finish(fo);
+	}
+
+	RollingFileOutputter fo(filename_);
+	fo.setAppend(true);
+	setup(fo, 10);
+	fo.writeLog(Level::info(), "", "abcde", Location());
+
+	auto archives = finish(fo);
+	ASSERT_EQ(1, archives.size());
+	EXPECT_EQ("12345678", contents(archives[0]));
+	ASSERT_EQ("abcde", contents(filename_));
+}
+
+TEST_F(RollingFileOutputterTest, NextRollTimeWorks)
+{
+	auto now = localTime(2017, 4, 12, 15, 30, 20);
+	auto never = RollingFileOutputter::nextRollTime(now, RollingFileOutputter::Never);
+	EXPECT_EQ(system_clock::time_point::max(), never);
+
+	auto hourly = RollingFileOutputter::nextRollTime(now, RollingFileOutputter::Hourly);
+	EXPECT_EQ(localTime(2017, 4, 12, 16, 0, 0), hourly);
+
+	auto daily = RollingFileOutputter::nextRollTime(now, RollingFileOutputter::Daily);
+	EXPECT_EQ(localTime(2017, 4, 13, 0, 0, 0), daily);
+
+	// the end of the month and year carry over
+	auto late = localTime(2017, 12, 31, 23, 59, 59);
+	EXPECT_EQ(localTime(2018, 1, 1, 0, 0, 0), RollingFileOutputter::nextRollTime(late, RollingFileOutputter::Hourly));
+	ASSERT_EQ(localTime(2018, 1, 1, 0, 0, 0), RollingFileOutputter::nextRollTime(late, RollingFileOutputter::Daily));
+}
+
+TEST_F(RollingFileOutputterTest, ConcurrentWritesAcrossRollOvers)
+{
+	const int threads = 4;
+	const int records = 1000;
+	const string msg(18, 'x');
+
+	RollingFileOutputter fo(filename_);
+	setup(fo, 4096);
+
+	vector<thread> writers;
+	for (int t=0;t<threads;++t)
+	{
+		writers.push_back(thread([&, t]() {
+			auto line = to_string(t) + msg + "\n";
+			for (int i=0;i<records;++i)
+				fo.writeLog(Level::info(), "", line, Location());
+		}));
+	}
+	for (auto &it : writers)
+		it.join();
+
+	auto files = finish(fo);
+	EXPECT_GT(files.size(), 1);
+	files.push_back(filename_);
+
+	int count = 0;
+	for (auto &it : files)
+	{
+		EXPECT_LE(contents(it).size(), 4096);
+
+		ifstream file(it);
+		string line;
+		while (getline(file, line))
+		{
+			EXPECT_EQ(msg.size() + 1, line.size());
+			EXPECT_EQ(string::npos, line.find_first_not_of('x', 1));
+			++count;
+		}
+	}
+	ASSERT_EQ(threads * records, count);
+}
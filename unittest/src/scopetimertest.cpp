@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "scopetimer.h"
+#include "logger.h"
+#include "standardlayout.h"
+#include "loggertest.h"
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace sharklog;
+using namespace std;
+
+// each use is its own call site, a site only looks its name up once
+#define TIMED(log, name, sleepMicros) { \
+	SHARKLOG_SCOPE_TIMER(log, name); \
+	if (sleepMicros) \
+		this_thread::sleep_for(chrono::microseconds(sleepMicros)); \
+	}
+
+TEST(ScopeTimerTest, ScopeIsRegisteredOnce)
+{
+	auto scope = ScopeStats::scope("scopetimer.once");
+	EXPECT_EQ(scope, ScopeStats::scope("scopetimer.once"));
+	EXPECT_EQ("scopetimer.once", scope->name());
+	EXPECT_NE(scope, ScopeStats::scope("scopetimer.other"));
+
+	auto all = ScopeStats::all();
+	EXPECT_NE(all.end(), find(all.begin(), all.end(), scope));
+}
+
+TEST(ScopeTimerTest, DisabledTimerRecordsNothing)
+{
+	auto log = Logger::logger("scopetimer.disabled");
+	log->setLevel(Level::info());
+
+	for (int i=0;i<10;++i)
+		TIMED(log, "scopetimer.disabled", 0);
+
+	// the name is only looked up once the level check passes
+	for (auto scope : ScopeStats::all())
+		EXPECT_NE("scopetimer.disabled", scope->name());
+
+	Logger::closeRootLogger();
+}
+
+TEST(ScopeTimerTest, EnabledTimerRecordsEveryPass)
+{
+	auto log = Logger::logger("scopetimer.enabled");
+	log->setLevel(Level::debug());
+
+	vector<thread> threads;
+	for (int t=0;t<4;++t)
+	{
+		threads.push_back(thread([&]() {
+			for (int i=0;i<100;++i)
+				TIMED(log, "scopetimer.enabled", 0);
+		}));
+	}
+	for (auto &it : threads)
+		it.join();
+	TIMED(log, "scopetimer.enabled", 2000);
+
+	auto summary = ScopeStats::scope("scopetimer.enabled")->summary();
+	EXPECT_EQ(401u, summary.count);
+	EXPECT_GE(summary.maxNanos, 2000000u);
+	EXPECT_GE(summary.totalNanos, summary.maxNanos);
+	EXPECT_LE(summary.p50Nanos, summary.p99Nanos);
+	EXPECT_LE(summary.p99Nanos, summary.maxNanos);
+
+	ScopeStats::scope("scopetimer.enabled")->reset();
+	EXPECT_EQ(0u, ScopeStats::scope("scopetimer.enabled")->summary().count);
+	EXPECT_EQ(0u, ScopeStats::scope("scopetimer.enabled")->summary().maxNanos);
+
+	Logger::closeRootLogger();
+}
+
+TEST(ScopeTimerTest, SlowPassesAreLogged)
+{
+	auto log = Logger::logger("scopetimer.threshold");
+	auto op = make_shared<StringOutputter>();
+	op->setLayout(make_shared<StandardLayout>());
+	log->addOutputter(op);
+	log->setLevel(Level::debug());
+
+	auto scope = ScopeStats::scope("scopetimer.threshold");
+	EXPECT_EQ(0u, scope->logThreshold());
+	TIMED(log, "scopetimer.threshold", 2000);
+	EXPECT_TRUE(op->output_.empty());
+
+	scope->setLogThreshold(1000000);
+	EXPECT_EQ(1000000u, scope->logThreshold());
+	TIMED(log, "scopetimer.threshold", 0);
+	EXPECT_TRUE(op->output_.empty());
+
+	TIMED(log, "scopetimer.threshold", 2000);
+	EXPECT_NE(string::npos, op->output_.find("[DEBUG] scopetimer.threshold took ")) << op->output_;
+	EXPECT_NE(string::npos, op->output_.find(", over 1.0ms")) << op->output_;
+
+	Logger::closeRootLogger();
+}
+
+TEST(ScopeTimerTest, TopSortsTheSlowestFirst)
+{
+	ScopeStats::resetAll();
+
+	auto log = Logger::logger("scopetimer.top");
+	log->setLevel(Level::debug());
+
+	for (int i=0;i<20;++i)
+		TIMED(log, "scopetimer.top.many", 100);
+	TIMED(log, "scopetimer.top.slow", 50000);
+	TIMED(log, "scopetimer.top.fast", 0);
+
+	auto byTotal = ScopeStats::top(2);
+	ASSERT_EQ(2u, byTotal.size());
+	EXPECT_EQ("scopetimer.top.slow", byTotal[0].name);
+	EXPECT_EQ("scopetimer.top.many", byTotal[1].name);
+	EXPECT_EQ(20u, byTotal[1].count);
+
+	auto byMax = ScopeStats::top(0, ScopeStats::ByMax);
+	ASSERT_EQ(3u, byMax.size());
+	EXPECT_EQ("scopetimer.top.slow", byMax[0].name);
+	EXPECT_EQ("scopetimer.top.fast", byMax[2].name);
+
+	ostringstream out;
+	ScopeStats::writeTop(out, 10, ScopeStats::ByPercentile99);
+	EXPECT_EQ(0u, out.str().find("scopetimer.top.slow")) << out.str();
+	EXPECT_NE(string::npos, out.str().find(" p99 ")) << out.str();
+
+	Logger::closeRootLogger();
+}
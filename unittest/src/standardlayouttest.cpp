@@ -25,10 +25,42 @@
 #include "standardlayouttest.h"
 #include "standardlayout.h"
 #include "level.h"
+#include "recordcontext.h"
 #include <regex>
+#include <ctime>
+#include <cstdio>
+#include <chrono>
+#include <thread>
 
 using namespace sharklog;
 using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	// header for a record logged at \a ms after the epoch
+	string headerAt(long long ms)
+	{
+		RecordContext ctx(RecordContext::Clock::time_point(milliseconds(ms)), this_thread::get_id());
+		RecordContext::Scope pin(ctx);
+		StandardLayout layout;
+		string s;
+		layout.appendHeader(s);
+		return s;
+	}
+
+	string expectedTimestamp(long long ms)
+	{
+		time_t secs = (time_t)(ms / 1000);
+		tm t;
+		localtime_r(&secs, &t);
+		char buf[64];
+		strftime(buf, sizeof(buf), "[%m/%d/%Y][%H:%M:%S.", &t);
+		char millis[8];
+		snprintf(millis, sizeof(millis), "%03d]", (int)(ms % 1000));
+		return string(buf) + millis;
+	}
+}
 
 TEST_F(StandardLayoutTest, AppendHeaderWorks)
 {
@@ -82,3 +114,48 @@ TEST_F(StandardLayoutTest, InvalidLevelWorks)
     auto re = regex("^\\[NONE\\] .*\n");
     ASSERT_TRUE(regex_match(s.c_str(), re)) << s.c_str();
 }
+
+TEST_F(StandardLayoutTest, HeaderUsesRecordTime)
+{
+    const long long ms = 1500000000123LL;
+    auto s = headerAt(ms);
+    ASSERT_EQ(expectedTimestamp(ms), s.substr(0, 26)) << s;
+}
+
+TEST_F(StandardLayoutTest, SameSecondOnlyChangesMilliseconds)
+{
+    const long long second = 1500000000000LL;
+    auto first = headerAt(second + 5);
+    auto second2 = headerAt(second + 987);
+    EXPECT_EQ(expectedTimestamp(second + 5), first.substr(0, 26));
+    ASSERT_EQ(expectedTimestamp(second + 987), second2.substr(0, 26));
+}
+
+TEST_F(StandardLayoutTest, NextSecondUpdatesTime)
+{
+    const long long ms = 1500000000999LL;
+    auto before = headerAt(ms);
+    auto after = headerAt(ms + 1);
+    EXPECT_EQ(expectedTimestamp(ms), before.substr(0, 26));
+    EXPECT_EQ(expectedTimestamp(ms + 1), after.substr(0, 26));
+    ASSERT_NE(before.substr(0, 26), after.substr(0, 26));
+}
+
+TEST_F(StandardLayoutTest, GoingBackInTimeUpdatesTime)
+{
+    const long long ms = 1500000000500LL;
+    headerAt(ms + 86400000LL);
+    auto s = headerAt(ms);
+    ASSERT_EQ(expectedTimestamp(ms), s.substr(0, 26));
+}
+
+TEST_F(StandardLayoutTest, ThreadsKeepTheirOwnTimestamps)
+{
+    const long long ms = 1500000000250LL;
+    headerAt(ms);
+    string other;
+    thread t([&]() { other = headerAt(ms + 3600000LL); });
+    t.join();
+    EXPECT_EQ(expectedTimestamp(ms + 3600000LL), other.substr(0, 26));
+    ASSERT_EQ(expectedTimestamp(ms + 1), headerAt(ms + 1).substr(0, 26));
+}
@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "stats.h"
+#include "logger.h"
+#include "fileoutputter.h"
+#include "rawfileoutputter.h"
+#include "asyncoutputter.h"
+#include "standardlayout.h"
+#include "loggertest.h"
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	long long fileSize(const string &filename)
+	{
+		ifstream f(filename, ios::binary | ios::ate);
+		return f.tellg();
+	}
+}
+
+TEST(StatsTest, ShardedCountersAddUpEveryThread)
+{
+	ShardedCounters counters;
+	EXPECT_EQ(0u, counters.total(0));
+	EXPECT_GE(ShardedCounters::shardCount(), 9u);
+
+	vector<thread> threads;
+	for (int t=0;t<8;++t)
+	{
+		threads.push_back(thread([&]() {
+			for (int i=0;i<10000;++i)
+			{
+				counters.add(0);
+				counters.add(3, 2);
+			}
+		}));
+	}
+	for (auto &it : threads)
+		it.join();
+
+	EXPECT_EQ(80000u, counters.total(0));
+	EXPECT_EQ(160000u, counters.total(3));
+	EXPECT_EQ(0u, counters.total(1));
+
+	counters.reset();
+	EXPECT_EQ(0u, counters.total(0));
+	EXPECT_EQ(0u, counters.total(3));
+}
+
+TEST(StatsTest, ThreadsPastTheShardsShareOne)
+{
+	ShardedCounters counters;
+	const unsigned int count = (unsigned int)ShardedCounters::shardCount() * 2;
+
+	// all alive at once so some of them can't have a shard of their own
+	atomic<unsigned int> started(0);
+	vector<thread> threads;
+	for (unsigned int t=0;t<count;++t)
+	{
+		threads.push_back(thread([&]() {
+			counters.add(1);
+			++started;
+			while (started.load() < count)
+				this_thread::yield();
+			for (int i=0;i<1000;++i)
+				counters.add(1);
+		}));
+	}
+	for (auto &it : threads)
+		it.join();
+
+	EXPECT_EQ(count * 1001u, counters.total(1));
+}
+
+TEST(StatsTest, HistogramBucketsAreAQuarterOfAPowerOf2)
+{
+	// every value is in the bucket whose limit is the first one at or above it
+	for (std::uint64_t v=0;v<100000;++v)
+	{
+		auto b = ShardedHistogram::bucket(v);
+		ASSERT_LE(v, ShardedHistogram::bucketLimit(b)) << v;
+		if (b)
+		{
+			ASSERT_GT(v, ShardedHistogram::bucketLimit(b - 1)) << v;
+		}
+	}
+	EXPECT_EQ(1279u, ShardedHistogram::bucketLimit(ShardedHistogram::bucket(1100)));
+	EXPECT_EQ(ShardedHistogram::BucketCount - 1, ShardedHistogram::bucket(~0ull));
+
+	ShardedHistogram histogram;
+	for (std::uint64_t v=1;v<=100;++v)
+		histogram.record(ShardedCounters::threadSlot(), v * 1000);
+
+	auto counts = histogram.counts();
+	EXPECT_EQ(0u, ShardedHistogram::percentile(vector<std::uint64_t>(ShardedHistogram::BucketCount), 99));
+	EXPECT_EQ(57343u, ShardedHistogram::percentile(counts, 50));
+	EXPECT_EQ(114687u, ShardedHistogram::percentile(counts, 99));
+
+	histogram.reset();
+	EXPECT_EQ(0u, ShardedHistogram::percentile(histogram.counts(), 99));
+}
+
+TEST(StatsTest, LoggerCountsAcceptedAndFiltered)
+{
+	auto log = Logger::logger("stats.logger");
+	auto op = make_shared<CountingOutputter>();
+	log->addOutputter(op);
+	log->setLevel(Level::info());
+
+	for (int i=0;i<5;++i)
+		log->log(Level::info(), "accepted");
+	log->log(Level::warn(), "accepted");
+	for (int i=0;i<3;++i)
+		log->log(Level::debug(), "filtered");
+
+	// the macros check the level before calling log()
+	SHARKLOG_DEBUG(log, "not counted");
+
+	auto stats = log->stats();
+	EXPECT_EQ(6u, stats.accepted);
+	EXPECT_EQ(5u, stats.levels[Level::INFO]);
+	EXPECT_EQ(1u, stats.levels[Level::WARN]);
+	EXPECT_EQ(0u, stats.levels[Level::DEBUG]);
+	EXPECT_EQ(3u, stats.filtered);
+	EXPECT_EQ(6u, op->stats().records);
+
+	log->resetStats();
+	EXPECT_EQ(0u, log->stats().accepted);
+	EXPECT_EQ(0u, log->stats().filtered);
+
+	Logger::closeRootLogger();
+}
+
+TEST(StatsTest, OutputterTimesOneRecordIn64)
+{
+	auto log = Logger::logger("stats.timed");
+	auto op = make_shared<CountingOutputter>();
+	log->addOutputter(op);
+
+	// a new thread so its sample count starts at 0
+	thread([&]() {
+		for (int i=0;i<128;++i)
+			log->log(Level::info(), "timed");
+	}).join();
+
+	auto stats = op->stats();
+	EXPECT_EQ(128u, stats.records);
+	EXPECT_EQ(2u, stats.timedRecords);
+	EXPECT_EQ(stats.timedNanos * 64, stats.writeNanos());
+
+	ASSERT_EQ(ShardedHistogram::BucketCount, stats.writeLatency.size());
+	std::uint64_t timed = 0;
+	for (auto it : stats.writeLatency)
+		timed += it;
+	EXPECT_EQ(2u, timed);
+	EXPECT_GE(stats.writeLatencyPercentile(100) * 2, stats.timedNanos);
+
+	Logger::closeRootLogger();
+}
+
+TEST(StatsTest, FileOutputterCountsBytes)
+{
+	const string filename = "stats-file.tmp";
+	auto op = make_shared<FileOutputter>(filename);
+	op->setLayout(make_shared<StandardLayout>());
+	ASSERT_TRUE(op->open());
+
+	auto log = Logger::logger("stats.file");
+	log->addOutputter(op);
+	for (int i=0;i<100;++i)
+		log->log(Level::info(), "a file record");
+	op->close();
+
+	auto stats = op->stats();
+	EXPECT_EQ(100u, stats.records);
+	EXPECT_EQ(fileSize(filename), (long long)stats.bytesFormatted);
+	EXPECT_EQ(stats.bytesFormatted, stats.bytesWritten);
+	EXPECT_EQ(0u, stats.writeErrors);
+
+	Logger::closeRootLogger();
+	remove(filename.c_str());
+}
+
+#if defined(__linux__)
+TEST(StatsTest, FailedWritesAreCounted)
+{
+	auto op = make_shared<RawFileOutputter>("/dev/full");
+	op->setLayout(make_shared<StandardLayout>());
+	op->setAppend(true);
+	if (!op->open())
+		return;
+
+	op->log(Level::info(), "stats", "nowhere to go", Location());
+	op->flush();
+
+	auto stats = op->stats();
+	EXPECT_EQ(1u, stats.records);
+	EXPECT_GT(stats.bytesFormatted, 0u);
+	EXPECT_EQ(0u, stats.bytesWritten);
+	EXPECT_EQ(1u, stats.writeErrors);
+	op->close();
+}
+#endif
+
+TEST(StatsTest, AllStatsCoversEveryLoggerAndOutputter)
+{
+	auto root = Logger::rootLogger();
+	auto b = Logger::logger("stats.b");
+	auto a = Logger::logger("stats.a");
+	auto inner = make_shared<CountingOutputter>();
+	inner->setLayout(make_shared<StandardLayout>());
+	auto async = make_shared<AsyncOutputter>(inner);
+	ASSERT_TRUE(async->open());
+	auto counting = make_shared<CountingOutputter>();
+	root->addOutputter(counting);
+	a->addOutputter(async);
+
+	a->log(Level::info(), "to a");
+	a->log(Level::info(), "to a");
+	b->log(Level::info(), "to b");
+	async->close();
+
+	auto snapshot = Logger::allStats();
+	ASSERT_EQ(4u, snapshot.loggers.size());
+	EXPECT_EQ("root", snapshot.loggers[0].name);
+	EXPECT_EQ("stats", snapshot.loggers[1].name);
+	EXPECT_EQ("stats.a", snapshot.loggers[2].name);
+	EXPECT_EQ(2u, snapshot.loggers[2].stats.accepted);
+	EXPECT_EQ("stats.b", snapshot.loggers[3].name);
+	EXPECT_EQ(1u, snapshot.loggers[3].stats.accepted);
+	EXPECT_EQ(3u, snapshot.loggerTotal.accepted);
+
+	ASSERT_EQ(3u, snapshot.outputters.size());
+	EXPECT_EQ("root#0", snapshot.outputters[0].name);
+	EXPECT_EQ(counting, snapshot.outputters[0].outputter);
+	EXPECT_EQ(3u, snapshot.outputters[0].stats.records);
+	EXPECT_EQ("stats.a#0", snapshot.outputters[1].name);
+	EXPECT_EQ(2u, snapshot.outputters[1].stats.records);
+	EXPECT_EQ("stats.a#0.async", snapshot.outputters[2].name);
+	EXPECT_EQ(2u, snapshot.outputters[2].stats.records);
+	EXPECT_EQ(7u, snapshot.outputterTotal.records);
+
+	ostringstream out;
+	snapshot.write(out);
+	EXPECT_NE(string::npos, out.str().find("stats.a#0.async"));
+	EXPECT_NE(string::npos, out.str().find("total"));
+
+	Logger::closeRootLogger();
+}
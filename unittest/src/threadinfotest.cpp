@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2017, by Ambershark, LLC.
+//
+// Distributed under the L-GPL license.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this program.  If not see
+// <http://www.gnu.org/licenses>.
+//
+// This notice must remain in the source code and any derived source.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <gtest/gtest.h>
+#include "threadinfo.h"
+#include "recordcontext.h"
+#include "standardlayout.h"
+#include "patternlayout.h"
+#include "asyncoutputter.h"
+#include "binaryfileoutputter.h"
+#include "binarylogreader.h"
+#include "loggertest.h"
+#include "logger.h"
+#include <sstream>
+#include <thread>
+#include <cstdio>
+
+#if defined(__linux__)
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
+using namespace sharklog;
+using namespace std;
+
+namespace
+{
+	string streamedId(std::thread::id id)
+	{
+		ostringstream ss;
+		ss << "0x" << hex << id;
+		return ss.str();
+	}
+
+	string format(Layout &layout, const RecordContext &ctx)
+	{
+		string result;
+		RecordContext::Scope pin(ctx);
+		layout.formatRecord(result, Level::info(), "thread", "message", Location());
+		return result;
+	}
+}
+
+TEST(ThreadInfoTest, CurrentDescribesTheCallingThread)
+{
+	auto &info = ThreadInfo::current();
+	EXPECT_EQ(this_thread::get_id(), info.id());
+	EXPECT_EQ(streamedId(info.id()), string(info.idText(), info.idSize()));
+	EXPECT_EQ(&info, &ThreadInfo::current());
+#if defined(__linux__)
+	EXPECT_EQ((long)syscall(SYS_gettid), info.systemId());
+#endif
+
+	const ThreadInfo *other = nullptr;
+	long otherSystemId = 0;
+	thread([&]() {
+		other = &ThreadInfo::current();
+		otherSystemId = other->systemId();
+	}).join();
+	EXPECT_NE(&info, other);
+	ASSERT_NE(info.systemId(), otherSystemId);
+}
+
+TEST(ThreadInfoTest, ThreadsAreUnnamedByDefault)
+{
+	thread([]() {
+		EXPECT_EQ("", threadName());
+		EXPECT_EQ(nullptr, ThreadInfo::current().name());
+		EXPECT_EQ(nullptr, RecordContext().threadName());
+	}).join();
+}
+
+TEST(ThreadInfoTest, SetThreadNameNamesTheCallingThreadOnly)
+{
+	thread([]() {
+		setThreadName("io-worker-3");
+		EXPECT_EQ("io-worker-3", threadName());
+		thread([]() {
+			EXPECT_EQ("", threadName());
+		}).join();
+
+		setThreadName("");
+		EXPECT_EQ("", threadName());
+	}).join();
+	ASSERT_EQ("", threadName());
+}
+
+TEST(ThreadInfoTest, ContextsCaptureTheThread)
+{
+	thread([]() {
+		RecordContext unnamed;
+		EXPECT_EQ(ThreadInfo::current().systemId(), unnamed.systemThreadId());
+		EXPECT_EQ(nullptr, unnamed.threadName());
+
+		setThreadName("first");
+		RecordContext named;
+		setThreadName("second");
+		ASSERT_NE(nullptr, named.threadName());
+		EXPECT_EQ("first", *named.threadName());
+		EXPECT_EQ("second", *RecordContext().threadName());
+	}).join();
+}
+
+TEST(ThreadInfoTest, LayoutsPrintTheName)
+{
+	StandardLayout standard;
+	PatternLayout pattern("%t|%T|%m");
+	thread([&]() {
+		auto id = streamedId(this_thread::get_id());
+		auto systemId = to_string(ThreadInfo::current().systemId());
+		RecordContext unnamed;
+		EXPECT_NE(string::npos, format(standard, unnamed).find("[" + id + "]"));
+		EXPECT_EQ(id + "|" + systemId + "|message", format(pattern, unnamed));
+
+		setThreadName("io-worker-3");
+		RecordContext named;
+		EXPECT_NE(string::npos, format(standard, named).find("[io-worker-3]"));
+		EXPECT_EQ("io-worker-3|" + systemId + "|message", format(pattern, named));
+	}).join();
+}
+
+TEST(ThreadInfoTest, OtherThreadsRecordsKeepTheirId)
+{
+	// formatted on another thread, like AsyncOutputter does
+	PatternLayout pattern("%t %T");
+	RecordContext ctx;
+	string result;
+	thread([&]() {
+		result = format(pattern, ctx);
+	}).join();
+	ASSERT_EQ(streamedId(this_thread::get_id()) + " " + to_string(ThreadInfo::current().systemId()), result);
+
+	RecordContext foreign(RecordContext::Clock::now(), this_thread::get_id());
+	EXPECT_EQ(0, foreign.systemThreadId());
+	ASSERT_EQ(streamedId(this_thread::get_id()) + " 0", format(pattern, foreign));
+}
+
+TEST(ThreadInfoTest, AsyncRecordsKeepTheNameTheyWereLoggedWith)
+{
+	auto sop = make_shared<StringOutputter>();
+	sop->setLayout(make_shared<PatternLayout>("%t %m"));
+	auto aop = make_shared<AsyncOutputter>(sop);
+	auto log = Logger::logger("threadinfo.async");
+	log->addOutputter(aop);
+
+	thread([&]() {
+		setThreadName("async-worker");
+		SHARKLOG_INFO(log, "named");
+		setThreadName("renamed");
+	}).join();
+	aop->close();
+	Logger::closeRootLogger();
+	ASSERT_EQ("async-worker named", sop->output_);
+}
+
+TEST(ThreadInfoTest, BinaryFilesKeepTheName)
+{
+	const string filename = "test-threadinfo-55102.tmp";
+	auto bop = make_shared<BinaryFileOutputter>(filename);
+	ASSERT_TRUE(bop->open());
+	auto log = Logger::logger("threadinfo.binary");
+	log->addOutputter(bop);
+
+	thread([&]() {
+		SHARKLOG_INFO(log, "unnamed");
+		setThreadName("binary-worker");
+		SHARKLOG_INFO(log, "named");
+		SHARKLOG_INFO(log, "still named");
+	}).join();
+	bop->close();
+	Logger::closeRootLogger();
+
+	BinaryLogReader reader(filename);
+	BinaryLogReader::Record rec;
+	ASSERT_TRUE(reader.open());
+	ASSERT_TRUE(reader.next(rec));
+	EXPECT_EQ(0, string(rec.context.threadLabel()).find("0x"));
+	ASSERT_TRUE(reader.next(rec));
+	EXPECT_STREQ("binary-worker", rec.context.threadLabel());
+	ASSERT_TRUE(reader.next(rec));
+	EXPECT_STREQ("binary-worker", rec.context.threadLabel());
+	EXPECT_FALSE(reader.next(rec));
+	remove(filename.c_str());
+}